@@ -0,0 +1,52 @@
+#include "AliasTable.h"
+#include <cmath>
+
+bool AliasTable::build(const std::vector<double>& weights) {
+    threshold.clear();
+    alias.clear();
+
+    double total = 0.0;
+    for (double weight : weights) {
+        if (!std::isfinite(weight) || weight < 0.0) {
+            return false;
+        }
+        total += weight;
+    }
+    if (weights.empty() || !(total > 0.0) || !std::isfinite(total)) {
+        return false;
+    }
+
+    const int count = static_cast<int>(weights.size());
+    const double fullScale = 4294967296.0;  // 2^32
+    std::vector<double> scaled(count);
+    std::vector<int> small;
+    std::vector<int> large;
+    for (int i = 0; i < count; i++) {
+        scaled[i] = weights[i] * count / total;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    threshold.assign(count, static_cast<std::uint64_t>(fullScale));
+    alias.resize(count);
+    for (int i = 0; i < count; i++) {
+        alias[i] = i;
+    }
+
+    // Pair each under-full column with an over-full one that tops it up
+    while (!small.empty() && !large.empty()) {
+        int low = small.back();
+        small.pop_back();
+        int high = large.back();
+
+        threshold[low] = static_cast<std::uint64_t>(scaled[low] * fullScale);
+        alias[low] = high;
+
+        scaled[high] -= 1.0 - scaled[low];
+        if (scaled[high] < 1.0) {
+            large.pop_back();
+            small.push_back(high);
+        }
+    }
+    // Whatever is left is full up to rounding error
+    return true;
+}
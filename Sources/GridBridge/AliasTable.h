@@ -0,0 +1,36 @@
+#ifndef ALIAS_TABLE_H
+#define ALIAS_TABLE_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "PortableRandom.h"
+
+// Walker/Vose alias table: after an O(n) build, draws an index with
+// probability proportional to its weight in O(1) and without allocating.
+class AliasTable {
+public:
+    AliasTable() = default;
+
+    // Builds the table; returns false (leaving it empty) if the weights are
+    // empty, negative, non-finite or sum to zero
+    bool build(const std::vector<double>& weights);
+
+    bool empty() const { return threshold.empty(); }
+    int size() const { return static_cast<int>(threshold.size()); }
+
+    // One uniform column pick plus one 32-bit coin flip
+    template <typename Rng>
+    int sample(Rng& rng) const {
+        int column = static_cast<int>(uniformBelow(rng, static_cast<std::uint32_t>(size())));
+        std::uint64_t coin = static_cast<std::uint32_t>(rng());
+        return coin < threshold[column] ? column : alias[column];
+    }
+
+private:
+    // Chance of keeping the column, scaled to [0, 2^32]
+    std::vector<std::uint64_t> threshold;
+    std::vector<int> alias;
+};
+
+#endif // ALIAS_TABLE_H
@@ -0,0 +1,167 @@
+#include "AllEntriesSolver.h"
+#include "DirectionMaps.h"
+
+namespace {
+    // Direction the ball travels in after entering at an edge cell
+    template <typename Cells>
+    Direction inwardDirection(const BasicGrid<Cells>& grid, CellIndex entry) {
+        if (grid.rowOf(entry) == 0) return Direction::Down;
+        if (grid.rowOf(entry) == grid.side() - 1) return Direction::Up;
+        if (grid.colOf(entry) == 0) return Direction::Right;
+        return Direction::Left;
+    }
+}
+
+// Plain walk from a state with every ActivatedBumper off to the exit, used
+// for the whole rest of any walk that reaches a bumper, since the memo cannot
+// be trusted past one. Between switch-ons the board is fixed and has
+// 4 * cells states, so a walk that takes that many steps without switching a
+// bumper on is in a loop; each switch-on grants the budget again.
+template <typename Cells>
+EntryExit AllEntriesSolver::simulateFrom(const BasicGrid<Cells>& grid, CellIndex pos, Direction direction) {
+    const int stepDelta[4] = {-grid.side(), grid.side(), -1, 1};
+    const long long sweep = 4LL * static_cast<long long>(grid.gridCells.size());
+    long long stepBudget = sweep;
+
+    EntryExit result{pos, INVALID_CELL, 0};
+    while (stepBudget-- > 0) {
+        CellIndex nextPos = pos + stepDelta[static_cast<int>(direction)];
+        const GridCell& cell = grid.gridCells[nextPos];
+        result.steps++;
+
+        if (isBorderCell(cell.type)) {
+            result.exit = nextPos;
+            break;
+        }
+
+        if (cell.type == GridCellType::ActivatedBumper && !activated[nextPos]) {
+            activated[nextPos] = 1;
+            activatedCells.push_back(nextPos);
+            stepBudget += sweep;
+        } else if (isObjectCell(cell.type)) {
+            direction = DirectionMaps::transition(cell.type, cell.orientation, direction);
+        }
+        pos = partner[nextPos];
+    }
+
+    for (CellIndex cell : activatedCells) {
+        activated[cell] = 0;
+    }
+    activatedCells.clear();
+    if (result.exit == INVALID_CELL) {
+        result.steps = 0;
+    }
+    return result;
+}
+
+template <typename Cells>
+const std::vector<EntryExit>& AllEntriesSolver::solve(const BasicGrid<Cells>& grid) {
+    const int size = grid.side();
+    const int stepDelta[4] = {-size, size, -1, 1};
+    const std::size_t cellCount = grid.gridCells.size();
+    results.clear();
+    if (cellCount > UINT32_MAX / 4) {
+        return results;
+    }
+
+    memoExit.assign(cellCount * 4, UNSOLVED);
+    memoSteps.assign(cellCount * 4, 0);
+    activated.assign(cellCount, 0);
+    activatedCells.clear();
+
+    partner.resize(cellCount);
+    for (CellIndex pos = 0; pos < cellCount; pos++) {
+        partner[pos] = pos;
+    }
+    for (const TeleporterPair& pair : grid.teleporterPairs) {
+        partner[pair.first] = pair.second;
+        partner[pair.second] = pair.first;
+    }
+
+    for (CellIndex entry = 0; entry < cellCount; entry++) {
+        int row = grid.rowOf(entry);
+        int col = grid.colOf(entry);
+        bool onEdge = row == 0 || row == size - 1 || col == 0 || col == size - 1;
+        bool isCorner = (row == 0 || row == size - 1) && (col == 0 || col == size - 1);
+        if (!onEdge || isCorner) {
+            continue;
+        }
+
+        // Follow unsolved states until one whose outcome is known
+        stack.clear();
+        std::uint32_t state = entry * 4 + static_cast<std::uint32_t>(inwardDirection(grid, entry));
+        CellIndex exit = INVALID_CELL;
+        std::uint32_t steps = 0;
+        bool simulateRest = false;
+
+        while (true) {
+            CellIndex known = memoExit[state];
+            if (known == NEEDS_SIMULATION) {
+                simulateRest = true;
+                break;
+            }
+            if (known == ON_STACK) {
+                exit = INVALID_CELL;  // The walk closed a loop without activations
+                break;
+            }
+            if (known != UNSOLVED) {
+                exit = known;
+                steps = memoSteps[state];
+                break;
+            }
+
+            memoExit[state] = ON_STACK;
+            stack.push_back(state);
+
+            CellIndex pos = state / 4;
+            Direction direction = static_cast<Direction>(state % 4);
+            CellIndex nextPos = pos + stepDelta[static_cast<int>(direction)];
+            const GridCell& cell = grid.gridCells[nextPos];
+
+            if (isBorderCell(cell.type)) {
+                exit = nextPos;
+                steps = 0;
+                break;
+            }
+            if (cell.type == GridCellType::ActivatedBumper) {
+                simulateRest = true;
+                stack.pop_back();
+                memoExit[state] = NEEDS_SIMULATION;
+                break;
+            }
+            if (isObjectCell(cell.type)) {
+                direction = DirectionMaps::transition(cell.type, cell.orientation, direction);
+            }
+            state = partner[nextPos] * 4 + static_cast<std::uint32_t>(direction);
+        }
+
+        if (simulateRest) {
+            // Every state on this walk leads to an ActivatedBumper
+            EntryExit rest = simulateFrom(grid, state / 4, static_cast<Direction>(state % 4));
+            for (std::uint32_t visited : stack) {
+                memoExit[visited] = NEEDS_SIMULATION;
+            }
+            exit = rest.exit;
+            steps = rest.exit == INVALID_CELL ? 0 : rest.steps + static_cast<std::uint32_t>(stack.size());
+        } else {
+            // Each state's outcome is one more step than its successor's
+            std::uint32_t remaining = steps;
+            for (std::size_t i = stack.size(); i-- > 0;) {
+                remaining = exit == INVALID_CELL ? 0 : remaining + 1;
+                memoExit[stack[i]] = exit;
+                memoSteps[stack[i]] = remaining;
+            }
+            steps = remaining;
+        }
+
+        results.push_back({entry, exit, exit == INVALID_CELL ? 0 : steps});
+    }
+    return results;
+}
+
+template const std::vector<EntryExit>& AllEntriesSolver::solve(const Grid&);
+template const std::vector<EntryExit>& AllEntriesSolver::solve(const SparseGrid&);
+template const std::vector<EntryExit>& AllEntriesSolver::solve(const GridN<5>&);
+template const std::vector<EntryExit>& AllEntriesSolver::solve(const GridN<6>&);
+template const std::vector<EntryExit>& AllEntriesSolver::solve(const GridN<7>&);
+template const std::vector<EntryExit>& AllEntriesSolver::solve(const GridN<10>&);
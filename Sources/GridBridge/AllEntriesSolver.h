@@ -0,0 +1,45 @@
+#ifndef ALL_ENTRIES_SOLVER_H
+#define ALL_ENTRIES_SOLVER_H
+
+#include <cstdint>
+#include <vector>
+#include "Grid.h"
+
+// Exit of every edge entry in one pass. Each (cell, direction) state is
+// resolved at most once and its exit and remaining step count are shared by
+// every later walk that reaches it, so the whole solve is linear in the number
+// of states. ActivatedBumpers make a walk depend on its own history: states
+// whose continuation reaches one are only marked, and walks arriving there
+// simulate everything from that state to the exit directly, with the bumpers
+// switched off, rather than just the stretch through the bumper.
+//
+// Any engine can be solved, but the memo has four states per cell whatever
+// the storage, so a sparse board costs what a dense one of its side does.
+class AllEntriesSolver {
+public:
+    // One result per edge cell, corners excluded, in row-major order; none
+    // for a board of more states than a 32-bit state holds, past side
+    // 32767. The reference stays valid until the next call.
+    template <typename Cells>
+    const std::vector<EntryExit>& solve(const BasicGrid<Cells>& grid);
+
+private:
+    // State = cell * 4 + direction; memoExit holds one of these before the
+    // exit is known
+    static constexpr CellIndex UNSOLVED = INVALID_CELL - 1;
+    static constexpr CellIndex ON_STACK = INVALID_CELL - 2;
+    static constexpr CellIndex NEEDS_SIMULATION = INVALID_CELL - 3;
+
+    std::vector<CellIndex> memoExit;
+    std::vector<std::uint32_t> memoSteps;
+    std::vector<CellIndex> partner;
+    std::vector<std::uint8_t> activated;
+    std::vector<CellIndex> activatedCells;
+    std::vector<std::uint32_t> stack;
+    std::vector<EntryExit> results;
+
+    template <typename Cells>
+    EntryExit simulateFrom(const BasicGrid<Cells>& grid, CellIndex pos, Direction direction);
+};
+
+#endif // ALL_ENTRIES_SOLVER_H
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include "BatchSimulator.h"
+#include "CpuFeatures.h"
+#include "DirectionMaps.h"
+
+namespace {
+    // A cell word: bits 3d..3d+2 hold the direction the ball leaves in when
+    // it enters moving in direction d, and the flags below mark the cells
+    // that need more than that
+    constexpr std::int32_t BORDER_BIT = 1 << 12;
+    constexpr std::int32_t TELEPORTER_BIT = 1 << 13;
+    constexpr std::int32_t ACTIVATES_BIT = 1 << 14;
+    constexpr std::int32_t DOWN_RIGHT_BIT = 1 << 15;
+
+    constexpr std::int32_t transitionWord(GridCellType type, Orientation orientation) {
+        std::int32_t word = 0;
+        for (int d = 0; d < 4; d++) {
+            word |= static_cast<std::int32_t>(
+                DirectionMaps::transition(type, orientation, static_cast<Direction>(d))) << (3 * d);
+        }
+        return word;
+    }
+
+    constexpr std::int32_t PASS_WORD = transitionWord(GridCellType::Empty, Orientation::None);
+    constexpr std::int32_t UP_RIGHT_ACTIVE_WORD = transitionWord(GridCellType::ActivatedBumper, Orientation::UpRight);
+    constexpr std::int32_t DOWN_RIGHT_ACTIVE_WORD = transitionWord(GridCellType::ActivatedBumper, Orientation::DownRight);
+
+    std::int32_t cellWord(const GridCell& cell) {
+        if (isBorderCell(cell.type)) {
+            return BORDER_BIT;
+        }
+        switch (cell.type) {
+            case GridCellType::Teleporter:
+                return PASS_WORD | TELEPORTER_BIT;
+            case GridCellType::ActivatedBumper:
+                // Passes the ball once, then deflects like a Bumper
+                return PASS_WORD | ACTIVATES_BIT
+                     | (cell.orientation == Orientation::DownRight ? DOWN_RIGHT_BIT : 0);
+            default:
+                return transitionWord(cell.type, cell.orientation);
+        }
+    }
+
+    Direction startingDirection(CellIndex entry, int gridSize) {
+        const int row = static_cast<int>(entry) / gridSize;
+        const int col = static_cast<int>(entry) % gridSize;
+        return row == 0 ? Direction::Down
+             : row == gridSize - 1 ? Direction::Up
+             : col == 0 ? Direction::Right
+             : Direction::Left;
+    }
+}
+
+GridStatus BatchSimulator::build(const std::vector<const Grid*>& grids) {
+    results.clear();
+    words.clear();
+    partners.clear();
+    activatedWords.clear();
+    if (grids.empty()) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+
+    gridSize = grids.front()->gridSize;
+    cellCount = static_cast<std::uint32_t>(grids.front()->gridCells.size());
+    // Gathers index a group with signed 32-bit offsets
+    if (gridSize < 3 || static_cast<std::uint64_t>(cellCount) * LANES > INT32_MAX) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+    for (const Grid* grid : grids) {
+        if (grid->gridSize != gridSize || grid->gridCells.size() != cellCount) {
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+    }
+
+    groupCount = static_cast<int>((grids.size() + LANES - 1) / LANES);
+    words.assign(static_cast<std::size_t>(groupCount) * cellCount * LANES, BORDER_BIT);
+    partners.assign(words.size(), 0);
+    results.resize(grids.size());
+
+    for (std::size_t board = 0; board < grids.size(); board++) {
+        const Grid& grid = *grids[board];
+        const std::size_t group = board / LANES;
+        const std::size_t lane = board % LANES;
+        const std::size_t base = group * cellCount * LANES + lane;
+        for (CellIndex pos = 0; pos < cellCount; pos++) {
+            words[base + static_cast<std::size_t>(pos) * LANES] = cellWord(grid.gridCells[pos]);
+            partners[base + static_cast<std::size_t>(pos) * LANES] = static_cast<std::int32_t>(pos);
+        }
+        for (const TeleporterPair& pair : grid.teleporterPairs) {
+            partners[base + static_cast<std::size_t>(pair.first) * LANES] = static_cast<std::int32_t>(pair.second);
+            partners[base + static_cast<std::size_t>(pair.second) * LANES] = static_cast<std::int32_t>(pair.first);
+        }
+        results[board] = {grid.entryPos, INVALID_CELL, 0};
+    }
+    return GRID_STATUS_OK;
+}
+
+void BatchSimulator::activate(std::size_t word) {
+    words[word] = (words[word] & DOWN_RIGHT_BIT) ? DOWN_RIGHT_ACTIVE_WORD | DOWN_RIGHT_BIT : UP_RIGHT_ACTIVE_WORD;
+    activatedWords.push_back(word);
+}
+
+void BatchSimulator::restoreActivated() {
+    for (std::size_t word : activatedWords) {
+        words[word] = PASS_WORD | ACTIVATES_BIT | (words[word] & DOWN_RIGHT_BIT);
+    }
+    activatedWords.clear();
+}
+
+const std::vector<EntryExit>& BatchSimulator::simulate() {
+    const bool vector = hasAvx2();
+    for (int group = 0; group < groupCount; group++) {
+        if (vector) {
+            simulateGroupAvx2(group);
+        } else {
+            simulateGroupScalar(group);
+        }
+        restoreActivated();
+    }
+    return results;
+}
+
+const std::vector<EntryExit>& BatchSimulator::simulateScalar() {
+    for (int group = 0; group < groupCount; group++) {
+        simulateGroupScalar(group);
+        restoreActivated();
+    }
+    return results;
+}
+
+// Without activations the state (cell, direction) cannot repeat on a walk
+// that leaves, so a walk that goes 4 * cellCount + 1 steps past its last
+// activation never will
+void BatchSimulator::simulateGroupScalar(int group) {
+    const std::int32_t deltas[4] = {-gridSize, gridSize, -1, 1};
+    const std::uint32_t limit = 4 * cellCount + 1;
+    const std::size_t base = static_cast<std::size_t>(group) * cellCount * LANES;
+
+    for (int lane = 0; lane < LANES; lane++) {
+        const std::size_t board = static_cast<std::size_t>(group) * LANES + lane;
+        if (board >= results.size()) {
+            break;
+        }
+        EntryExit& result = results[board];
+        std::int32_t pos = static_cast<std::int32_t>(result.entry);
+        std::int32_t direction = static_cast<std::int32_t>(startingDirection(result.entry, gridSize));
+        std::uint32_t steps = 0;
+        std::uint32_t sinceChange = 0;
+
+        result.exit = INVALID_CELL;
+        result.steps = 0;
+        while (sinceChange <= limit) {
+            pos += deltas[direction];
+            steps++;
+            sinceChange++;
+            const std::size_t word = base + static_cast<std::size_t>(pos) * LANES + lane;
+            const std::int32_t cell = words[word];
+            if (cell & BORDER_BIT) {
+                result.exit = static_cast<CellIndex>(pos);
+                result.steps = steps;
+                break;
+            }
+            direction = (cell >> (3 * direction)) & 7;
+            if (cell & TELEPORTER_BIT) {
+                pos = partners[word];
+            } else if (cell & ACTIVATES_BIT) {
+                activate(word);
+                sinceChange = 0;
+            }
+        }
+    }
+}
+
+bool BatchSimulator::hasAvx2() {
+    return cpuHasAvx2();
+}
+
+#if GRID_X86_SIMD
+GRID_TARGET_AVX2
+void BatchSimulator::simulateGroupAvx2(int group) {
+    const std::size_t base = static_cast<std::size_t>(group) * cellCount * LANES;
+    const int* cells = words.data() + base;
+    const int* partnerCells = partners.data() + base;
+    const int boards = static_cast<int>(std::min<std::size_t>(LANES, results.size() - group * LANES));
+
+    alignas(32) std::int32_t lanePos[LANES] = {};
+    alignas(32) std::int32_t laneDirection[LANES] = {};
+    for (int lane = 0; lane < boards; lane++) {
+        const CellIndex entry = results[group * LANES + lane].entry;
+        lanePos[lane] = static_cast<std::int32_t>(entry);
+        laneDirection[lane] = static_cast<std::int32_t>(startingDirection(entry, gridSize));
+    }
+
+    const __m256i laneIds = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i deltas = _mm256_setr_epi32(-gridSize, gridSize, -1, 1, 0, 0, 0, 0);
+    const __m256i directionMask = _mm256_set1_epi32(7);
+    const __m256i borderBit = _mm256_set1_epi32(BORDER_BIT);
+    const __m256i teleporterBit = _mm256_set1_epi32(TELEPORTER_BIT);
+    const __m256i activatesBit = _mm256_set1_epi32(ACTIVATES_BIT);
+    const __m256i limit = _mm256_set1_epi32(static_cast<int>(4 * cellCount + 1));
+    const __m256i invalid = _mm256_set1_epi32(-1);
+
+    __m256i pos = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanePos));
+    __m256i direction = _mm256_load_si256(reinterpret_cast<const __m256i*>(laneDirection));
+    __m256i active = _mm256_cmpgt_epi32(_mm256_set1_epi32(boards), laneIds);
+    __m256i steps = _mm256_setzero_si256();
+    __m256i sinceChange = _mm256_setzero_si256();
+    __m256i exits = invalid;
+
+    while (!_mm256_testz_si256(active, active)) {
+        // Step every live ball; active lanes are all ones, so subtracting
+        // them counts the step
+        pos = _mm256_add_epi32(pos, _mm256_and_si256(_mm256_permutevar8x32_epi32(deltas, direction), active));
+        steps = _mm256_sub_epi32(steps, active);
+        sinceChange = _mm256_sub_epi32(sinceChange, active);
+        const __m256i index = _mm256_add_epi32(_mm256_slli_epi32(pos, 3), laneIds);
+        const __m256i cell = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), cells, index, active, 4);
+
+        const __m256i exited = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(cell, borderBit), borderBit), active);
+        exits = _mm256_blendv_epi8(exits, pos, exited);
+        active = _mm256_andnot_si256(exited, active);
+
+        const __m256i shift = _mm256_add_epi32(direction, _mm256_add_epi32(direction, direction));
+        direction = _mm256_and_si256(_mm256_srlv_epi32(cell, shift), directionMask);
+
+        const __m256i teleports = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(cell, teleporterBit), teleporterBit), active);
+        if (!_mm256_testz_si256(teleports, teleports)) {
+            pos = _mm256_mask_i32gather_epi32(pos, partnerCells, index, teleports, 4);
+        }
+
+        // Switching on an ActivatedBumper rewrites its word, one lane at a time
+        const __m256i activates = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(cell, activatesBit), activatesBit), active);
+        int activating = _mm256_movemask_ps(_mm256_castsi256_ps(activates));
+        if (activating != 0) {
+            alignas(32) std::int32_t laneIndex[LANES];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(laneIndex), index);
+            for (int lane = 0; lane < LANES; lane++) {
+                if (activating & (1 << lane)) {
+                    activate(base + static_cast<std::size_t>(laneIndex[lane]));
+                }
+            }
+            sinceChange = _mm256_andnot_si256(activates, sinceChange);
+        }
+
+        const __m256i looping = _mm256_and_si256(_mm256_cmpgt_epi32(sinceChange, limit), active);
+        if (!_mm256_testz_si256(looping, looping)) {
+            steps = _mm256_andnot_si256(looping, steps);
+            active = _mm256_andnot_si256(looping, active);
+        }
+    }
+
+    alignas(32) std::int32_t laneExit[LANES];
+    alignas(32) std::int32_t laneSteps[LANES];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneExit), exits);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneSteps), steps);
+    for (int lane = 0; lane < boards; lane++) {
+        EntryExit& result = results[group * LANES + lane];
+        result.exit = static_cast<CellIndex>(laneExit[lane]);
+        result.steps = result.exit == INVALID_CELL ? 0 : static_cast<std::uint32_t>(laneSteps[lane]);
+    }
+}
+#else
+void BatchSimulator::simulateGroupAvx2(int group) {
+    simulateGroupScalar(group);
+}
+#endif
@@ -0,0 +1,55 @@
+#ifndef BATCH_SIMULATOR_H
+#define BATCH_SIMULATOR_H
+
+#include <cstdint>
+#include <vector>
+#include "Grid.h"
+#include "GridStatus.h"
+
+// Walks the balls of many same-size boards in lockstep. Boards are packed in
+// groups of LANES, cell-major, so one step of every ball in a group is a
+// gather of LANES cell words; each word carries the outgoing direction for
+// all four incoming ones, built from DirectionMaps. On CPUs with AVX2 a
+// group is stepped in one vector; elsewhere each lane is walked on its own.
+// Exits and step counts match Grid::simulate.
+class BatchSimulator {
+public:
+    static constexpr int LANES = 8;
+
+    // Copies the boards, which must all share one side. Returns
+    // GRID_STATUS_INVALID_ARGUMENT for an empty batch, mixed sides or boards
+    // too large to index in 32 bits.
+    GridStatus build(const std::vector<const Grid*>& grids);
+
+    // Walks every board from its entry with every ActivatedBumper off. One
+    // result per board, in build order; a ball that never leaves gets
+    // INVALID_CELL and 0 steps.
+    const std::vector<EntryExit>& simulate();
+
+    // The per-lane walk, whatever the CPU supports
+    const std::vector<EntryExit>& simulateScalar();
+
+    static bool hasAvx2();
+
+    int boardCount() const { return static_cast<int>(results.size()); }
+
+private:
+    int gridSize = 0;
+    std::uint32_t cellCount = 0;
+    int groupCount = 0;
+    // words[(group * cellCount + pos) * LANES + lane]; partners likewise, the
+    // linked teleporter for a teleporter cell
+    std::vector<std::int32_t> words;
+    std::vector<std::int32_t> partners;
+    // Words of the ActivatedBumpers a walk switched on, restored after it
+    std::vector<std::size_t> activatedWords;
+    std::vector<EntryExit> results;
+
+    void activate(std::size_t word);
+    void restoreActivated();
+
+    void simulateGroupScalar(int group);
+    void simulateGroupAvx2(int group);
+};
+
+#endif // BATCH_SIMULATOR_H
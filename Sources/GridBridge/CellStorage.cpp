@@ -0,0 +1,99 @@
+#include "CellStorage.h"
+
+namespace {
+    const GridCell EMPTY_CELL{};
+    const GridCell BORDER_CELL{GridCellType::Border};
+
+    bool sameCell(const GridCell& a, const GridCell& b) {
+        return a.type == b.type && a.direction == b.direction && a.orientation == b.orientation
+            && a.hasBeenActivated == b.hasBeenActivated && a.seenDirections == b.seenDirections
+            && a.teleporterIndex == b.teleporterIndex && a.firstVisit == b.firstVisit;
+    }
+}
+
+void DenseCells::erase(CellIndex pos) {
+    cells[pos] = isRingCell(pos, gridSize) ? BORDER_CELL : EMPTY_CELL;
+}
+
+void SparseCells::reset(int size) {
+    gridSize = size;
+    cellCount = static_cast<std::size_t>(size) * size;
+    count = 0;
+    bits = 6;
+    keys.assign(std::size_t{1} << bits, EMPTY_KEY);
+    values.assign(std::size_t{1} << bits, GridCell{});
+}
+
+const GridCell& SparseCells::defaultCell(CellIndex pos) const {
+    return isRingCell(pos, gridSize) ? BORDER_CELL : EMPTY_CELL;
+}
+
+GridCell& SparseCells::edit(CellIndex pos) {
+    std::size_t slot = find(pos);
+    if (slot != NO_SLOT) {
+        return values[slot];
+    }
+
+    // Keep the load factor under 3/4 so probe runs stay short
+    if ((count + 1) * 4 > keys.size() * 3) {
+        rehash(bits + 1);
+    }
+    const std::size_t mask = keys.size() - 1;
+    for (slot = home(pos); keys[slot] != EMPTY_KEY; slot = (slot + 1) & mask) {
+    }
+    keys[slot] = pos;
+    values[slot] = defaultCell(pos);
+    count++;
+    return values[slot];
+}
+
+void SparseCells::erase(CellIndex pos) {
+    std::size_t hole = find(pos);
+    if (hole == NO_SLOT) {
+        return;
+    }
+
+    // Shift later members of the probe run back so lookups never need
+    // tombstones
+    const std::size_t mask = keys.size() - 1;
+    for (std::size_t slot = (hole + 1) & mask; keys[slot] != EMPTY_KEY; slot = (slot + 1) & mask) {
+        std::size_t wanted = home(keys[slot]);
+        bool canMove = hole <= slot ? (wanted <= hole || wanted > slot) : (wanted <= hole && wanted > slot);
+        if (canMove) {
+            keys[hole] = keys[slot];
+            values[hole] = values[slot];
+            hole = slot;
+        }
+    }
+    keys[hole] = EMPTY_KEY;
+    count--;
+}
+
+void SparseCells::release(CellIndex pos) {
+    std::size_t slot = find(pos);
+    if (slot != NO_SLOT && sameCell(values[slot], defaultCell(pos))) {
+        erase(pos);
+    }
+}
+
+void SparseCells::rehash(unsigned newBits) {
+    std::vector<CellIndex> oldKeys = std::move(keys);
+    std::vector<GridCell> oldValues = std::move(values);
+
+    bits = newBits;
+    keys.assign(std::size_t{1} << bits, EMPTY_KEY);
+    values.assign(std::size_t{1} << bits, GridCell{});
+
+    const std::size_t mask = keys.size() - 1;
+    for (std::size_t i = 0; i < oldKeys.size(); i++) {
+        if (oldKeys[i] == EMPTY_KEY) {
+            continue;
+        }
+        std::size_t slot = home(oldKeys[i]);
+        while (keys[slot] != EMPTY_KEY) {
+            slot = (slot + 1) & mask;
+        }
+        keys[slot] = oldKeys[i];
+        values[slot] = oldValues[i];
+    }
+}
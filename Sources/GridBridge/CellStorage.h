@@ -0,0 +1,205 @@
+#ifndef CELL_STORAGE_H
+#define CELL_STORAGE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "GridCell.h"
+
+// Linear position in the grid, row * gridSize + column. Equality is a single
+// integer compare and the index doubles as a bitmap/array slot. 32 bits so
+// boards larger than 255x255 still fit.
+using CellIndex = std::uint32_t;
+
+// Returned when there is no such cell (e.g. the ball never exits)
+constexpr CellIndex INVALID_CELL = std::numeric_limits<CellIndex>::max();
+
+// Largest side whose cells all have a CellIndex below the reserved values
+constexpr int MAX_GRID_SIZE = 65535;
+
+// Largest side dense storage is allowed to allocate: 16M cells, 256 MiB.
+// MAX_GRID_SIZE would take 64 GiB, which no device has to give.
+constexpr int MAX_DENSE_GRID_SIZE = 4096;
+
+// Cell storage backends for the grid engine. Both present the same interface:
+//
+//   reset(gridSize)  Empty playfield inside a ring of Border sentinels
+//   size()           Number of cells, gridSize * gridSize
+//   operator[] const Read a cell
+//   edit(pos)        Writable cell; may invalidate references from earlier
+//                    edit() and operator[] calls
+//   erase(pos)       Back to the default cell for its position
+//   release(pos)     Hint that the cell may be back to its default
+//   storedCells()    Cells held in memory
+//   forEachStored(f) Calls f(pos, cell) for each cell held in memory, in no
+//                    set order; every cell but those at their default is
+//                    among them
+//   memoryBytes()    Bytes held for cells
+//   FIXED_SIZE       The side, if fixed at compile time, otherwise 0
+//   MAX_SIDE         Largest side reset() may be given
+//   CONTIGUOUS       True if data() returns the cells as one row-major array
+
+// True for cells of the sentinel ring of a gridSize x gridSize board
+constexpr bool isRingCell(CellIndex pos, int gridSize) {
+    const CellIndex size = static_cast<CellIndex>(gridSize);
+    const CellIndex row = pos / size;
+    const CellIndex col = pos % size;
+    return row == 0 || row == size - 1 || col == 0 || col == size - 1;
+}
+
+// One GridCell per cell in a flat row-major vector
+class DenseCells {
+public:
+    static constexpr int FIXED_SIZE = 0;
+    static constexpr int MAX_SIDE = MAX_DENSE_GRID_SIZE;
+    static constexpr bool CONTIGUOUS = true;
+
+    void reset(int size) {
+        gridSize = size;
+        cells.assign(static_cast<std::size_t>(size) * size, GridCell{});
+        for (int i = 0; i < size; i++) {
+            cells[i].type = GridCellType::Border;
+            cells[static_cast<std::size_t>(size - 1) * size + i].type = GridCellType::Border;
+            cells[static_cast<std::size_t>(i) * size].type = GridCellType::Border;
+            cells[static_cast<std::size_t>(i) * size + size - 1].type = GridCellType::Border;
+        }
+    }
+
+    std::size_t size() const { return cells.size(); }
+    const GridCell& operator[](CellIndex pos) const { return cells[pos]; }
+    GridCell& operator[](CellIndex pos) { return cells[pos]; }
+    GridCell& edit(CellIndex pos) { return cells[pos]; }
+    const GridCell* data() const { return cells.data(); }
+    void erase(CellIndex pos);
+    void release(CellIndex) {}
+
+    std::size_t storedCells() const { return cells.size(); }
+    template <typename Visit>
+    void forEachStored(Visit&& visit) const {
+        for (CellIndex pos = 0; pos < cells.size(); pos++) {
+            visit(pos, cells[pos]);
+        }
+    }
+    std::size_t memoryBytes() const { return cells.capacity() * sizeof(GridCell); }
+
+    std::vector<GridCell>::const_iterator begin() const { return cells.begin(); }
+    std::vector<GridCell>::const_iterator end() const { return cells.end(); }
+
+private:
+    int gridSize = 0;
+    std::vector<GridCell> cells;
+};
+
+// Only cells that differ from their default, in an open-addressing hash
+// table keyed by CellIndex (linear probing, backward-shift deletion). Memory
+// follows the number of objects and path cells instead of the board area;
+// each read costs a hash probe instead of an array load.
+class SparseCells {
+public:
+    static constexpr int FIXED_SIZE = 0;
+    static constexpr int MAX_SIDE = MAX_GRID_SIZE;
+    static constexpr bool CONTIGUOUS = false;
+
+    void reset(int size);
+
+    std::size_t size() const { return cellCount; }
+
+    const GridCell& operator[](CellIndex pos) const {
+        std::size_t slot = find(pos);
+        return slot != NO_SLOT ? values[slot] : defaultCell(pos);
+    }
+
+    GridCell& edit(CellIndex pos);
+    void erase(CellIndex pos);
+    void release(CellIndex pos);
+
+    std::size_t storedCells() const { return count; }
+    template <typename Visit>
+    void forEachStored(Visit&& visit) const {
+        for (std::size_t slot = 0; slot < keys.size(); slot++) {
+            if (keys[slot] != EMPTY_KEY) {
+                visit(keys[slot], values[slot]);
+            }
+        }
+    }
+    std::size_t memoryBytes() const {
+        return keys.capacity() * sizeof(CellIndex) + values.capacity() * sizeof(GridCell);
+    }
+
+private:
+    static constexpr CellIndex EMPTY_KEY = INVALID_CELL;
+    static constexpr std::size_t NO_SLOT = static_cast<std::size_t>(-1);
+
+    int gridSize = 0;
+    std::size_t cellCount = 0;
+    std::size_t count = 0;
+    unsigned bits = 0;
+    std::vector<CellIndex> keys;
+    std::vector<GridCell> values;
+
+    // Fibonacci hashing: the top bits of the product spread neighbouring
+    // cells across the table
+    std::size_t home(CellIndex pos) const {
+        return static_cast<std::uint32_t>(pos * 2654435769u) >> (32 - bits);
+    }
+
+    std::size_t find(CellIndex pos) const {
+        const std::size_t mask = keys.size() - 1;
+        for (std::size_t slot = home(pos); ; slot = (slot + 1) & mask) {
+            if (keys[slot] == pos) return slot;
+            if (keys[slot] == EMPTY_KEY) return NO_SLOT;
+        }
+    }
+
+    const GridCell& defaultCell(CellIndex pos) const;
+    void rehash(unsigned newBits);
+};
+
+// N x N cells in an inline array. With the side a compile-time constant the
+// engine's index math, step offsets and bounds fold to constants.
+template <int N>
+class FixedCells {
+public:
+    static_assert(N >= 3, "a board needs a playfield inside its border ring");
+    static constexpr int FIXED_SIZE = N;
+    static constexpr int MAX_SIDE = N;
+    static constexpr bool CONTIGUOUS = true;
+
+    // size must be N; the parameter keeps the interface shared
+    void reset(int) {
+        for (CellIndex pos = 0; pos < N * N; pos++) {
+            cells[pos] = GridCell{};
+            cells[pos].type = isRingCell(pos, N) ? GridCellType::Border : GridCellType::Empty;
+        }
+    }
+
+    constexpr std::size_t size() const { return N * N; }
+    const GridCell& operator[](CellIndex pos) const { return cells[pos]; }
+    GridCell& operator[](CellIndex pos) { return cells[pos]; }
+    GridCell& edit(CellIndex pos) { return cells[pos]; }
+    const GridCell* data() const { return cells.data(); }
+    void erase(CellIndex pos) {
+        cells[pos] = GridCell{};
+        cells[pos].type = isRingCell(pos, N) ? GridCellType::Border : GridCellType::Empty;
+    }
+    void release(CellIndex) {}
+
+    constexpr std::size_t storedCells() const { return N * N; }
+    template <typename Visit>
+    void forEachStored(Visit&& visit) const {
+        for (CellIndex pos = 0; pos < N * N; pos++) {
+            visit(pos, cells[pos]);
+        }
+    }
+    constexpr std::size_t memoryBytes() const { return sizeof(cells); }
+
+    typename std::array<GridCell, N * N>::const_iterator begin() const { return cells.begin(); }
+    typename std::array<GridCell, N * N>::const_iterator end() const { return cells.end(); }
+
+private:
+    std::array<GridCell, N * N> cells;
+};
+
+#endif // CELL_STORAGE_H
@@ -0,0 +1,24 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// Vector kernels are compiled per function with target attributes, so the
+// library still runs on any CPU of its architecture; callers pick a kernel
+// with cpuHasAvx2() at run time. GRID_X86_SIMD is 0 where there are none.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GRID_X86_SIMD 1
+#include <immintrin.h>
+#define GRID_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define GRID_X86_SIMD 0
+#endif
+
+inline bool cpuHasAvx2() {
+#if GRID_X86_SIMD
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+#endif // CPU_FEATURES_H
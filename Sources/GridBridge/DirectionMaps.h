@@ -1,35 +1,100 @@
 #ifndef DIRECTION_MAPS_H
 #define DIRECTION_MAPS_H
 
-#include <unordered_map>
+#include <cstdint>
 #include "GridCell.h"
 
 namespace DirectionMaps {
-    static const std::unordered_map<GridCellType, 
-        std::unordered_map<Orientation, 
-        std::unordered_map<Direction, Direction>>> directionMaps = {
-            {GridCellType::Bumper, {
-                {Orientation::UpRight, {{Direction::Up, Direction::Right}, {Direction::Right, Direction::Up}, {Direction::Left, Direction::Down}, {Direction::Down, Direction::Left}}},
-                {Orientation::DownRight, {{Direction::Down, Direction::Right}, {Direction::Right, Direction::Down}, {Direction::Left, Direction::Up}, {Direction::Up, Direction::Left}}}
-            }},
-            {GridCellType::ActivatedBumper, {
-                {Orientation::UpRight, {{Direction::Up, Direction::Right}, {Direction::Right, Direction::Up}, {Direction::Left, Direction::Down}, {Direction::Down, Direction::Left}}},
-                {Orientation::DownRight, {{Direction::Down, Direction::Right}, {Direction::Right, Direction::Down}, {Direction::Left, Direction::Up}, {Direction::Up, Direction::Left}}}
-            }},
-            {GridCellType::DirectionalBumper, {
-                {Orientation::TopLeft, {{Direction::Up, Direction::Right}, {Direction::Down, Direction::Down}, {Direction::Left, Direction::Down}, {Direction::Right, Direction::Right}}},
-                {Orientation::TopRight, {{Direction::Up, Direction::Left}, {Direction::Right, Direction::Down}, {Direction::Left, Direction::Left}, {Direction::Down, Direction::Down}}},
-                {Orientation::BottomLeft, {{Direction::Down, Direction::Right}, {Direction::Left, Direction::Up}, {Direction::Up, Direction::Up}, {Direction::Right, Direction::Right}}},
-                {Orientation::BottomRight, {{Direction::Down, Direction::Left}, {Direction::Right, Direction::Up}, {Direction::Left, Direction::Left}, {Direction::Up, Direction::Up}}}
-            }},
-            {GridCellType::Tunnel, {
-                {Orientation::Horizontal, {{Direction::Up, Direction::Down}, {Direction::Down, Direction::Up}, {Direction::Left, Direction::Left}, {Direction::Right, Direction::Right}}},
-                {Orientation::Vertical, {{Direction::Left, Direction::Right}, {Direction::Right, Direction::Left}, {Direction::Up, Direction::Up}, {Direction::Down, Direction::Down}}}
-            }},
-            {GridCellType::Teleporter, {
-                {Orientation::None, {{Direction::Up, Direction::Up}, {Direction::Down, Direction::Down}, {Direction::Left, Direction::Left}, {Direction::Right, Direction::Right}}}
-            }}
+    constexpr int CELL_TYPE_COUNT = 10;
+    constexpr int ORIENTATION_COUNT = 9;
+    constexpr int DIRECTION_COUNT = 5;
+
+    // next[type][orientation][direction] is the ball's direction after it
+    // enters a cell. Combinations without an entry leave the direction as is.
+    // ActivatedBumper holds its behavior once switched on.
+    struct TransitionTable {
+        std::uint8_t next[CELL_TYPE_COUNT][ORIENTATION_COUNT][DIRECTION_COUNT];
     };
+
+    constexpr TransitionTable buildTransitions() {
+        TransitionTable table{};
+        for (int t = 0; t < CELL_TYPE_COUNT; t++) {
+            for (int o = 0; o < ORIENTATION_COUNT; o++) {
+                for (int d = 0; d < DIRECTION_COUNT; d++) {
+                    table.next[t][o][d] = static_cast<std::uint8_t>(d);
+                }
+            }
+        }
+
+        struct Entry {
+            GridCellType type;
+            Orientation orientation;
+            Direction up, down, left, right;
+        };
+        constexpr Entry entries[] = {
+            {GridCellType::Bumper, Orientation::UpRight, Direction::Right, Direction::Left, Direction::Down, Direction::Up},
+            {GridCellType::Bumper, Orientation::DownRight, Direction::Left, Direction::Right, Direction::Up, Direction::Down},
+            {GridCellType::ActivatedBumper, Orientation::UpRight, Direction::Right, Direction::Left, Direction::Down, Direction::Up},
+            {GridCellType::ActivatedBumper, Orientation::DownRight, Direction::Left, Direction::Right, Direction::Up, Direction::Down},
+            {GridCellType::DirectionalBumper, Orientation::TopLeft, Direction::Right, Direction::Down, Direction::Down, Direction::Right},
+            {GridCellType::DirectionalBumper, Orientation::TopRight, Direction::Left, Direction::Down, Direction::Left, Direction::Down},
+            {GridCellType::DirectionalBumper, Orientation::BottomLeft, Direction::Up, Direction::Right, Direction::Up, Direction::Right},
+            {GridCellType::DirectionalBumper, Orientation::BottomRight, Direction::Up, Direction::Left, Direction::Left, Direction::Up},
+            {GridCellType::Tunnel, Orientation::Horizontal, Direction::Down, Direction::Up, Direction::Left, Direction::Right},
+            {GridCellType::Tunnel, Orientation::Vertical, Direction::Up, Direction::Down, Direction::Right, Direction::Left},
+        };
+        for (const Entry& entry : entries) {
+            std::uint8_t (&row)[DIRECTION_COUNT] = table.next[static_cast<int>(entry.type)][static_cast<int>(entry.orientation)];
+            row[static_cast<int>(Direction::Up)] = static_cast<std::uint8_t>(entry.up);
+            row[static_cast<int>(Direction::Down)] = static_cast<std::uint8_t>(entry.down);
+            row[static_cast<int>(Direction::Left)] = static_cast<std::uint8_t>(entry.left);
+            row[static_cast<int>(Direction::Right)] = static_cast<std::uint8_t>(entry.right);
+        }
+        return table;
+    }
+
+    // Constant-initialized and inline, so there is one copy in the binary and
+    // nothing runs at library load
+    inline constexpr TransitionTable transitions = buildTransitions();
+
+    constexpr Direction transition(GridCellType type, Orientation orientation, Direction direction) {
+        return static_cast<Direction>(
+            transitions.next[static_cast<int>(type)][static_cast<int>(orientation)][static_cast<int>(direction)]);
+    }
+
+    constexpr Direction reverse(Direction direction) {
+        return direction == Direction::Up    ? Direction::Down
+             : direction == Direction::Down  ? Direction::Up
+             : direction == Direction::Left  ? Direction::Right
+             : direction == Direction::Right ? Direction::Left
+             : Direction::None;
+    }
+
+    // The table run backwards: from[type][orientation][direction] has bit d
+    // set for each direction d the ball can enter a cell in to leave it in
+    // direction
+    struct ArrivalTable {
+        std::uint8_t from[CELL_TYPE_COUNT][ORIENTATION_COUNT][DIRECTION_COUNT];
+    };
+
+    constexpr ArrivalTable buildArrivals() {
+        ArrivalTable table{};
+        for (int t = 0; t < CELL_TYPE_COUNT; t++) {
+            for (int o = 0; o < ORIENTATION_COUNT; o++) {
+                for (int d = 0; d < 4; d++) {
+                    const int out = transitions.next[t][o][d];
+                    table.from[t][o][out] = static_cast<std::uint8_t>(table.from[t][o][out] | (1u << d));
+                }
+            }
+        }
+        return table;
+    }
+
+    inline constexpr ArrivalTable arrivals = buildArrivals();
+
+    constexpr std::uint8_t arrivalsFor(GridCellType type, Orientation orientation, Direction direction) {
+        return arrivals.from[static_cast<int>(type)][static_cast<int>(orientation)][static_cast<int>(direction)];
+    }
 }
 
-#endif // DIRECTION_MAPS_H 
\ No newline at end of file
+#endif // DIRECTION_MAPS_H
@@ -1,42 +1,99 @@
+#include <algorithm>
 #include <iostream>
 #include <vector>
-#include <set>
 #include <cstdlib>
 #include <ctime>
 #include <sstream>
-#include <unordered_map>
 #include <random>
 #include "Grid.h"
 #include "GridCell.h"
 #include "DirectionMaps.h"
+#include "GridLog.h"
+#include "ScanKernels.h"
+#include "PortableRandom.h"
+
+namespace {
+    // Zobrist keys are mixed from what they stand for rather than drawn into
+    // a table, so boards of any side need no setup and every platform gets
+    // the same fingerprints
+    std::uint64_t zobristKey(std::uint64_t value) {
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    // Salts keeping the keys of the empty board and of teleporter pairs apart
+    // from the cell keys
+    constexpr std::uint64_t EMPTY_BOARD_KEY = 0x45A3F1C9D2B7E801ull;
+    constexpr std::uint64_t PAIR_KEY = 0x7C1D5E93A8F2B460ull;
+
+    std::uint64_t pairKey(CellIndex first, CellIndex second) {
+        const CellIndex low = std::min(first, second);
+        const CellIndex high = std::max(first, second);
+        return zobristKey(((static_cast<std::uint64_t>(low) << 32) | high) ^ PAIR_KEY);
+    }
+
+    std::uint64_t emptyBoardKey(int side) {
+        return zobristKey(static_cast<std::uint64_t>(side) ^ EMPTY_BOARD_KEY);
+    }
+}
 
 // Constructor implementation
-Grid::Grid(int size, int minObjects, int maxObjects, const std::vector<GridCellType>& objectTypes)
+template <typename Cells>
+BasicGrid<Cells>::BasicGrid(int size, int minObjects, int maxObjects, const std::vector<GridCellType>& objectTypes,
+                            const std::vector<double>& objectWeights)
     : gridSize(size)
     , minObjects(minObjects)
     , maxObjects(maxObjects)
-    , rng(std::random_device{}()) {
-    std::cout << "Grid constructor - Start" << std::endl;
-    std::cout.flush();
-    
-    try {
-        gridCells.resize(gridSize, std::vector<GridCell>(gridSize));
-        std::cout << "Grid constructor - Resized grid to " << size << "x" << size << std::endl;
-    } catch (const std::exception& e) {
-        std::cout << "Grid constructor - Exception: " << e.what() << std::endl;
-    } catch (...) {
-        std::cout << "Grid constructor - Unknown exception" << std::endl;
+    , entryPos(0)
+    , exitPos(0)
+    , rng(std::random_device{}())
+    , stepDelta{-size, size, -1, 1}
+    , configuredFeatures(0)
+    , walkFeatures(0) {
+    GRID_LOG("Grid constructor - Start");
+    setObjectTypes(objectTypes, objectWeights);
+    initializeGrid();
+    GRID_LOG("Grid constructor - Resized grid to " << size << "x" << size);
+}
+
+template <typename Cells>
+bool BasicGrid<Cells>::setObjectTypes(const std::vector<GridCellType>& types, const std::vector<double>& weights) {
+    objectTypes = types;
+    objectWeights = weights.empty() ? std::vector<double>(types.size(), 1.0) : weights;
+
+    // Objects of the previous types stay on the board until it is regenerated
+    configuredFeatures = 0;
+    for (GridCellType type : objectTypes) {
+        configuredFeatures |= walkFeaturesOf(type);
     }
-    std::cout.flush();
+    selectKernels(walkFeatures | configuredFeatures);
+
+    bool valid = objectWeights.size() == objectTypes.size();
+    for (GridCellType type : objectTypes) {
+        valid = valid && isObjectCell(type);
+    }
+    if (!valid || !objectTypeTable.build(objectWeights)) {
+        objectTypeTable = AliasTable();
+        return false;
+    }
+    return true;
+}
+
+template <typename Cells>
+void BasicGrid<Cells>::seed(std::uint32_t value) {
+    rng.seed(value);
 }
 
 // Helper to get random number in range
-int Grid::getRandomInt(int min, int max) const{
-    std::uniform_int_distribution<int> dist(min, max);
-    return dist(rng);
+template <typename Cells>
+int BasicGrid<Cells>::getRandomInt(int min, int max) const{
+    return min + static_cast<int>(uniformBelow(rng, static_cast<std::uint32_t>(max - min) + 1));
 }
 
-std::string Grid::DirectionToString(Direction dir) const {
+template <typename Cells>
+std::string BasicGrid<Cells>::DirectionToString(Direction dir) const {
     switch (dir) {
         case Direction::Up:    return "Up";
         case Direction::Down:  return "Down";
@@ -47,99 +104,95 @@ std::string Grid::DirectionToString(Direction dir) const {
 }
 
 // Get the starting direction based on entry position
-Direction Grid::getStartingDirection(const Pos& entryPos) const{
-    if (entryPos.first == 0) return Direction::Down;   // Top edge
-    if (entryPos.first == gridSize - 1) return Direction::Up; // Bottom edge
-    if (entryPos.second == 0) return Direction::Right; // Left edge
+template <typename Cells>
+Direction BasicGrid<Cells>::getStartingDirection(CellIndex entryPos) const{
+    if (rowOf(entryPos) == 0) return Direction::Down;   // Top edge
+    if (rowOf(entryPos) == side() - 1) return Direction::Up; // Bottom edge
+    if (colOf(entryPos) == 0) return Direction::Right; // Left edge
     return Direction::Left;                            // Right edge
 }
 
-// Check if a position is within the center region of the grid
-bool Grid::isWithinCenter(const Pos& pos) const {
-    return (pos.first > 0 && pos.first < gridSize - 1) && (pos.second > 0 && pos.second < gridSize - 1);
-}
+// Find open positions along the ball's path. The scan stops at the sentinel
+// border, so no coordinate comparisons are needed.
+template <typename Cells>
+std::vector<CellIndex> BasicGrid<Cells>::findOpenPositions(CellIndex currentPos, Direction currentDirection) {
+    std::vector<CellIndex> openPositionsInDirection;
+    GRID_LOG("Finding open positions from (" << rowOf(currentPos) << "," << colOf(currentPos)
+              << ") going direction " << DirectionToString(currentDirection));
 
-// Check if a position is within the grid bounds
-bool Grid::isWithinBounds(const Pos& pos) const {
-    return (pos.first >= 0 && pos.first <= gridSize - 1) && (pos.second >= 0 && pos.second <= gridSize - 1);
-}
-
-// Find open positions along the ball's path
-std::vector<Pos> Grid::findOpenPositions(const Pos& currentPos, Direction currentDirection) {
-    std::vector<Pos> openPositionsInDirection;
-    std::cout << "Finding open positions from (" << currentPos.first << "," << currentPos.second 
-              << ") going direction " << DirectionToString(currentDirection) << std::endl;
-    
-    Pos nextPos = getNextPosition(currentPos, currentDirection);
-    
-    // Stop if first position is invalid
-    if (nextPos == currentPos) {
+    if (currentDirection == Direction::None) {
         return openPositionsInDirection;
     }
 
-    while (isWithinCenter(nextPos)) {
-        std::cout << "Checking position (" << nextPos.first << "," << nextPos.second << ")" << std::endl;
-        
-        if (openPositions.find(nextPos) != openPositions.end()) {
-            std::cout << "Position is not occupied" << std::endl;
-            if (gridCells[nextPos.first][nextPos.second].type == GridCellType::Empty) {
-                std::cout << "Position is empty, adding to open positions" << std::endl;
-                openPositionsInDirection.push_back(nextPos);
+    const CellIndex delta = stepOffset(currentDirection);
+    if constexpr (Cells::CONTIGUOUS) {
+        // Long rays: one bit per cell up to the ring, then one position per
+        // set bit
+        const std::uint32_t count = cellsToRing(currentPos, currentDirection);
+        if (count >= ScanKernels::VECTOR_MIN_CELLS) {
+            const ScanKernels::Ray ray{gridCells.data() + (currentPos + delta),
+                                       static_cast<std::int32_t>(delta), count};
+            openRayMask.resize((count + 63) / 64);
+            ScanKernels::openMaskVector(ray, openRayMask.data());
+            for (std::size_t word = 0; word < openRayMask.size(); word++) {
+                for (std::uint64_t bits = openRayMask[word]; bits != 0; bits &= bits - 1) {
+                    const CellIndex step = static_cast<CellIndex>(word * 64 + __builtin_ctzll(bits)) + 1;
+                    openPositionsInDirection.push_back(currentPos + step * delta);
+                }
             }
-        } else {
-            std::cout << "Position is occupied" << std::endl;
+            GRID_LOG("Found " << openPositionsInDirection.size() << " open positions");
+            return openPositionsInDirection;
         }
-        
-        Pos prevPos = nextPos;
-        nextPos = getNextPosition(nextPos, currentDirection);
-        
-        // Break if we're not moving anymore
-        if (prevPos == nextPos) break;
     }
-    
-    std::cout << "Found " << openPositionsInDirection.size() << " open positions" << std::endl;
+
+    for (CellIndex pos = currentPos + delta; !isBorderCell(gridCells[pos].type); pos += delta) {
+        if (gridCells[pos].type == GridCellType::Empty) {
+            openPositionsInDirection.push_back(pos);
+        }
+    }
+
+    GRID_LOG("Found " << openPositionsInDirection.size() << " open positions");
     return openPositionsInDirection;
 }
 
-// Calculate the next position based on the current direction
-Pos Grid::getNextPosition(const Pos& currentPos, Direction direction) const {
-    Pos nextPos = currentPos;
+// Cells strictly between pos and the border ring, going in direction
+template <typename Cells>
+std::uint32_t BasicGrid<Cells>::cellsToRing(CellIndex pos, Direction direction) const {
+    int count = 0;
     switch (direction) {
-        case Direction::Up:    nextPos = {currentPos.first - 1, currentPos.second}; break;    // Move up (decrease row)
-        case Direction::Down:  nextPos = {currentPos.first + 1, currentPos.second}; break;    // Move down (increase row)
-        case Direction::Left:  nextPos = {currentPos.first, currentPos.second - 1}; break;    // Move left (decrease column)
-        case Direction::Right: nextPos = {currentPos.first, currentPos.second + 1}; break;    // Move right (increase column)
-        default:              return currentPos;
-    }
-    
-    if (!isWithinBounds(nextPos)) {
-        return currentPos;
+        case Direction::Up:    count = rowOf(pos) - 1; break;
+        case Direction::Down:  count = side() - 2 - rowOf(pos); break;
+        case Direction::Left:  count = colOf(pos) - 1; break;
+        case Direction::Right: count = side() - 2 - colOf(pos); break;
+        default: break;
     }
-    return nextPos;
+    return count > 0 ? static_cast<std::uint32_t>(count) : 0;
 }
 
 // Get a random entry position on the edge of the grid, excluding the corners
-Pos Grid::getEntryPosition() {
-    int side = getRandomInt(0, 3);
-    int pos = getRandomInt(1, gridSize - 2);
+template <typename Cells>
+CellIndex BasicGrid<Cells>::getEntryPosition() {
+    int edge = getRandomInt(0, 3);
+    int pos = getRandomInt(1, side() - 2);
 
-    switch (side) {
-        case 0: return {0, pos};               // Top edge
-        case 1: return {gridSize - 1, pos};    // Bottom edge
-        case 2: return {pos, 0};              // Left edge
-        default: return {pos, gridSize - 1};  // Right edge
+    switch (edge) {
+        case 0: return toIndex(0, pos);               // Top edge
+        case 1: return toIndex(side() - 1, pos);      // Bottom edge
+        case 2: return toIndex(pos, 0);              // Left edge
+        default: return toIndex(pos, side() - 1);    // Right edge
     }
 }
 
 // Convert the grid to an ASCII representation
-std::string Grid::toASCII() const {
+template <typename Cells>
+std::string BasicGrid<Cells>::toASCII() const {
     std::ostringstream oss;
 
-    for (int i = 0; i < gridSize; ++i) {
-        for (int j = 0; j < gridSize; ++j) {
+    for (int i = 0; i < side(); ++i) {
+        for (int j = 0; j < side(); ++j) {
             // Fetch the cell type and orientation
-            GridCellType cellType = gridCells[i][j].type;
-            Orientation cellOrientation = gridCells[i][j].orientation;
+            GridCellType cellType = cellAt(i, j).type;
+            Orientation cellOrientation = cellAt(i, j).orientation;
             switch (cellType) {
 
                 case GridCellType::Entry:              
@@ -151,6 +204,9 @@ std::string Grid::toASCII() const {
                 case GridCellType::Empty:              
                     oss << " "; break;
 
+                case GridCellType::Border:
+                    oss << " "; break;
+
                 case GridCellType::InBallPath:         
                     oss << " "; break;
 
@@ -163,9 +219,9 @@ std::string Grid::toASCII() const {
                     break;
 
                 case GridCellType::Tunnel:
-                    if (gridCells[i][j].orientation == Orientation::Horizontal) {
+                    if (cellAt(i, j).orientation == Orientation::Horizontal) {
                         oss << "= ";
-                    } else if (gridCells[i][j].orientation == Orientation::Vertical) {
+                    } else if (cellAt(i, j).orientation == Orientation::Vertical) {
                         oss << "||";
                     }
                     break;
@@ -203,365 +259,981 @@ std::string Grid::toASCII() const {
     return oss.str();
 }
 
-// Initialize the grid
-void Grid::initializeGrid() {
-    std::cout << "initializeGrid - Start" << std::endl;
-    std::cout.flush();
-    
-    try {
-        gridCells.clear();
-        gridCells.resize(gridSize, std::vector<GridCell>(gridSize));
-        std::cout << "initializeGrid - Grid reset complete" << std::endl;
-    } catch (const std::exception& e) {
-        std::cout << "initializeGrid - Exception: " << e.what() << std::endl;
-    } catch (...) {
-        std::cout << "initializeGrid - Unknown exception" << std::endl;
-    }
-    std::cout.flush();
+// Initialize the grid with an empty playfield inside a ring of Border
+// sentinels. A side the storage cannot hold gets no cells, and generation
+// and loading reject it.
+template <typename Cells>
+void BasicGrid<Cells>::initializeGrid() {
+    GRID_LOG("initializeGrid - Start");
+
+    gridCells.reset(gridSize <= Cells::MAX_SIDE ? gridSize : 0);
+    boardFingerprint = emptyBoardKey(gridSize);
+    stepDelta[0] = -gridSize;
+    stepDelta[1] = gridSize;
+    ballPath.clear();
+    pathMetrics = {};
+    seenCells.clear();
+    touchedCells.clear();
+
+    GRID_LOG("initializeGrid - Grid reset complete");
 }
 
 // Select random orientation dependent on the grid cell type
-Orientation Grid::getViableOrientation(GridCellType type) {
-    std::vector<Orientation> viableOrientations;
+namespace {
+    // Orientations a cell of the given type may take; count receives their number
+    const Orientation* viableOrientations(GridCellType type, int& count) {
+        static const Orientation tunnelOrientations[] = {Orientation::Horizontal, Orientation::Vertical};
+        static const Orientation directionalOrientations[] = {Orientation::TopLeft, Orientation::TopRight, Orientation::BottomLeft, Orientation::BottomRight};
+        static const Orientation bumperOrientations[] = {Orientation::UpRight, Orientation::DownRight};
+        static const Orientation noOrientation[] = {Orientation::None};
+
+        switch (type) {
+            case GridCellType::Tunnel: 
+                count = 2;
+                return tunnelOrientations;
+            case GridCellType::DirectionalBumper: 
+                count = 4;
+                return directionalOrientations;
+            case GridCellType::Bumper: 
+            case GridCellType::ActivatedBumper: 
+                count = 2;
+                return bumperOrientations;
+            default:
+                count = 1;
+                return noOrientation;
+        }
+    }
+}
+
+template <typename Cells>
+Orientation BasicGrid<Cells>::getViableOrientation(GridCellType type) {
+    int count = 0;
+    const Orientation* orientations = viableOrientations(type, count);
+    return orientations[getRandomInt(0, count - 1)];
+}
+
+template <typename Cells>
+Direction BasicGrid<Cells>::getNewDirection(GridCellType type, Direction currentDirection, 
+                              Orientation orientation, CellIndex pos) {
+    // ActivatedBumpers let the ball through once, then deflect like a Bumper
+    if (type == GridCellType::ActivatedBumper && !gridCells[pos].hasBeenActivated) {
+        gridCells.edit(pos).hasBeenActivated = true;
+        return currentDirection;
+    }
+
+    return DirectionMaps::transition(type, orientation, currentDirection);
+}
+
+template <typename Cells>
+unsigned BasicGrid<Cells>::walkFeaturesOf(GridCellType type) {
     switch (type) {
-        case GridCellType::Tunnel: 
-            viableOrientations = {Orientation::Horizontal, Orientation::Vertical};
-            break;
-        case GridCellType::DirectionalBumper: 
-            viableOrientations = {Orientation::TopLeft, Orientation::TopRight, Orientation::BottomLeft, Orientation::BottomRight};
-            break;
-        case GridCellType::Bumper: 
-            viableOrientations = {Orientation::UpRight, Orientation::DownRight};
-            break;
-        case GridCellType::ActivatedBumper: 
-            viableOrientations = {Orientation::UpRight, Orientation::DownRight};
-            break;
-        default:
-            viableOrientations = {Orientation::None};
+        case GridCellType::Teleporter:      return WALK_TELEPORTER;
+        case GridCellType::ActivatedBumper: return WALK_ACTIVATED_BUMPER;
+        default:                            return 0;
     }
-    return viableOrientations[getRandomInt(0, viableOrientations.size() - 1)];
 }
 
-Direction Grid::getNewDirection(GridCellType type, Direction currentDirection, 
-                              Orientation orientation, const Pos& pos) {
-    if (type == GridCellType::ActivatedBumper) {
-        if (!gridCells[pos.first][pos.second].hasBeenActivated) {
-            gridCells[pos.first][pos.second].hasBeenActivated = true;
-            return currentDirection;
+template <typename Cells>
+void BasicGrid<Cells>::selectKernels(unsigned features) {
+    using ResimulateKernel = CellIndex (BasicGrid::*)(std::size_t);
+    using GenerateKernel = bool (BasicGrid::*)();
+    static constexpr ResimulateKernel resimulateKernels[] = {
+        &BasicGrid::resimulateWith<0>,
+        &BasicGrid::resimulateWith<WALK_TELEPORTER>,
+        &BasicGrid::resimulateWith<WALK_ACTIVATED_BUMPER>,
+        &BasicGrid::resimulateWith<WALK_ALL>,
+    };
+    static constexpr GenerateKernel generateKernels[] = {
+        &BasicGrid::generateAttemptWith<0>,
+        &BasicGrid::generateAttemptWith<WALK_TELEPORTER>,
+        &BasicGrid::generateAttemptWith<WALK_ACTIVATED_BUMPER>,
+        &BasicGrid::generateAttemptWith<WALK_ALL>,
+    };
+    walkFeatures = features & WALK_ALL;
+    resimulateKernel = resimulateKernels[walkFeatures];
+    generateKernel = generateKernels[walkFeatures];
+}
+
+// The ball's direction after entering the object cell at nextPos; landed
+// becomes the teleporter partner when it moves the ball. Behaviors missing
+// from Features compile out, leaving the table lookup.
+template <typename Cells>
+template <unsigned Features>
+Direction BasicGrid<Cells>::bounce(const GridCell& cell, CellIndex nextPos, Direction direction, CellIndex& landed) {
+    if constexpr ((Features & WALK_TELEPORTER) != 0) {
+        if (cell.type == GridCellType::Teleporter) {
+            landed = getTeleporterPartner(nextPos);
+            return direction;
         }
-        
-        const auto& bumperMap = DirectionMaps::directionMaps.at(GridCellType::Bumper);
-        auto orientIt = bumperMap.find(orientation);
-        if (orientIt != bumperMap.end()) {
-            auto dirIt = orientIt->second.find(currentDirection);
-            if (dirIt != orientIt->second.end()) {
-                return dirIt->second;
-            }
+    }
+    if constexpr ((Features & WALK_ACTIVATED_BUMPER) != 0) {
+        // ActivatedBumpers let the ball through once, then deflect like a Bumper
+        if (cell.type == GridCellType::ActivatedBumper && !cell.hasBeenActivated) {
+            forgetSeenStates();
+            gridCells.edit(nextPos).hasBeenActivated = true;
+            return direction;
         }
-        return currentDirection;
     }
-    
-    // Handle other object types normally
-    auto typeIt = DirectionMaps::directionMaps.find(type);
-    if (typeIt != DirectionMaps::directionMaps.end()) {
-        auto orientIt = typeIt->second.find(orientation);
-        if (orientIt != typeIt->second.end()) {
-            auto dirIt = orientIt->second.find(currentDirection);
-            if (dirIt != orientIt->second.end()) {
-                return dirIt->second;
+    return DirectionMaps::transition(cell.type, cell.orientation, direction);
+}
+
+// Position of the teleporter linked to the one at pos
+template <typename Cells>
+CellIndex BasicGrid<Cells>::getTeleporterPartner(CellIndex pos) const {
+    auto found = teleporterPartners.find(pos);
+    return found == teleporterPartners.end() ? pos : found->second;
+}
+
+template <typename Cells>
+void BasicGrid<Cells>::toggleFingerprint(CellIndex pos, GridCellType type, Orientation orientation) {
+    // A teleporter's orientation means nothing; its pair has a key of its own
+    const std::uint64_t contents = type == GridCellType::Teleporter
+        ? static_cast<std::uint64_t>(type) << 4
+        : (static_cast<std::uint64_t>(type) << 4) | static_cast<std::uint64_t>(orientation);
+    boardFingerprint ^= zobristKey((static_cast<std::uint64_t>(pos) << 8) | contents);
+}
+
+template <typename Cells>
+bool BasicGrid<Cells>::sameBoard(const BasicGrid& other) const {
+    if (boardFingerprint != other.boardFingerprint) {
+        return false;
+    }
+    if (side() != other.side() || entryPos != other.entryPos
+        || teleporterPairs.size() != other.teleporterPairs.size()) {
+        return false;
+    }
+    for (const TeleporterPair& pair : teleporterPairs) {
+        if (other.getTeleporterPartner(pair.first) != pair.second) {
+            return false;
+        }
+    }
+    for (int row = 1; row < side() - 1; row++) {
+        for (int col = 1; col < side() - 1; col++) {
+            const GridCell& cell = cellAt(row, col);
+            const GridCell& otherCell = other.cellAt(row, col);
+            const bool object = isObjectCell(cell.type);
+            if (object != isObjectCell(otherCell.type)
+                || (object && (cell.type != otherCell.type
+                               || (cell.type != GridCellType::Teleporter
+                                   && cell.orientation != otherCell.orientation)))) {
+                return false;
             }
         }
     }
-    return currentDirection;
+    return true;
 }
 
-void Grid::initializeOpenPositions() {
-    openPositions.clear();
-    occupiedPositions.clear();
-    
-    // Add all valid positions within center of grid to openPositions
-    for (int i = 1; i < gridSize - 1; i++) {
-        for (int j = 1; j < gridSize - 1; j++) {
-            openPositions.insert({i, j});
-        }
+template <typename Cells>
+void BasicGrid<Cells>::addTeleporterPair(CellIndex first, CellIndex second, int index) {
+    for (CellIndex pos : {first, second}) {
+        GridCell& cell = gridCells.edit(pos);
+        cell.type = GridCellType::Teleporter;
+        cell.teleporterIndex = index;
+        toggleFingerprint(pos, GridCellType::Teleporter, Orientation::None);
     }
+    boardFingerprint ^= pairKey(first, second);
+    touchedCells.push_back(first);
+    touchedCells.push_back(second);
+    teleporterPairs.push_back({first, second, index});
+    teleporterPartners[first] = second;
+    teleporterPartners[second] = first;
 }
 
-void Grid::removePosition(const Pos& pos) {
-    std::cout << "Removing position (" << pos.first << "," << pos.second << ")" << std::endl;
-    openPositions.erase(pos);
-    occupiedPositions.insert(pos);
+// Removes the pair holding pos from the pair list and the fingerprint; the
+// cells are left as is
+template <typename Cells>
+void BasicGrid<Cells>::removeTeleporterPair(CellIndex pos) {
+    CellIndex partnerPos = getTeleporterPartner(pos);
+    toggleFingerprint(pos, GridCellType::Teleporter, Orientation::None);
+    toggleFingerprint(partnerPos, GridCellType::Teleporter, Orientation::None);
+    boardFingerprint ^= pairKey(pos, partnerPos);
+    teleporterPartners.erase(pos);
+    teleporterPartners.erase(partnerPos);
+    teleporterPairs.erase(std::remove_if(teleporterPairs.begin(), teleporterPairs.end(),
+                                         [pos](const TeleporterPair& pair) {
+                                             return pair.first == pos || pair.second == pos;
+                                         }),
+                          teleporterPairs.end());
 }
 
-void Grid::reset() {
-    // Clear all grid cells
-    initializeGrid();
-    
-    // Reset positions
-    entryPos = {0, 0};
-    
-    // Clear open/occupied positions
-    openPositions.clear();
-    occupiedPositions.clear();
-    
-    // Reset all cells to empty
-    for (int i = 0; i < gridSize; i++) {
-        for (int j = 0; j < gridSize; j++) {
-            gridCells[i][j].type = GridCellType::Empty;
-            gridCells[i][j].direction = Direction::None;
-            gridCells[i][j].orientation = Orientation::None;
-        }
+// First ballPath step that touches pos, or ballPath.size() if none does
+template <typename Cells>
+std::size_t BasicGrid<Cells>::firstAffectedStep(CellIndex pos) const {
+    const std::int32_t firstVisit = gridCells[pos].firstVisit;
+    return firstVisit == NOT_VISITED ? ballPath.size() : static_cast<std::size_t>(firstVisit);
+}
+
+template <typename Cells>
+void BasicGrid<Cells>::recordStep(CellIndex pos, CellIndex landed, Direction direction) {
+    const std::int32_t step = static_cast<std::int32_t>(ballPath.size());
+    ballPath.push_back({pos, landed, direction});
+    if (gridCells[pos].firstVisit == NOT_VISITED) {
+        gridCells.edit(pos).firstVisit = step;
+    }
+    if (gridCells[landed].firstVisit == NOT_VISITED) {
+        gridCells.edit(landed).firstVisit = step;
     }
+    countStep(static_cast<std::size_t>(step), 1);
 }
 
-bool Grid::isPotentialNewObjectValid(Pos nextPos, Pos potentialPos, Direction currentDirection) const{
-    // Check if any of the coordinates between nextPos and potentialPos are occupied
-    if (currentDirection == Direction::Up) {
-        for (int i = nextPos.first - 1; i >= potentialPos.first; i--) {
-            if (gridCells[i][nextPos.second].type != GridCellType::Empty 
-                && gridCells[i][nextPos.second].type != GridCellType::InBallPath) {
-                return false;
+// A step's part in the metrics, read from its cell as the walk left it: an
+// ActivatedBumper first visited at this step let the ball through, and a
+// cell first visited earlier is crossed again
+template <typename Cells>
+void BasicGrid<Cells>::countStep(std::size_t step, int sign) {
+    if (step == 0) {
+        return;
+    }
+    const PathStep& current = ballPath[step];
+    const GridCell& cell = gridCells[current.pos];
+    const bool firstVisit = cell.firstVisit == static_cast<std::int32_t>(step);
+    const bool passedThrough = cell.type == GridCellType::ActivatedBumper && firstVisit;
+    const bool hopped = cell.type == GridCellType::Teleporter && current.landed != current.pos;
+    const auto add = [sign](std::uint32_t& count, bool counted) {
+        count += counted ? static_cast<std::uint32_t>(sign) : 0;
+    };
+    add(pathMetrics.steps, true);
+    add(pathMetrics.bounces, isObjectCell(cell.type) && cell.type != GridCellType::Teleporter && !passedThrough);
+    add(pathMetrics.directionChanges, current.direction != Direction::None
+                                      && current.direction != ballPath[step - 1].direction);
+    add(pathMetrics.teleporterHops, hopped);
+    add(pathMetrics.selfCrossings, !firstVisit && !isBorderCell(cell.type));
+    add(pathMetrics.activatedPassThroughs, passedThrough);
+}
+
+// Drop ballPath[step..] and undo what those steps left on the cells: path
+// marks, the exit, and ActivatedBumpers they switched on. A cell is restored
+// with the step that first visited it, the last of its steps to go, so the
+// steps dropped before it still see it as they left it. The exit is the
+// exception: the ball may leave through the entry, whose first visit is
+// step 0, so the exit step gives its cell back its ring type itself.
+template <typename Cells>
+void BasicGrid<Cells>::truncatePath(std::size_t step) {
+    if (step == 0) {
+        pathMetrics = {};
+    }
+    while (ballPath.size() > step) {
+        if (step > 0) {
+            countStep(ballPath.size() - 1, -1);
+        }
+        const PathStep last = ballPath.back();
+        ballPath.pop_back();
+        if (last.direction == Direction::None && gridCells[last.pos].type == GridCellType::Exit) {
+            gridCells.edit(last.pos).type = last.pos == entryPos ? GridCellType::Entry : GridCellType::Border;
+        }
+
+        for (CellIndex pos : {last.pos, last.landed}) {
+            if (gridCells[pos].firstVisit != static_cast<std::int32_t>(ballPath.size())) {
+                continue;
+            }
+
+            GridCell& cell = gridCells.edit(pos);
+            cell.firstVisit = NOT_VISITED;
+            if (cell.type == GridCellType::InBallPath) {
+                cell.type = GridCellType::Empty;
             }
+            cell.hasBeenActivated = false;
+            gridCells.release(pos);
         }
     }
-    else if (currentDirection == Direction::Down) {
-        for (int i = nextPos.first + 1; i <= potentialPos.first; i++) {
-            if (gridCells[i][nextPos.second].type != GridCellType::Empty 
-                && gridCells[i][nextPos.second].type != GridCellType::InBallPath) {
-                return false;
+}
+
+// Re-walk the ball from ballPath[step] on, keeping the steps before it. The
+// cost is proportional to the part of the path that is walked again.
+template <typename Cells>
+CellIndex BasicGrid<Cells>::resimulateFrom(std::size_t step) {
+    return (this->*resimulateKernel)(step);
+}
+
+template <typename Cells>
+template <unsigned Features>
+CellIndex BasicGrid<Cells>::resimulateWith(std::size_t step) {
+    if (step == 0 || ballPath.empty()) {
+        truncatePath(0);
+        recordStep(entryPos, entryPos, getStartingDirection(entryPos));
+    } else {
+        truncatePath(step);
+    }
+
+    CellIndex currentPos = ballPath.back().landed;
+    Direction currentDirection = ballPath.back().direction;
+    forgetSeenStates();
+
+    while (true) {
+        CellIndex nextPos = currentPos + stepOffset(currentDirection);
+        // A copy, since writes through edit() may move stored cells
+        const GridCell cell = gridCells[nextPos];
+
+        if (isBorderCell(cell.type)) {
+            gridCells.edit(nextPos).type = GridCellType::Exit;
+            exitPos = nextPos;
+            recordStep(nextPos, nextPos, Direction::None);
+            return exitPos;
+        }
+
+        if (cell.type == GridCellType::Empty) {
+            gridCells.edit(nextPos).type = GridCellType::InBallPath;
+        }
+
+        CellIndex landed = nextPos;
+        if (isObjectCell(cell.type)) {
+            currentDirection = bounce<Features>(cell, nextPos, currentDirection, landed);
+            if (revisits(landed, currentDirection)) {
+                exitPos = INVALID_CELL;
+                return INVALID_CELL;
             }
         }
+
+        recordStep(nextPos, landed, currentDirection);
+        currentPos = landed;
     }
-    else if (currentDirection == Direction::Left) {
-        for (int i = nextPos.second - 1; i >= potentialPos.second; i--) {
-            if (gridCells[nextPos.first][i].type != GridCellType::Empty 
-                && gridCells[nextPos.first][i].type != GridCellType::InBallPath) {
-                return false;
-            }
+}
+
+// Loop detection for the ball walk. While the board does not change, the walk
+// is deterministic, so reaching the same (object, direction) state twice
+// means the ball never leaves. Placing an object or switching on an
+// ActivatedBumper changes the board and starts the record over; clearing
+// touches only the states recorded, so the check is O(1) per bounce.
+template <typename Cells>
+bool BasicGrid<Cells>::revisits(CellIndex pos, Direction direction) {
+    const std::uint8_t bit = static_cast<std::uint8_t>(1u << static_cast<unsigned>(direction));
+    const std::uint8_t seen = gridCells[pos].seenDirections;
+    if (seen & bit) {
+        return true;
+    }
+    if (seen == 0) {
+        seenCells.push_back(pos);
+    }
+    gridCells.edit(pos).seenDirections = seen | bit;
+    return false;
+}
+
+template <typename Cells>
+void BasicGrid<Cells>::forgetSeenStates() {
+    for (CellIndex pos : seenCells) {
+        if (gridCells[pos].seenDirections != 0) {
+            gridCells.edit(pos).seenDirections = 0;
         }
     }
-    else if (currentDirection == Direction::Right) {
-        for (int i = nextPos.second + 1; i <= potentialPos.second; i++) {
-            if (gridCells[nextPos.first][i].type != GridCellType::Empty 
-                && gridCells[nextPos.first][i].type != GridCellType::InBallPath) {
-                return false;
-            }
+    seenCells.clear();
+}
+
+// Clears the previous attempt. Only the cells it wrote are restored, so a
+// failed attempt on a large board costs its path length, not the board size.
+template <typename Cells>
+void BasicGrid<Cells>::reset() {
+    if (gridCells.size() != static_cast<std::size_t>(gridSize) * gridSize) {
+        initializeGrid();
+    } else {
+        truncatePath(0);
+        for (CellIndex pos : touchedCells) {
+            gridCells.erase(pos);
         }
     }
-    return true;
+    touchedCells.clear();
+    // Symbols are unique per board, not per grid
+    usedTeleporterIndices = 0;
+    
+    // Reset positions
+    entryPos = 0;
+    exitPos = 0;
+    boardFingerprint = emptyBoardKey(gridSize);
+
+    teleporterPairs.clear();
+    teleporterPartners.clear();
+    selectKernels(configuredFeatures);
 }
 
-// Replace the single TeleporterPair with a vector
-struct TeleporterPair {
-    Pos first;
-    Pos second;
-    int index;  // Add index for identification
-};
+template <typename Cells>
+bool BasicGrid<Cells>::isPotentialNewObjectValid(CellIndex nextPos, CellIndex potentialPos, Direction currentDirection) const{
+    if (currentDirection == Direction::None) {
+        return true;
+    }
 
-int Grid::getNextAvailableTeleporterIndex() {
-    static std::set<int> usedIndices;
-    static const int MAX_INDICES = 9;  // Maximum number of unique symbols
-    
+    // Check if any of the cells between nextPos and potentialPos are occupied
+    const CellIndex delta = stepOffset(currentDirection);
+    if constexpr (Cells::CONTIGUOUS) {
+        // Cells up to and including potentialPos, which has to lie ahead on
+        // the ray; otherwise the walk below would reach the border
+        int ahead = 0;
+        switch (currentDirection) {
+            case Direction::Up:    ahead = colOf(potentialPos) == colOf(nextPos) ? rowOf(nextPos) - rowOf(potentialPos) : 0; break;
+            case Direction::Down:  ahead = colOf(potentialPos) == colOf(nextPos) ? rowOf(potentialPos) - rowOf(nextPos) : 0; break;
+            case Direction::Left:  ahead = rowOf(potentialPos) == rowOf(nextPos) ? colOf(nextPos) - colOf(potentialPos) : 0; break;
+            default:               ahead = rowOf(potentialPos) == rowOf(nextPos) ? colOf(potentialPos) - colOf(nextPos) : 0; break;
+        }
+        if (ahead < 1 || static_cast<std::uint32_t>(ahead) > cellsToRing(nextPos, currentDirection)) {
+            return false;
+        }
+        const std::uint32_t count = static_cast<std::uint32_t>(ahead);
+        if (count >= ScanKernels::VECTOR_MIN_CELLS) {
+            const ScanKernels::Ray ray{gridCells.data() + (nextPos + delta), static_cast<std::int32_t>(delta), count};
+            return ScanKernels::firstObstacleVector(ray) == count;
+        }
+    }
+    for (CellIndex pos = nextPos + delta; ; pos += delta) {
+        if (gridCells[pos].type != GridCellType::Empty 
+            && gridCells[pos].type != GridCellType::InBallPath) {
+            return false;
+        }
+        if (pos == potentialPos || isBorderCell(gridCells[pos].type)) {
+            break;
+        }
+    }
+    return true;
+}
+
+// Teleporter symbols are drawn without repeats until all of them are in use.
+// reset() clears the used set, so each board, and each attempt at one, starts
+// with every symbol free and no two of its pairs share one below
+// MAX_TELEPORTER_INDICES pairs.
+template <typename Cells>
+int BasicGrid<Cells>::getNextAvailableTeleporterIndex() {
     // Clear indices if we've used them all
-    if (usedIndices.size() >= MAX_INDICES) {
-        usedIndices.clear();
+    if (usedTeleporterIndices == (1u << MAX_TELEPORTER_INDICES) - 1) {
+        usedTeleporterIndices = 0;
     }
     
     // Generate random index until we find an unused one
     int index;
     do {
-        index = getRandomInt(0, MAX_INDICES - 1);
-    } while (usedIndices.find(index) != usedIndices.end());
+        index = getRandomInt(0, MAX_TELEPORTER_INDICES - 1);
+    } while (usedTeleporterIndices & (1u << index));
     
-    usedIndices.insert(index);
+    usedTeleporterIndices |= 1u << index;
     return index;
 }
 
-void Grid::generateGrid(std::vector<GridCellType>& objectTypes, int attempt) {
+// Draw an object type by configured weight in O(1)
+template <typename Cells>
+GridCellType BasicGrid<Cells>::sampleObjectType() {
+    return objectTypes[objectTypeTable.sample(rng)];
+}
+
+// Place a random object at selectedPos. Teleporters also get a partner on a
+// random open cell; returns false if there is no room left for it.
+template <typename Cells>
+bool BasicGrid<Cells>::placeObject(CellIndex selectedPos, int& objectsPlaced) {
+    GridCellType randomType = sampleObjectType();
+
+    // A teleporter pair has to fit under maxObjects as well
+    for (int draw = 1; randomType == GridCellType::Teleporter && objectsPlaced + 2 > maxObjects; draw++) {
+        if (draw == MAX_TYPE_DRAWS) {
+            return false;
+        }
+        randomType = sampleObjectType();
+    }
+    Orientation randomOrientation = getViableOrientation(randomType);
+
+    if (randomType == GridCellType::Teleporter) {
+        int newIndex = getNextAvailableTeleporterIndex();  // Get random unused index
+
+        // Find position for partner teleporter; every Empty cell is open since
+        // the ball path and the border have their own types
+        gridCells.edit(selectedPos).type = GridCellType::Teleporter;
+        touchedCells.push_back(selectedPos);
+        CellIndex partnerPos = randomEmptyCell();
+        if (partnerPos == INVALID_CELL) {
+            return false;
+        }
+
+        // Place both teleporters with the same index
+        addTeleporterPair(selectedPos, partnerPos, newIndex);
+        objectsPlaced += 2;
+        GRID_LOG("* Placed object " << GridCellTypeToString(randomType) << "at (" << rowOf(selectedPos) << "," << colOf(selectedPos) << ")");
+        GRID_LOG("* Placed object " << GridCellTypeToString(randomType) << "at (" << rowOf(partnerPos) << "," << colOf(partnerPos) << ")");
+        return true;
+    }
+
+    // Place non-teleporter object
+    GridCell& cell = gridCells.edit(selectedPos);
+    cell.type = randomType;
+    cell.orientation = randomOrientation;
+    touchedCells.push_back(selectedPos);
+    toggleFingerprint(selectedPos, randomType, randomOrientation);
+    objectsPlaced++;
+    GRID_LOG("* Placed object " << GridCellTypeToString(randomType) << "at (" << rowOf(selectedPos) << "," << colOf(selectedPos) << ")");
+    return true;
+}
+
+// Random Empty cell, or INVALID_CELL if there is none. Drawing interior
+// cells finds one in a few tries unless the board is nearly full, so only
+// crowded (small) boards pay for collecting the Empty cells.
+template <typename Cells>
+CellIndex BasicGrid<Cells>::randomEmptyCell() {
+    for (int draw = 0; draw < MAX_CELL_DRAWS; draw++) {
+        // Row first: the order two draws in one call's arguments run in is
+        // up to the compiler
+        int row = getRandomInt(1, side() - 2);
+        int col = getRandomInt(1, side() - 2);
+        CellIndex pos = toIndex(row, col);
+        if (gridCells[pos].type == GridCellType::Empty) {
+            return pos;
+        }
+    }
+
+    openCells.clear();
+    for (CellIndex pos = 0; pos < gridCells.size(); pos++) {
+        if (gridCells[pos].type == GridCellType::Empty) {
+            openCells.push_back(pos);
+        }
+    }
+    return openCells.empty() ? INVALID_CELL : openCells[getRandomInt(0, openCells.size() - 1)];
+}
+
+// Fill up to maxObjects with objects the ball never reaches. Candidates are
+// Empty cells, and the walk marks every cell it crosses, so a decoy is off
+// the path: the ball never enters it and the exit cannot move. Decoys
+// therefore need no re-walk and cost about as much as plain placements.
+template <typename Cells>
+void BasicGrid<Cells>::placeDecoys(int& objectsPlaced) {
+    int failedDraws = 0;
+    while (objectsPlaced < maxObjects && failedDraws < MAX_TYPE_DRAWS) {
+        GridCellType type = sampleObjectType();
+        const int cost = type == GridCellType::Teleporter ? 2 : 1;
+        if (objectsPlaced + cost > maxObjects) {
+            failedDraws++;
+            continue;
+        }
+
+        CellIndex pos = randomEmptyCell();
+        if (pos == INVALID_CELL) {
+            return;
+        }
+        if (type == GridCellType::Teleporter) {
+            gridCells.edit(pos).type = GridCellType::Teleporter;
+            CellIndex partnerPos = randomEmptyCell();
+            if (partnerPos == INVALID_CELL) {
+                gridCells.erase(pos);
+                failedDraws++;
+                continue;
+            }
+            addTeleporterPair(pos, partnerPos, getNextAvailableTeleporterIndex());
+        } else {
+            GridCell& cell = gridCells.edit(pos);
+            cell.type = type;
+            cell.orientation = getViableOrientation(type);
+            touchedCells.push_back(pos);
+            toggleFingerprint(pos, type, cell.orientation);
+        }
+
+        failedDraws = 0;
+        objectsPlaced += cost;
+        GRID_LOG("* Placed decoy " << GridCellTypeToString(type) << " at (" << rowOf(pos) << "," << colOf(pos) << ")");
+    }
+}
+
+template <typename Cells>
+GridStatus BasicGrid<Cells>::setCell(int row, int col, GridCellType type, Orientation orientation) {
+    if (row < 1 || row > side() - 2 || col < 1 || col > side() - 2) {
+        return GRID_STATUS_OUT_OF_BOUNDS;
+    }
+    // A single teleporter has no partner, so only whole pairs come from generation
+    if (type != GridCellType::Empty && (!isObjectCell(type) || type == GridCellType::Teleporter)) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+    int count = 0;
+    const Orientation* orientations = viableOrientations(type, count);
+    if (std::find(orientations, orientations + count, orientation) == orientations + count) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+
+    const CellIndex pos = toIndex(row, col);
+    if (ballPath.empty()) {
+        simulate();
+    }
+
+    // Replacing a teleporter removes its partner with it
+    CellIndex partnerPos = pos;
+    if (gridCells[pos].type == GridCellType::Teleporter) {
+        partnerPos = getTeleporterPartner(pos);
+        removeTeleporterPair(pos);
+    } else if (isObjectCell(gridCells[pos].type)) {
+        toggleFingerprint(pos, gridCells[pos].type, gridCells[pos].orientation);
+    }
+
+    // Undo the walk from the first step that can see the edit, change the
+    // cells, then walk again from there
+    const std::size_t step = std::min(firstAffectedStep(pos), firstAffectedStep(partnerPos));
+    const bool onPath = step < ballPath.size();
+    truncatePath(step);
+    gridCells.erase(partnerPos);
+    gridCells.erase(pos);
+    if (type != GridCellType::Empty) {
+        GridCell& cell = gridCells.edit(pos);
+        cell.type = type;
+        cell.orientation = orientation;
+        touchedCells.push_back(pos);
+        toggleFingerprint(pos, type, orientation);
+        selectKernels(walkFeatures | walkFeaturesOf(type));
+    }
+
+    if (onPath) {
+        resimulateFrom(step);
+    }
+    return GRID_STATUS_OK;
+}
+
+template <typename Cells>
+GridStatus BasicGrid<Cells>::loadBoard(CellIndex entry, const BoardObject* objects, std::size_t count) {
+    if (gridSize < 3 || gridSize > Cells::MAX_SIDE || (Cells::FIXED_SIZE > 0 && gridSize != Cells::FIXED_SIZE)) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
     reset();
-    std::cout << "\n=== Starting Grid Generation ===" << std::endl;
-    
-    // Initial setup
-    initializeGrid();
-    initializeOpenPositions();
+    const int n = side();
+    const bool onRing = entry < static_cast<CellIndex>(n) * static_cast<CellIndex>(n) && isRingCell(entry, n);
+    const bool corner = (rowOf(entry) == 0 || rowOf(entry) == n - 1) && (colOf(entry) == 0 || colOf(entry) == n - 1);
+    if (!onRing || corner) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+    entryPos = entry;
+    gridCells.edit(entryPos).type = GridCellType::Entry;
+    touchedCells.push_back(entryPos);
+    toggleFingerprint(entryPos, GridCellType::Entry, Orientation::None);
+
+    unsigned features = configuredFeatures;
+    for (std::size_t i = 0; i < count; i++) {
+        const BoardObject& object = objects[i];
+        int orientationCount = 0;
+        const Orientation* orientations = viableOrientations(object.type, orientationCount);
+        const bool placeable = object.pos < static_cast<CellIndex>(n) * static_cast<CellIndex>(n)
+            && !isRingCell(object.pos, n) && gridCells[object.pos].type == GridCellType::Empty
+            && isObjectCell(object.type) && object.type != GridCellType::Teleporter
+            && std::find(orientations, orientations + orientationCount, object.orientation)
+                   != orientations + orientationCount;
+        if (!placeable) {
+            reset();
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+        GridCell& cell = gridCells.edit(object.pos);
+        cell.type = object.type;
+        cell.orientation = object.orientation;
+        touchedCells.push_back(object.pos);
+        toggleFingerprint(object.pos, object.type, object.orientation);
+        features |= walkFeaturesOf(object.type);
+    }
+
+    selectKernels(features);
+    simulate();
+    return GRID_STATUS_OK;
+}
+
+template <typename Cells>
+GridStatus BasicGrid<Cells>::generateGrid(int attempt) {
+    if (gridSize < 3 || gridSize > Cells::MAX_SIDE || objectTypeTable.empty() || maxObjects < minObjects
+        || (Cells::FIXED_SIZE > 0 && gridSize != Cells::FIXED_SIZE)) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+
+    for (; attempt < MAX_GENERATION_ATTEMPTS; attempt++) {
+        if (generateAttempt()) {
+            return GRID_STATUS_OK;
+        }
+    }
+    GRID_LOG("Giving up after " << attempt << " generation attempts");
+    return GRID_STATUS_GENERATION_FAILED;
+}
+
+// One generation pass; returns false if the grid has to be regenerated
+template <typename Cells>
+bool BasicGrid<Cells>::generateAttempt() {
+    reset();
+    return (this->*generateKernel)();
+}
+
+template <typename Cells>
+template <unsigned Features>
+bool BasicGrid<Cells>::generateAttemptWith() {
+    GRID_LOG("\n=== Starting Grid Generation ===");
     
     // Place entry
-    Pos entryPos = getEntryPosition();
-    gridCells[entryPos.first][entryPos.second].type = GridCellType::Entry;
+    entryPos = getEntryPosition();
+    gridCells.edit(entryPos).type = GridCellType::Entry;
+    touchedCells.push_back(entryPos);
+    toggleFingerprint(entryPos, GridCellType::Entry, Orientation::None);
     
     // Initialize ball path
     Direction currentDirection = getStartingDirection(entryPos);
-    Pos currentPos = entryPos;
+    CellIndex currentPos = entryPos;
     int objectsPlaced = 0;
-
-    // Use vector for multiple teleporter pairs
-    std::vector<TeleporterPair> teleporterPairs;
-
-    // Teleporter index
-    int teleporterIndex = 0;
+    recordStep(entryPos, entryPos, currentDirection);
     
     // TODO: create a seperate function to handle teleporter placement
     // Place initial object in the ball's path
-    Pos nextPos = getNextPosition(currentPos, currentDirection);
-    std::vector<Pos> initialOpenPositions = findOpenPositions(currentPos, currentDirection);
+    std::vector<CellIndex> initialOpenPositions = findOpenPositions(currentPos, currentDirection);
     if (!initialOpenPositions.empty()) {
         int randomIndex = getRandomInt(0, initialOpenPositions.size() - 1);
-        Pos selectedPos = initialOpenPositions[randomIndex];
-        
-        GridCellType randomType = objectTypes[getRandomInt(0, objectTypes.size() - 1)];
-        Orientation randomOrientation = getViableOrientation(randomType);
-        
-        if (randomType == GridCellType::Teleporter) {
-            int newIndex = getNextAvailableTeleporterIndex();  // Get random unused index
-            
-            // Place first teleporter
-            gridCells[selectedPos.first][selectedPos.second].type = GridCellType::Teleporter;
-            gridCells[selectedPos.first][selectedPos.second].teleporterIndex = newIndex;
-            removePosition(selectedPos);
-            
-            // Find position for partner teleporter
-            std::vector<Pos> remainingPositions(openPositions.begin(), openPositions.end());
-            if (!remainingPositions.empty()) {
-                int partnerIndex = getRandomInt(0, remainingPositions.size() - 1);
-                Pos partnerPos = remainingPositions[partnerIndex];
-                
-                // Place partner teleporter with same index
-                gridCells[partnerPos.first][partnerPos.second].type = GridCellType::Teleporter;
-                gridCells[partnerPos.first][partnerPos.second].teleporterIndex = newIndex;
-                removePosition(partnerPos);
-                
-                teleporterPairs.push_back({selectedPos, partnerPos, newIndex});
-                objectsPlaced += 2;
-                std::cout << "* Placed object " << GridCellTypeToString(randomType) << "at (" << selectedPos.first << "," << selectedPos.second << ")" << std::endl;
-                std::cout << "* Placed object " << GridCellTypeToString(randomType) << "at (" << partnerPos.first << "," << partnerPos.second << ")" << std::endl;
-            } else {
-                std::cout << "No remaining positions for initial teleporter pair, regenerating" << std::endl;
-                generateGrid(objectTypes, attempt + 1);
-                return;
-            }
-        } else {
-            // Place non-teleporter object
-            gridCells[selectedPos.first][selectedPos.second].type = randomType;
-            gridCells[selectedPos.first][selectedPos.second].orientation = randomOrientation;
-            removePosition(selectedPos);
-            objectsPlaced++;
-            std::cout << "* Placed object " << GridCellTypeToString(randomType) << "at (" << selectedPos.first << "," << selectedPos.second << ")" << std::endl;
+        if (!placeObject(initialOpenPositions[randomIndex], objectsPlaced)) {
+            GRID_LOG("No remaining positions for initial teleporter pair, regenerating");
+            return false;
         }
     }
     
-    int mainLoopCount = 0;
+    forgetSeenStates();
     
     while (true) {
-        // handle infinite loop
-        mainLoopCount++;
-        if (mainLoopCount > 1000) {
-            std::cout << "Main loop count exceeded 1000, regenerating" << std::endl;
-            generateGrid(objectTypes, attempt + 1);
-            return;
-        }
-        
+        // One add and one load per step; the border ring stops the walk
         Direction nextDirection = currentDirection;
-        Pos nextPos = getNextPosition(currentPos, currentDirection);
+        CellIndex nextPos = currentPos + stepOffset(currentDirection);
+        const GridCell nextCell = gridCells[nextPos];
         
         // check if the ball is at the exit
-        if (!isWithinCenter(nextPos)) {
-            gridCells[nextPos.first][nextPos.second].type = GridCellType::Exit;
+        if (isBorderCell(nextCell.type)) {
+            gridCells.edit(nextPos).type = GridCellType::Exit;
+            exitPos = nextPos;
+            recordStep(nextPos, nextPos, Direction::None);
             break;
         }
         
         // Mark ball path
-        if (gridCells[nextPos.first][nextPos.second].type == GridCellType::Empty) {
-            gridCells[nextPos.first][nextPos.second].type = GridCellType::InBallPath;
-            removePosition(nextPos);
+        if (nextCell.type == GridCellType::Empty) {
+            gridCells.edit(nextPos).type = GridCellType::InBallPath;
+            touchedCells.push_back(nextPos);
         }
+        CellIndex landedPos = nextPos;
         
         // check if the ball is at an object
-        if (gridCells[nextPos.first][nextPos.second].type != GridCellType::Empty && 
-            gridCells[nextPos.first][nextPos.second].type != GridCellType::InBallPath) {
-            
-            GridCellType cellType = gridCells[nextPos.first][nextPos.second].type;
-            Orientation cellOrientation = gridCells[nextPos.first][nextPos.second].orientation;
-            
-            // Handle teleporter interaction
-            if (cellType == GridCellType::Teleporter) {
-                // Find matching teleporter pair
-                for (const auto& pair : teleporterPairs) {
-                    if (nextPos == pair.first) {
-                        nextPos = pair.second;
-                        break;
-                    } else if (nextPos == pair.second) {
-                        nextPos = pair.first;
-                        break;
-                    }
-                }
-            }
-            
-            nextDirection = getNewDirection(cellType, currentDirection, cellOrientation, nextPos);
+        if (isObjectCell(nextCell.type)) {
+            nextDirection = bounce<Features>(nextCell, nextPos, currentDirection, landedPos);
             
             if (objectsPlaced < minObjects) {
-                std::vector<Pos> openPositionsInDirection = findOpenPositions(nextPos, nextDirection);
+                std::vector<CellIndex> openPositionsInDirection = findOpenPositions(landedPos, nextDirection);
                 if (!openPositionsInDirection.empty()) {
                     int randomIndex = getRandomInt(0, openPositionsInDirection.size() - 1);
-                    Pos selectedPos = openPositionsInDirection[randomIndex];
+                    CellIndex selectedPos = openPositionsInDirection[randomIndex];
 
                     // check if there are any other objects in the direction of the ball
                     // if so, do not place this new object.
-                    if (!isPotentialNewObjectValid(nextPos, selectedPos, nextDirection)) {
-                        currentPos = nextPos;
-                        currentDirection = nextDirection;
-                        std::cout << "Skipping object placement due to obstacle" << std::endl;
-                        continue;
-                    }
-    
-                    GridCellType randomType = objectTypes[getRandomInt(0, objectTypes.size() - 1)];
-                    Orientation randomOrientation = getViableOrientation(randomType);
-                    
-                    if (randomType == GridCellType::Teleporter) {
-                        int newIndex = getNextAvailableTeleporterIndex();  // Get random unused index
-                        
-                        // Place first teleporter
-                        gridCells[selectedPos.first][selectedPos.second].type = GridCellType::Teleporter;
-                        gridCells[selectedPos.first][selectedPos.second].teleporterIndex = newIndex;
-                        removePosition(selectedPos);
-                        
-                        std::vector<Pos> remainingPositions(openPositions.begin(), openPositions.end());
-                        if (!remainingPositions.empty()) {
-                            int partnerIndex = getRandomInt(0, remainingPositions.size() - 1);
-                            Pos partnerPos = remainingPositions[partnerIndex];
-                            
-                            // Place partner teleporter with same index
-                            gridCells[partnerPos.first][partnerPos.second].type = GridCellType::Teleporter;
-                            gridCells[partnerPos.first][partnerPos.second].teleporterIndex = newIndex;
-                            removePosition(partnerPos);
-                            
-                            teleporterPairs.push_back({selectedPos, partnerPos, newIndex});
-                            objectsPlaced += 2;
-                            std::cout << "* Placed object " << GridCellTypeToString(randomType) << "at (" << selectedPos.first << "," << selectedPos.second << ")" << std::endl;
-                            std::cout << "* Placed object " << GridCellTypeToString(randomType) << "at (" << partnerPos.first << "," << partnerPos.second << ")" << std::endl;
-                        }
-                        else {
-                            std::cout << "No remaining positions for teleporter pair" << std::endl;
-                            // regenerate grid
-                            generateGrid(objectTypes, attempt + 1);
-                        }
+                    if (!isPotentialNewObjectValid(landedPos, selectedPos, nextDirection)) {
+                        GRID_LOG("Skipping object placement due to obstacle");
+                    } else if (!placeObject(selectedPos, objectsPlaced)) {
+                        GRID_LOG("No remaining positions for teleporter pair");
+                        // regenerate grid
+                        return false;
                     } else {
-                        gridCells[selectedPos.first][selectedPos.second].type = randomType;
-                        gridCells[selectedPos.first][selectedPos.second].orientation = randomOrientation;
-                        removePosition(selectedPos);
-                        objectsPlaced++;
-                        std::cout << "* Placed object " << GridCellTypeToString(randomType) << "at (" << selectedPos.first << "," << selectedPos.second << ")" << std::endl;
+                        forgetSeenStates();
                     }
                 }
             }
+
+            // handle infinite loop
+            if (revisits(landedPos, nextDirection)) {
+                GRID_LOG("Ball is caught in a loop, regenerating");
+                return false;
+            }
         }
         
-        currentPos = nextPos;
+        recordStep(nextPos, landedPos, nextDirection);
+        currentPos = landedPos;
         currentDirection = nextDirection;
     }
+
     // check if grid is valid
     if (objectsPlaced < minObjects) {
-        std::cout << "Grid is invalid, not enough objects, regenerating" << std::endl;
-        generateGrid(objectTypes, attempt + 1);
+        GRID_LOG("Grid is invalid, not enough objects, regenerating");
+        return false;
+    }
+
+    placeDecoys(objectsPlaced);
+    return true;
+}
+
+template <typename Cells>
+GridStatus BasicGrid<Cells>::generateGridBackward() {
+    if (gridSize < 3 || gridSize > Cells::MAX_SIDE || objectTypeTable.empty() || maxObjects < minObjects
+        || (Cells::FIXED_SIZE > 0 && gridSize != Cells::FIXED_SIZE)) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+
+    // A pass fails only when no chain of minObjects reaches its exit within
+    // the trial budget, which takes crowded boards; it then starts over
+    for (int attempt = 0; attempt < MAX_GENERATION_ATTEMPTS; attempt++) {
+        if (generateBackwardAttempt()) {
+            return GRID_STATUS_OK;
+        }
+    }
+    GRID_LOG("Giving up on backward generation");
+    return GRID_STATUS_GENERATION_FAILED;
+}
+
+template <typename Cells>
+bool BasicGrid<Cells>::generateBackwardAttempt() {
+    reset();
+    const CellIndex exit = getEntryPosition();
+    int trials = 0;
+    if (!chainBackward(exit, DirectionMaps::reverse(getStartingDirection(exit)), 0, trials)) {
+        GRID_LOG("No chain of " << minObjects << " objects reaches (" << rowOf(exit) << "," << colOf(exit) << ")");
+        return false;
     }
-    // std::cout << "Grid generation complete" << std::endl;
+
+    simulate();
+    int objectsPlaced = minObjects;
+    placeDecoys(objectsPlaced);
+    return true;
 }
+
+// Places the objects the ball meets before it reaches target moving in
+// direction, last first. The cells it crosses on the way are marked
+// InBallPath as they are chosen, so no later placement lands on them.
+template <typename Cells>
+bool BasicGrid<Cells>::chainBackward(CellIndex target, Direction direction, int objectsPlaced, int& trials) {
+    const CellIndex back = stepOffset(DirectionMaps::reverse(direction));
+    if (objectsPlaced == minObjects) {
+        // The entry is where the ray behind target meets the ring, if no
+        // object is in the way
+        CellIndex pos = target + back;
+        for (; !isBorderCell(gridCells[pos].type); pos += back) {
+            if (isObjectCell(gridCells[pos].type)) {
+                return false;
+            }
+        }
+        entryPos = pos;
+        gridCells.edit(entryPos).type = GridCellType::Entry;
+        touchedCells.push_back(entryPos);
+        toggleFingerprint(entryPos, GridCellType::Entry, Orientation::None);
+        return true;
+    }
+
+    // The previous object sits on the ray behind target, short of any object
+    std::vector<CellIndex> candidates;
+    for (CellIndex pos = target + back; !isBorderCell(gridCells[pos].type); pos += back) {
+        if (isObjectCell(gridCells[pos].type)) {
+            break;
+        }
+        if (gridCells[pos].type == GridCellType::Empty) {
+            candidates.push_back(pos);
+        }
+    }
+    while (!candidates.empty() && trials < MAX_BACKWARD_TRIALS) {
+        const int pick = getRandomInt(0, static_cast<int>(candidates.size()) - 1);
+        const CellIndex pos = candidates[pick];
+        candidates[pick] = candidates.back();
+        candidates.pop_back();
+        if (placeBackward(pos, target, direction, objectsPlaced, trials)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Tries each object at pos that sends the ball on towards target in
+// direction, drawn by weight, and the chain behind it; undoes them all if
+// none leads back to an entry
+template <typename Cells>
+bool BasicGrid<Cells>::placeBackward(CellIndex pos, CellIndex target, Direction direction, int objectsPlaced,
+                                     int& trials) {
+    struct Choice {
+        GridCellType type;
+        Orientation orientation;
+        Direction arrival;
+    };
+    std::vector<Choice> choices;
+    for (GridCellType type : objectTypes) {
+        const int cost = type == GridCellType::Teleporter ? 2 : 1;
+        if (objectsPlaced + cost > minObjects) {
+            continue;
+        }
+        int count = 0;
+        const Orientation* orientations = viableOrientations(type, count);
+        for (int i = 0; i < count; i++) {
+            // Teleporters and first-time ActivatedBumpers keep the direction
+            const std::uint8_t arrivals = type == GridCellType::Teleporter || type == GridCellType::ActivatedBumper
+                ? static_cast<std::uint8_t>(1u << static_cast<int>(direction))
+                : DirectionMaps::arrivalsFor(type, orientations[i], direction);
+            for (int d = 0; d < 4; d++) {
+                if ((arrivals & (1u << d)) != 0) {
+                    choices.push_back({type, orientations[i], static_cast<Direction>(d)});
+                }
+            }
+        }
+    }
+    if (choices.empty()) {
+        return false;
+    }
+
+    // The cells between pos and target are crossed
+    const CellIndex ahead = stepOffset(direction);
+    const std::size_t marked = touchedCells.size();
+    for (CellIndex cross = pos + ahead; cross != target; cross += ahead) {
+        if (gridCells[cross].type == GridCellType::Empty) {
+            gridCells.edit(cross).type = GridCellType::InBallPath;
+            touchedCells.push_back(cross);
+        }
+    }
+
+    while (!choices.empty() && trials < MAX_BACKWARD_TRIALS) {
+        trials++;
+        // A type by weight, if one of the remaining choices has it
+        GridCellType type = sampleObjectType();
+        for (int draw = 1; draw < MAX_TYPE_DRAWS; draw++) {
+            const bool offered = std::any_of(choices.begin(), choices.end(),
+                                             [type](const Choice& choice) { return choice.type == type; });
+            if (offered) {
+                break;
+            }
+            type = sampleObjectType();
+        }
+        std::vector<std::size_t> ofType;
+        for (std::size_t i = 0; i < choices.size(); i++) {
+            if (choices[i].type == type) {
+                ofType.push_back(i);
+            }
+        }
+        const std::size_t index = ofType.empty()
+            ? static_cast<std::size_t>(getRandomInt(0, static_cast<int>(choices.size()) - 1))
+            : ofType[getRandomInt(0, static_cast<int>(ofType.size()) - 1)];
+        const Choice choice = choices[index];
+        choices[index] = choices.back();
+        choices.pop_back();
+
+        if (choice.type == GridCellType::Teleporter) {
+            // The ball arrives at a partner anywhere on the board and lands here
+            gridCells.edit(pos).type = GridCellType::Teleporter;
+            const CellIndex partnerPos = randomEmptyCell();
+            if (partnerPos == INVALID_CELL) {
+                gridCells.erase(pos);
+                continue;
+            }
+            addTeleporterPair(partnerPos, pos, getNextAvailableTeleporterIndex());
+            if (chainBackward(partnerPos, direction, objectsPlaced + 2, trials)) {
+                return true;
+            }
+            removeTeleporterPair(pos);
+            gridCells.erase(partnerPos);
+            gridCells.erase(pos);
+            continue;
+        }
+
+        GridCell& cell = gridCells.edit(pos);
+        cell.type = choice.type;
+        cell.orientation = choice.orientation;
+        touchedCells.push_back(pos);
+        toggleFingerprint(pos, choice.type, choice.orientation);
+        if (chainBackward(pos, choice.arrival, objectsPlaced + 1, trials)) {
+            return true;
+        }
+        toggleFingerprint(pos, choice.type, choice.orientation);
+        gridCells.erase(pos);
+    }
+
+    // Everything touched since is undone by now but the crossed cells
+    for (std::size_t i = marked; i < touchedCells.size(); i++) {
+        if (gridCells[touchedCells[i]].type == GridCellType::InBallPath) {
+            gridCells.erase(touchedCells[i]);
+        }
+    }
+    touchedCells.resize(marked);
+    return false;
+}
+
+template <typename Cells>
+CellIndex BasicGrid<Cells>::simulate() {
+    return resimulateFrom(0);
+}
+
+template class BasicGrid<DenseCells>;
+template class BasicGrid<SparseCells>;
+template class BasicGrid<FixedCells<5>>;
+template class BasicGrid<FixedCells<6>>;
+template class BasicGrid<FixedCells<7>>;
+template class BasicGrid<FixedCells<10>>;
@@ -1,71 +1,324 @@
 #ifndef GRID_H
 #define GRID_H
 
+#include <cstdint>
 #include <vector>
-#include <set>
 #include <string>
-#include <utility>
+#include <unordered_map>
 #include <random>
 #include "GridCell.h"
-#include <unordered_map>
+#include "GridStatus.h"
+#include "AliasTable.h"
+#include "CellStorage.h"
+#include "Symmetry.h"
 
-// Type alias for position in the grid (row, column)
-using Pos = std::pair<int, int>;
+// One step of the cached ball walk: the cell the ball moved into, the cell it
+// ended up on (the partner, for a teleporter) and the direction it leaves in.
+// The final step is the exit, with Direction::None.
+struct PathStep {
+    CellIndex pos;
+    CellIndex landed;
+    Direction direction;
+};
 
-struct PosHash {
-    std::size_t operator()(const Pos& pos) const {
-        return std::hash<int>()(pos.first) ^ (std::hash<int>()(pos.second) << 1);
-    }
+// Difficulty measures of the cached ball walk. They are counted as steps are
+// recorded and taken back as the walk is cut short, so generation,
+// simulation and edits keep them current in the walk they already do.
+struct PathMetrics {
+    std::uint32_t steps;                  // Cells entered, the exit included
+    std::uint32_t bounces;                // Visits to objects that steer by the transition table
+    std::uint32_t directionChanges;       // Steps leaving in another direction than the last
+    std::uint32_t teleporterHops;
+    std::uint32_t selfCrossings;          // Steps into an interior cell entered before
+    std::uint32_t activatedPassThroughs;  // ActivatedBumpers let through on their first visit
+};
+
+// Where the ball leaves the grid when dropped in at one edge cell
+struct EntryExit {
+    CellIndex entry;
+    CellIndex exit;        // INVALID_CELL if the ball never leaves
+    std::uint32_t steps;   // Cells entered up to and including the exit
+};
+
+// Two linked teleporters; entering one moves the ball to the other
+struct TeleporterPair {
+    CellIndex first;
+    CellIndex second;
+    int index;  // Add index for identification
+};
+
+// A single-cell object of a board, as loadBoard places it
+struct BoardObject {
+    CellIndex pos;
+    GridCellType type;
+    Orientation orientation;
 };
 
-class Grid {
+// Generator and simulator over a cell storage backend (see CellStorage.h).
+// Grid uses dense storage; SparseGrid keeps only non-empty cells for large,
+// mostly empty boards; GridN<N> fixes the side at compile time.
+template <typename Cells>
+class BasicGrid {
 public:
-    int gridSize;                                   
-    int minObjects;                                 
-    int maxObjects;                                 
-    Pos entryPos;
-    std::vector<GridCellType> objectTypes;          
-    std::vector<std::vector<GridCell>> gridCells;   
-    std::set<Pos> openPositions;  // New member to track open positions
-    std::set<Pos> occupiedPositions;  // New member to track occupied positions
-
-    // Constructor declaration only
-    Grid(int size, int minObjects, int maxObjects, const std::vector<GridCellType>& objectTypes);
+    int gridSize;
+    int minObjects;
+    int maxObjects;
+    CellIndex entryPos;
+    CellIndex exitPos;
+    std::vector<GridCellType> objectTypes;          // Types generation may place
+    std::vector<double> objectWeights;              // Relative frequency of each type
+    // Row-major cells. The outer ring is the sentinel border (Border, Entry or
+    // Exit), so the ball walk never needs a coordinate bounds check.
+    Cells gridCells;
+    std::vector<TeleporterPair> teleporterPairs;
+    // Ball walk of the last generation or simulation; step 0 is the entry
+    std::vector<PathStep> ballPath;
+    // Measures of ballPath
+    PathMetrics pathMetrics{};
+
+    // Constructor declaration only. objectWeights is optional; by default all
+    // object types are equally likely.
+    BasicGrid(int size, int minObjects, int maxObjects, const std::vector<GridCellType>& objectTypes,
+              const std::vector<double>& objectWeights = {});
 
     // Destructor
-    ~Grid() = default;
+    ~BasicGrid() = default;
+
+    // Replaces the configured object types; returns false (and leaves the grid
+    // unable to generate) if the types or weights are unusable
+    bool setObjectTypes(const std::vector<GridCellType>& types, const std::vector<double>& weights = {});
+
+    // Generates the grid dynamically from the configured object types. Returns
+    // GRID_STATUS_INVALID_ARGUMENT for an unusable configuration (including a
+    // side outside 3..Cells::MAX_SIDE) and
+    // GRID_STATUS_GENERATION_FAILED if no valid grid is found within
+    // MAX_GENERATION_ATTEMPTS.
+    GridStatus generateGrid(int attempt = 0);
+
+    // Generates a board for the same configuration by building the ball's
+    // walk backwards. It picks the exit first, then chains exactly minObjects
+    // objects back from it, using the transition table run backwards to find
+    // which direction the ball must arrive in. The entry is wherever the
+    // first ray meets the ring. Decoys are then placed as generateGrid does.
+    // Every object is entered once and every crossed cell stays empty, so
+    // the walk cannot loop or fall short. A chain that boxes itself in
+    // backtracks rather than starting over. A pass still can fail: some
+    // exits have no chain of minObjects behind them, and the backtracking
+    // stops after MAX_BACKWARD_TRIALS placements, so a failed pass starts
+    // over from another exit, up to MAX_GENERATION_ATTEMPTS times. The
+    // Level.swift configs and boards at up to one object per ten cells
+    // take one pass in 2000 boards of each; crowded boards take more, 2 on
+    // average for 40 on-path objects on a 10x10 board. Fails as
+    // generateGrid.
+    GridStatus generateGridBackward();
+
+    // Walks the ball from the entry over the current grid, caching the walk in
+    // ballPath, and returns the exit position, or INVALID_CELL if the ball
+    // never leaves the playfield
+    CellIndex simulate();
+
+    // Replaces the object at an interior cell and updates ballPath and exitPos,
+    // re-walking only from the first path step that touches the cell. type is
+    // Empty or a single-cell object type, with one of its viable orientations
+    // (None for Empty); replacing a teleporter also clears its partner.
+    GridStatus setCell(int row, int col, GridCellType type, Orientation orientation);
+
+    // Replaces the board with one built from its parts: the entry, on the
+    // border ring off its corners, and count single-cell objects on distinct
+    // interior cells, each with a viable orientation as setCell takes them.
+    // Keeps the configuration and simulates the ball. Returns
+    // GRID_STATUS_INVALID_ARGUMENT for a side the grid cannot hold or a part
+    // out of place, leaving the board empty.
+    GridStatus loadBoard(CellIndex entry, const BoardObject* objects, std::size_t count);
+
+    // Restarts the random sequence generation draws from. With the same seed
+    // and configuration, generateGrid gives the same boards in the same order
+    // with any compiler and standard library, so a level can be stored as its
+    // seed. The random sequence is the only state generation carries from
+    // one board to the next; teleporter symbols are reset with the board.
+    // Grids are seeded from std::random_device until this is called.
+    void seed(std::uint32_t value);
 
-    // Generates the grid dynamically
-    void generateGrid(std::vector<GridCellType>& objectTypes, int attempt = 0);
+    // 64-bit Zobrist fingerprint of the board: the entry, each object with
+    // its orientation and which teleporters are paired, but not teleporter
+    // symbols or the ball's path. Generation, setCell and loading keep it up
+    // to date as they place and remove objects, so reading it is free. Equal
+    // boards of a side have equal fingerprints.
+    std::uint64_t fingerprint() const { return boardFingerprint; }
+
+    // Whether other holds the same board, as fingerprint() sees it. Boards
+    // with different fingerprints are told apart by that one compare; equal
+    // fingerprints are confirmed on the cells, since they can collide.
+    bool sameBoard(const BasicGrid& other) const;
 
     std::string toASCII() const;
 
-    Pos getEntryPosition();
+    // Binary form of the board and its configuration (see GridFormat.h).
+    // serialize writes into out and sets written to the bytes used; if
+    // capacity is short it returns GRID_STATUS_BUFFER_TOO_SMALL with written
+    // set to the bytes needed. deserialize replaces the board and
+    // configuration and re-simulates the ball. If the header and
+    // configuration do not decode it leaves the grid as it was; if the board
+    // after them does not, it leaves the board empty under the new
+    // configuration. serialize does not allocate; deserialize allocates only
+    // to take a configuration other than the grid's, to outgrow the board
+    // lists of earlier loads, and for the teleporter partner map.
+    std::size_t serializedSize() const;
+    GridStatus serialize(std::uint8_t* out, std::size_t capacity, std::size_t& written) const;
+    GridStatus deserialize(const std::uint8_t* data, std::size_t size);
+
+    // Replaces the board and configuration with source's board turned or
+    // flipped by symmetry (see Symmetry.h), objects reoriented and teleporter
+    // pairs kept, and re-simulates the ball, so exitPos is source's exit
+    // transformed. source must be another grid with an entry on its border
+    // ring; otherwise returns GRID_STATUS_INVALID_ARGUMENT and leaves this
+    // grid unchanged.
+    GridStatus transformFrom(const BasicGrid& source, Symmetry symmetry);
+
+    CellIndex getEntryPosition();
 
     Orientation getViableOrientation(GridCellType type);
 
-    Direction getNewDirection(GridCellType type, Direction currentDirection, 
-                        Orientation orientation, const Pos& pos);
+    Direction getNewDirection(GridCellType type, Direction currentDirection,
+                        Orientation orientation, CellIndex pos);
+
+    // Side of the board: a constant for fixed-size storage, so index math
+    // and bounds compile to immediates
+    int side() const {
+        if constexpr (Cells::FIXED_SIZE > 0) {
+            return Cells::FIXED_SIZE;
+        } else {
+            return gridSize;
+        }
+    }
+
+    // Conversions between (row, column) and CellIndex
+    CellIndex toIndex(int row, int col) const {
+        return static_cast<CellIndex>(row) * static_cast<CellIndex>(side()) + static_cast<CellIndex>(col);
+    }
+    int rowOf(CellIndex index) const { return static_cast<int>(index / static_cast<CellIndex>(side())); }
+    int colOf(CellIndex index) const { return static_cast<int>(index % static_cast<CellIndex>(side())); }
+
+    // Cell access by coordinate. The writable form goes through
+    // Cells::edit, so on sparse storage it stores the cell. The walk is
+    // specialized on the configured object types, so objects written here
+    // must be of those types; setCell accepts any.
+    GridCell& cellAt(int row, int col) { return gridCells.edit(toIndex(row, col)); }
+    const GridCell& cellAt(int row, int col) const { return gridCells[toIndex(row, col)]; }
 
 private:
     mutable std::mt19937 rng;
     int getRandomInt(int min, int max) const;
-    
-    static const int MAX_GENERATION_ATTEMPTS = 50;
+
+    // Maximum number of unique teleporter symbols
+    static const int MAX_TELEPORTER_INDICES = 9;
+    // Bit i set once symbol i is in use on the board
+    unsigned usedTeleporterIndices = 0;
+
+    static const int MAX_GENERATION_ATTEMPTS = 1000;
+    // Object type draws that may fail in a row before placement gives up
+    static const int MAX_TYPE_DRAWS = 16;
+    // Random interior cells tried before scanning the board for an Empty one
+    static const int MAX_CELL_DRAWS = 32;
+    // Placements a backward chain may try, backtracking included, before the
+    // attempt picks another exit
+    static const int MAX_BACKWARD_TRIALS = 4096;
+
+    // XOR of the Zobrist keys of the board's entry, objects and teleporter
+    // pairs, over the key of an empty board of the side
+    std::uint64_t boardFingerprint = 0;
+    // Adds a cell's key to boardFingerprint, or removes it again
+    void toggleFingerprint(CellIndex pos, GridCellType type, Orientation orientation);
+
+    // Samples objectTypes by objectWeights, built once per configuration
+    AliasTable objectTypeTable;
+
+    // Index offset of one step in each Direction (Up, Down, Left, Right)
+    int stepDelta[4];
+    CellIndex stepOffset(Direction direction) const {
+        if constexpr (Cells::FIXED_SIZE > 0) {
+            constexpr int fixedDelta[4] = {-Cells::FIXED_SIZE, Cells::FIXED_SIZE, -1, 1};
+            return static_cast<CellIndex>(fixedDelta[static_cast<int>(direction)]);
+        } else {
+            return static_cast<CellIndex>(stepDelta[static_cast<int>(direction)]);
+        }
+    }
+    // Object behaviors the walk loops need code for. Bumpers, Tunnels and
+    // DirectionalBumpers all resolve through the transition table, so a
+    // kernel built without these has no per-type branches left in its step.
+    enum WalkFeature : unsigned {
+        WALK_TELEPORTER = 1u << 0,
+        WALK_ACTIVATED_BUMPER = 1u << 1,
+        WALK_ALL = WALK_TELEPORTER | WALK_ACTIVATED_BUMPER
+    };
+    static unsigned walkFeaturesOf(GridCellType type);
+    // Features of the configured types, and of those plus any type setCell has
+    // placed since the last generation; the kernels below are chosen by the
+    // latter whenever it changes, not per step
+    unsigned configuredFeatures;
+    unsigned walkFeatures;
+    CellIndex (BasicGrid::*resimulateKernel)(std::size_t);
+    bool (BasicGrid::*generateKernel)();
+    void selectKernels(unsigned features);
+    template <unsigned Features> CellIndex resimulateWith(std::size_t step);
+    template <unsigned Features> bool generateAttemptWith();
+    template <unsigned Features> Direction bounce(const GridCell& cell, CellIndex nextPos,
+                                                  Direction direction, CellIndex& landed);
+
+    // Teleporter cell to its partner, so teleporting is a lookup however many
+    // pairs the board holds
+    std::unordered_map<CellIndex, CellIndex> teleporterPartners;
+    // Objects with seenDirections set since the board last changed
+    std::vector<CellIndex> seenCells;
+    // Cells written since the last reset (path marks, objects, the entry)
+    std::vector<CellIndex> touchedCells;
+    // Scratch list of open cells when a crowded board is scanned
+    std::vector<CellIndex> openCells;
+    // Scratch bitmask of open cells along a ray
+    std::vector<std::uint64_t> openRayMask;
+
     // Helper functions
     void initializeGrid();
     void reset();
+    bool generateAttempt();
     std::string DirectionToString(Direction dir) const;
-    Direction getStartingDirection(const Pos& entryPos) const;
-    bool isWithinBounds(const Pos& pos) const;
-    std::vector<Pos> findOpenPositions(const Pos& currentPos, Direction currentDirection);
-    Pos getNextPosition(const Pos& currentPos, Direction direction) const;
-    bool isWithinCenter(const Pos& pos) const;
-    void initializeOpenPositions();
-    void updateOpenPositions(const Pos& currentPos, Direction currentDirection);
-    void removePosition(const Pos& pos);  // Helper to remove a position from openPositions
-    bool isPotentialNewObjectValid(Pos nextPos, Pos potentialPos, Direction currentDirection) const;
+    Direction getStartingDirection(CellIndex entryPos) const;
+    std::vector<CellIndex> findOpenPositions(CellIndex currentPos, Direction currentDirection);
+    std::uint32_t cellsToRing(CellIndex pos, Direction direction) const;
+    CellIndex getTeleporterPartner(CellIndex pos) const;
+    void addTeleporterPair(CellIndex first, CellIndex second, int index);
+    void removeTeleporterPair(CellIndex pos);
+    std::size_t firstAffectedStep(CellIndex pos) const;
+    void recordStep(CellIndex pos, CellIndex landed, Direction direction);
+    // Adds ballPath[step] to pathMetrics (sign 1) or takes it out (-1)
+    void countStep(std::size_t step, int sign);
+    void truncatePath(std::size_t step);
+    CellIndex resimulateFrom(std::size_t step);
+    bool revisits(CellIndex pos, Direction direction);
+    void forgetSeenStates();
+    bool isPotentialNewObjectValid(CellIndex nextPos, CellIndex potentialPos, Direction currentDirection) const;
     int getNextAvailableTeleporterIndex();
+    GridCellType sampleObjectType();
+    bool placeObject(CellIndex selectedPos, int& objectsPlaced);
+    CellIndex randomEmptyCell();
+    void placeDecoys(int& objectsPlaced);
+    bool generateBackwardAttempt();
+    bool chainBackward(CellIndex target, Direction direction, int objectsPlaced, int& trials);
+    bool placeBackward(CellIndex pos, CellIndex target, Direction direction, int objectsPlaced, int& trials);
 };
 
+using Grid = BasicGrid<DenseCells>;
+using SparseGrid = BasicGrid<SparseCells>;
+template <int N>
+using GridN = BasicGrid<FixedCells<N>>;
+
+// Instantiated once, in Grid.cpp: the generic engines and a GridN for each
+// side Level.swift uses
+extern template class BasicGrid<DenseCells>;
+extern template class BasicGrid<SparseCells>;
+extern template class BasicGrid<FixedCells<5>>;
+extern template class BasicGrid<FixedCells<6>>;
+extern template class BasicGrid<FixedCells<7>>;
+extern template class BasicGrid<FixedCells<10>>;
+
 #endif // GRID_H
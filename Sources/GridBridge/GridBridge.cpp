@@ -1,145 +1,443 @@
+#include <climits>
+#include <type_traits>
 #include "GridBridge.h"
-#include <iostream>
+#include "GridDispatch.h"
+#include "GridFormat.h"
+#include "GridLog.h"
+#include "LevelPack.h"
+
+namespace {
+    template <typename AnyEngine>
+    bool isWithinGrid(const AnyEngine* grid, int row, int col) {
+        return row >= 0 && row < grid->gridSize && col >= 0 && col < grid->gridSize;
+    }
+
+    // Cell at (row, col) as Swift sees it: the Border sentinel reads as Empty
+    template <typename AnyEngine>
+    int publicCellType(const AnyEngine* grid, int row, int col) {
+        GridCellType type = grid->gridCells[grid->toIndex(row, col)].type;
+        return static_cast<int>(type == GridCellType::Border ? GridCellType::Empty : type);
+    }
+
+    // Raw ints from Swift are checked against the enums before they are cast
+    bool isObjectTypeValue(int type) {
+        return type >= static_cast<int>(GridCellType::Bumper) && type <= static_cast<int>(GridCellType::DirectionalBumper);
+    }
+
+    bool isOrientationValue(int orientation) {
+        return orientation >= 0 && orientation <= static_cast<int>(Orientation::None);
+    }
+
+    // PackLevel_* handles point at a record in a mapped pack
+    PackLevel packLevel(const void* handle) {
+        return PackLevel(static_cast<const LevelPackFormat::LevelHeader*>(handle));
+    }
+
+    bool isWithinLevel(const PackLevel& level, int row, int col) {
+        return row >= 0 && row < level.side() && col >= 0 && col < level.side();
+    }
+
+    // Grid_* handles point at an AnyGrid, so each call runs the engine
+    // specialized for the board's side
+    template <typename Call>
+    auto withGrid(void* handle, Call call) {
+        return std::visit([&](auto& grid) { return call(grid); }, *static_cast<AnyGrid*>(handle));
+    }
+}
 
 extern "C" {
     void* Grid_Create(int size, int minObjects, int maxObjects, const int* objectTypes, int objectTypesCount) {
+        return Grid_CreateWeighted(size, minObjects, maxObjects, objectTypes, nullptr, objectTypesCount);
+    }
+
+    void* Grid_CreateWeighted(int size, int minObjects, int maxObjects, const int* objectTypes,
+                              const double* objectWeights, int objectTypesCount) {
+        if (size < 3 || size > MAX_GRID_SIZE || minObjects < 0 || maxObjects < minObjects
+            || objectTypesCount <= 0 || !objectTypes) {
+            GRID_LOG("C++: Invalid arguments to Grid_Create");
+            return nullptr;
+        }
+
         std::vector<GridCellType> types;
+        std::vector<double> weights;
         for (int i = 0; i < objectTypesCount; i++) {
+            if (!isObjectTypeValue(objectTypes[i])) {
+                GRID_LOG("C++: Grid_Create got unknown object type " << objectTypes[i]);
+                return nullptr;
+            }
             types.push_back(static_cast<GridCellType>(objectTypes[i]));
+            if (objectWeights) {
+                weights.push_back(objectWeights[i]);
+            }
+        }
+
+        AnyGrid* grid = new AnyGrid(makeGrid(size, minObjects, maxObjects, types));
+        if (!withGrid(grid, [&](auto& engine) { return engine.setObjectTypes(types, weights); })) {
+            GRID_LOG("C++: Grid_Create got unusable object types or weights");
+            delete grid;
+            return nullptr;
         }
-        return new Grid(size, minObjects, maxObjects, types);
+        return grid;
     }
 
     void destroy_grid(GridHandle handle) {
-        std::cout << "C++: Destroying grid..." << std::endl;
+        GRID_LOG("C++: Destroying grid...");
+        if (!handle) {
+            return;
+        }
         delete handle->grid;
         delete handle;
     }
 
-    void generate_grid(GridHandle handle) {
-        std::cout << "C++: Starting grid generation..." << std::endl;
-        std::cout.flush();
+    int generate_grid(GridHandle handle) {
+        GRID_LOG("C++: Starting grid generation...");
         
         if (!handle || !handle->grid) {
-            std::cout << "C++: Error - null grid!" << std::endl;
-            std::cout.flush();
-            return;
+            GRID_LOG("C++: Error - null grid!");
+            return GRID_STATUS_NULL_GRID;
         }
         
-        try {
-            std::vector<GridCellType> objects = {
-                GridCellType::Bumper,
-                GridCellType::DirectionalBumper,
-                GridCellType::Tunnel,
-                GridCellType::Teleporter,
-                GridCellType::ActivatedBumper
-            };
-            
-            handle->grid->generateGrid(objects, 0);
-            
-        } catch (const std::exception& e) {
-            std::cout << "C++: Exception caught: " << e.what() << std::endl;
-            std::cout.flush();
-        }
-    }
-
-    void Grid_GenerateGrid(void* grid) {
+        return handle->grid->generateGrid();
+    }
+
+    int Grid_GenerateGrid(void* grid) {
         if (!grid) {
-            std::cout << "C++: Error - null grid in Grid_GenerateGrid!" << std::endl;
-            return;
+            GRID_LOG("C++: Error - null grid in Grid_GenerateGrid!");
+            return GRID_STATUS_NULL_GRID;
         }
         
-        try {
-            Grid* actualGrid = static_cast<Grid*>(grid);
-            std::vector<GridCellType> objects = {
-                GridCellType::Bumper,
-                GridCellType::DirectionalBumper,
-                GridCellType::Tunnel,
-                GridCellType::Teleporter,
-                GridCellType::ActivatedBumper
-            };
-            actualGrid->generateGrid(objects, 0);
-        } catch (const std::exception& e) {
-            std::cout << "C++: Exception in Grid_GenerateGrid: " << e.what() << std::endl;
+        return withGrid(grid, [](auto& engine) { return engine.generateGrid(); });
+    }
+
+    int Grid_GenerateSeeded(void* grid, unsigned int seed) {
+        if (!grid) {
+            GRID_LOG("C++: Error - null grid in Grid_GenerateSeeded!");
+            return GRID_STATUS_NULL_GRID;
+        }
+
+        return withGrid(grid, [&](auto& engine) {
+            engine.seed(seed);
+            return engine.generateGrid();
+        });
+    }
+
+    int Grid_GenerateBackward(void* grid) {
+        if (!grid) {
+            GRID_LOG("C++: Error - null grid in Grid_GenerateBackward!");
+            return GRID_STATUS_NULL_GRID;
+        }
+
+        return withGrid(grid, [](auto& engine) { return engine.generateGridBackward(); });
+    }
+
+    int Grid_Transform(void* grid, int symmetry) {
+        if (!grid) {
+            GRID_LOG("C++: Error - null grid in Grid_Transform!");
+            return GRID_STATUS_NULL_GRID;
         }
+        if (symmetry < 0 || symmetry >= SYMMETRY_COUNT) {
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+
+        return withGrid(grid, [&](auto& engine) {
+            const auto source = engine;
+            return engine.transformFrom(source, static_cast<Symmetry>(symmetry));
+        });
     }
 
     int get_cell_type(GridHandle handle, int row, int col) {
         if (!handle || !handle->grid) {
-            std::cout << "C++: Null grid in get_cell_type" << std::endl;
+            GRID_LOG("C++: Null grid in get_cell_type");
             return 0;
         }
         
         Grid* grid = handle->grid;
-        if (row < 0 || row >= grid->gridSize || col < 0 || col >= grid->gridSize) {
-            std::cout << "C++: Out of bounds access in get_cell_type: " << row << "," << col << std::endl;
+        if (!isWithinGrid(grid, row, col)) {
+            GRID_LOG("C++: Out of bounds access in get_cell_type: " << row << "," << col);
             return 0;
         }
         
-        return static_cast<int>(grid->gridCells[row][col].type);
+        return publicCellType(grid, row, col);
     }
 
     int get_cell_orientation(GridHandle handle, int row, int col) {
         if (!handle || !handle->grid) {
-            std::cout << "C++: Null grid in get_cell_orientation" << std::endl;
+            GRID_LOG("C++: Null grid in get_cell_orientation");
             return 0;
         }
         
         Grid* grid = handle->grid;
-        if (row < 0 || row >= grid->gridSize || col < 0 || col >= grid->gridSize) {
-            std::cout << "C++: Out of bounds access in get_cell_orientation: " << row << "," << col << std::endl;
+        if (!isWithinGrid(grid, row, col)) {
+            GRID_LOG("C++: Out of bounds access in get_cell_orientation: " << row << "," << col);
             return 0;
         }
         
-        return static_cast<int>(grid->gridCells[row][col].orientation);
+        return static_cast<int>(grid->gridCells[grid->toIndex(row, col)].orientation);
     }
 
     bool test_bridge(void) {
-        std::cout << "C++: Test function called" << std::endl;
-        std::cout.flush();
+        GRID_LOG("C++: Test function called");
         return true;
     }
 
     void Grid_Destroy(void* grid) {
-        std::cout << "C++: Destroying grid..." << std::endl;
+        GRID_LOG("C++: Destroying grid...");
         if (grid) {
-            delete static_cast<Grid*>(grid);
+            delete static_cast<AnyGrid*>(grid);
         }
     }
 
     int Grid_GetCellType(void* grid, int row, int col) {
         if (!grid) {
-            std::cout << "C++: Null grid in Grid_GetCellType" << std::endl;
+            GRID_LOG("C++: Null grid in Grid_GetCellType");
             return 0;
         }
         
-        Grid* actualGrid = static_cast<Grid*>(grid);
-        if (row < 0 || row >= actualGrid->gridSize || col < 0 || col >= actualGrid->gridSize) {
-            std::cout << "C++: Out of bounds access in Grid_GetCellType: " << row << "," << col << std::endl;
+        return withGrid(grid, [&](auto& actualGrid) {
+            if (!isWithinGrid(&actualGrid, row, col)) {
+                GRID_LOG("C++: Out of bounds access in Grid_GetCellType: " << row << "," << col);
+                return 0;
+            }
+            return publicCellType(&actualGrid, row, col);
+        });
+    }
+
+    int Grid_GetCellOrientation(void* grid, int row, int col) {
+        if (!grid) {
+            GRID_LOG("C++: Null grid in Grid_GetCellOrientation");
             return 0;
         }
         
-        return static_cast<int>(actualGrid->gridCells[row][col].type);
+        return withGrid(grid, [&](auto& actualGrid) {
+            if (!isWithinGrid(&actualGrid, row, col)) {
+                GRID_LOG("C++: Out of bounds access in Grid_GetCellOrientation: " << row << "," << col);
+                return 0;
+            }
+            return static_cast<int>(actualGrid.gridCells[actualGrid.toIndex(row, col)].orientation);
+        });
     }
 
-    int Grid_GetCellOrientation(void* grid, int row, int col) {
+    int Grid_GetTeleporterIndex(void* grid, int row, int col) {
+        if (!grid) return 0;
+        return withGrid(grid, [&](auto& actualGrid) {
+            if (!isWithinGrid(&actualGrid, row, col)) return 0;
+            return actualGrid.gridCells[actualGrid.toIndex(row, col)].teleporterIndex;
+        });
+    }
+
+    int Grid_SetCell(void* grid, int row, int col, int type, int orientation) {
+        if (!grid) {
+            GRID_LOG("C++: Null grid in Grid_SetCell");
+            return GRID_STATUS_NULL_GRID;
+        }
+        if ((type != static_cast<int>(GridCellType::Empty) && !isObjectTypeValue(type))
+            || !isOrientationValue(orientation)) {
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+
+        return withGrid(grid, [&](auto& engine) {
+            return engine.setCell(row, col, static_cast<GridCellType>(type), static_cast<Orientation>(orientation));
+        });
+    }
+
+    int Grid_GetExit(void* grid, int* row, int* col) {
+        if (!grid) {
+            GRID_LOG("C++: Null grid in Grid_GetExit");
+            return GRID_STATUS_NULL_GRID;
+        }
+        if (!row || !col) {
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+
+        return withGrid(grid, [&](auto& actualGrid) {
+            bool exits = actualGrid.exitPos != INVALID_CELL;
+            *row = exits ? actualGrid.rowOf(actualGrid.exitPos) : -1;
+            *col = exits ? actualGrid.colOf(actualGrid.exitPos) : -1;
+            return static_cast<int>(GRID_STATUS_OK);
+        });
+    }
+
+    int Grid_GetPathMetrics(void* grid, GridPathMetrics* metrics) {
         if (!grid) {
-            std::cout << "C++: Null grid in Grid_GetCellOrientation" << std::endl;
+            return GRID_STATUS_NULL_GRID;
+        }
+        if (!metrics) {
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+        const PathMetrics path = withGrid(grid, [](auto& engine) { return engine.pathMetrics; });
+        metrics->steps = path.steps;
+        metrics->bounces = path.bounces;
+        metrics->directionChanges = path.directionChanges;
+        metrics->teleporterHops = path.teleporterHops;
+        metrics->selfCrossings = path.selfCrossings;
+        metrics->activatedPassThroughs = path.activatedPassThroughs;
+        return GRID_STATUS_OK;
+    }
+
+    int Grid_GetFingerprint(void* grid, unsigned long long* fingerprint) {
+        if (!grid) {
+            return GRID_STATUS_NULL_GRID;
+        }
+        if (!fingerprint) {
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+        *fingerprint = withGrid(grid, [](auto& engine) { return engine.fingerprint(); });
+        return GRID_STATUS_OK;
+    }
+
+    int Grid_Serialize(void* grid, unsigned char* buffer, int capacity, int* written) {
+        if (!grid) {
+            GRID_LOG("C++: Null grid in Grid_Serialize");
+            return GRID_STATUS_NULL_GRID;
+        }
+        if (!written || capacity < 0) {
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+
+        return withGrid(grid, [&](auto& engine) {
+            std::size_t bytes = 0;
+            GridStatus status = engine.serialize(buffer, static_cast<std::size_t>(capacity), bytes);
+            *written = bytes > INT_MAX ? INT_MAX : static_cast<int>(bytes);
+            return static_cast<int>(status);
+        });
+    }
+
+    int Grid_Deserialize(void* grid, const unsigned char* data, int size) {
+        if (!grid) {
+            GRID_LOG("C++: Null grid in Grid_Deserialize");
+            return GRID_STATUS_NULL_GRID;
+        }
+        int side = 0;
+        if (!data || size < 0 || !GridFormat::readSide(data, static_cast<std::size_t>(size), side) || side < 3) {
+            return GRID_STATUS_BAD_FORMAT;
+        }
+
+        // Boards of another side may need another engine
+        AnyGrid& any = *static_cast<AnyGrid*>(grid);
+        const bool fits = withGrid(grid, [&](auto& engine) {
+            using Engine = std::decay_t<decltype(engine)>;
+            constexpr int fixedSize = std::decay_t<decltype(engine.gridCells)>::FIXED_SIZE;
+            return fixedSize > 0 ? fixedSize == side
+                                 : !hasFixedEngine(side) && std::is_same_v<Engine, SparseGrid> == hasSparseEngine(side);
+        });
+        if (fits) {
+            return withGrid(grid, [&](auto& engine) {
+                return static_cast<int>(engine.deserialize(data, static_cast<std::size_t>(size)));
+            });
+        }
+        // Loaded into an engine of its own first, so a board that fails
+        // leaves the handle's engine, board and configuration untouched
+        AnyGrid loaded = makeGrid(side, 0, 0, {GridCellType::Bumper});
+        const GridStatus status = std::visit([&](auto& engine) {
+            return engine.deserialize(data, static_cast<std::size_t>(size));
+        }, loaded);
+        if (status == GRID_STATUS_OK) {
+            any = std::move(loaded);
+        }
+        return static_cast<int>(status);
+    }
+
+    void* LevelPack_Open(const char* path) {
+        LevelPack* pack = new LevelPack();
+        GridStatus status = pack->open(path);
+        if (status != GRID_STATUS_OK) {
+            GRID_LOG("C++: LevelPack_Open failed with status " << status);
+            delete pack;
+            return nullptr;
+        }
+        return pack;
+    }
+
+    void LevelPack_Close(void* pack) {
+        delete static_cast<LevelPack*>(pack);
+    }
+
+    int LevelPack_FindConfig(void* pack, int size, int minObjects, int maxObjects,
+                             const int* objectTypes, int objectTypesCount) {
+        if (!pack || (!objectTypes && objectTypesCount > 0)) {
+            return -1;
+        }
+        std::vector<GridCellType> types;
+        for (int i = 0; i < objectTypesCount; i++) {
+            if (!isObjectTypeValue(objectTypes[i])) {
+                return -1;
+            }
+            types.push_back(static_cast<GridCellType>(objectTypes[i]));
+        }
+        return static_cast<LevelPack*>(pack)->findConfig(size, minObjects, maxObjects, types);
+    }
+
+    int LevelPack_GetBucketCount(void* pack, int config) {
+        return pack ? static_cast<LevelPack*>(pack)->bucketCount(config) : 0;
+    }
+
+    long long LevelPack_GetLevelCount(void* pack, int config, int bucket) {
+        if (!pack) {
             return 0;
         }
-        
-        Grid* actualGrid = static_cast<Grid*>(grid);
-        if (row < 0 || row >= actualGrid->gridSize || col < 0 || col >= actualGrid->gridSize) {
-            std::cout << "C++: Out of bounds access in Grid_GetCellOrientation: " << row << "," << col << std::endl;
+        const std::uint64_t count = static_cast<LevelPack*>(pack)->levelCount(config, bucket);
+        return count > static_cast<std::uint64_t>(LLONG_MAX) ? LLONG_MAX : static_cast<long long>(count);
+    }
+
+    const void* LevelPack_GetLevel(void* pack, int config, int bucket, unsigned long long random) {
+        if (!pack) {
+            return nullptr;
+        }
+        return static_cast<LevelPack*>(pack)->level(config, bucket, random);
+    }
+
+    int LevelPack_GetLevelSeed(void* pack, int config, int bucket, unsigned long long random, unsigned int* seed,
+                               int* symmetry) {
+        if (!pack) {
+            return GRID_STATUS_NULL_GRID;
+        }
+        std::uint32_t found = 0;
+        Symmetry transform = Symmetry::Identity;
+        if (!seed || !symmetry || !static_cast<LevelPack*>(pack)->levelSeed(config, bucket, random, found, transform)) {
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+        *seed = found;
+        *symmetry = static_cast<int>(transform);
+        return GRID_STATUS_OK;
+    }
+
+    int PackLevel_GetSize(const void* level) {
+        return level ? packLevel(level).side() : 0;
+    }
+
+    int PackLevel_GetCellType(const void* level, int row, int col) {
+        if (!level || !isWithinLevel(packLevel(level), row, col)) {
             return 0;
         }
-        
-        return static_cast<int>(actualGrid->gridCells[row][col].orientation);
+        return static_cast<int>(packLevel(level).type(row, col));
     }
 
-    int Grid_GetTeleporterIndex(void* grid, int row, int col) {
-        if (!grid) return 0;
-        Grid* actualGrid = static_cast<Grid*>(grid);
-        return actualGrid->gridCells[row][col].teleporterIndex;
+    int PackLevel_GetCellOrientation(const void* level, int row, int col) {
+        if (!level || !isWithinLevel(packLevel(level), row, col)) {
+            return 0;
+        }
+        return static_cast<int>(packLevel(level).orientation(row, col));
+    }
+
+    int PackLevel_GetTeleporterIndex(const void* level, int row, int col) {
+        if (!level || !isWithinLevel(packLevel(level), row, col)) {
+            return 0;
+        }
+        return packLevel(level).teleporterIndex(row, col);
+    }
+
+    int PackLevel_GetExit(const void* level, int* row, int* col) {
+        if (!level) {
+            return GRID_STATUS_NULL_GRID;
+        }
+        if (!row || !col) {
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+        const PackLevel view = packLevel(level);
+        const CellIndex cells = static_cast<CellIndex>(view.side()) * static_cast<CellIndex>(view.side());
+        const bool exits = view.exit() < cells;
+        *row = exits ? static_cast<int>(view.exit() / static_cast<CellIndex>(view.side())) : -1;
+        *col = exits ? static_cast<int>(view.exit() % static_cast<CellIndex>(view.side())) : -1;
+        return GRID_STATUS_OK;
     }
-} 
\ No newline at end of file
+}
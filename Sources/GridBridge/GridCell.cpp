@@ -12,19 +12,22 @@ std::string orientationToString(Orientation orientation) {
         case Orientation::BottomRight: return "BottomRight";
         case Orientation::BottomLeft: return "BottomLeft";
         case Orientation::None: return "None";
-        default: throw std::invalid_argument("Unknown orientation");
+        default: return "Unknown";
     }
 }
 
 std::string GridCellTypeToString(GridCellType type) {
     switch (type) {
         case GridCellType::Empty: return "Empty";
+        case GridCellType::Entry: return "Entry";
+        case GridCellType::Exit: return "Exit";
+        case GridCellType::Border: return "Border";
         case GridCellType::InBallPath: return "InBallPath";
         case GridCellType::Teleporter: return "Teleporter";
         case GridCellType::Bumper: return "Bumper";
         case GridCellType::Tunnel: return "Tunnel";
         case GridCellType::ActivatedBumper: return "ActivatedBumper";
         case GridCellType::DirectionalBumper: return "DirectionalBumper";
-        default: throw std::invalid_argument("Unknown grid cell type");
+        default: return "Unknown";
     }
 }
\ No newline at end of file
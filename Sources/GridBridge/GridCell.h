@@ -1,10 +1,11 @@
 #ifndef GRID_CELL_H
 #define GRID_CELL_H
 
+#include <cstdint>
 #include <string>
 
 // Enum for Direction
-enum class Direction {
+enum class Direction : std::uint8_t {
     Up,
     Down,
     Left,
@@ -13,7 +14,7 @@ enum class Direction {
 };
 
 // Enum for Orientation
-enum class Orientation {
+enum class Orientation : std::uint8_t {
     DownRight,
     UpRight,
     Vertical,
@@ -26,7 +27,7 @@ enum class Orientation {
 };
 
 // Enum for GridCellType
-enum class GridCellType {
+enum class GridCellType : std::uint8_t {
     Empty = 0,
     Entry = 1,
     Exit = 2,
@@ -35,16 +36,50 @@ enum class GridCellType {
     Tunnel = 5,
     Teleporter = 6,
     ActivatedBumper = 7,
-    DirectionalBumper = 8
+    DirectionalBumper = 8,
+    Border = 9              // Sentinel ring around the playfield; never exposed to Swift
 };
 
-// Simple struct representing a cell in the grid
+// Bit set of the given cell type, used to classify cells with a single mask
+// test; 0 for a value past the mask's width, which then matches no class
+constexpr unsigned cellTypeBit(GridCellType type) {
+    return static_cast<unsigned>(type) < 32 ? 1u << static_cast<unsigned>(type) : 0;
+}
+
+// Cells on the sentinel ring: reaching one of these ends the ball's walk
+constexpr unsigned BORDER_CELL_TYPES = cellTypeBit(GridCellType::Border)
+                                     | cellTypeBit(GridCellType::Entry)
+                                     | cellTypeBit(GridCellType::Exit);
+
+// Cells that change the ball's direction or position
+constexpr unsigned OBJECT_CELL_TYPES = cellTypeBit(GridCellType::Bumper)
+                                     | cellTypeBit(GridCellType::Tunnel)
+                                     | cellTypeBit(GridCellType::Teleporter)
+                                     | cellTypeBit(GridCellType::ActivatedBumper)
+                                     | cellTypeBit(GridCellType::DirectionalBumper);
+
+constexpr bool isBorderCell(GridCellType type) {
+    return (cellTypeBit(type) & BORDER_CELL_TYPES) != 0;
+}
+
+constexpr bool isObjectCell(GridCellType type) {
+    return (cellTypeBit(type) & OBJECT_CELL_TYPES) != 0;
+}
+
+// firstVisit of a cell the cached ball walk has not reached
+constexpr std::int32_t NOT_VISITED = -1;
+
+// Simple struct representing a cell in the grid. The walk bookkeeping lives
+// in the cell, so storage that keeps only non-empty cells keeps it only for
+// cells the ball touches.
 struct GridCell {
     GridCellType type = GridCellType::Empty;
     Direction direction = Direction::None;
     Orientation orientation = Orientation::None;
-    int teleporterIndex = 0;
     bool hasBeenActivated = false;
+    std::uint8_t seenDirections = 0;          // Loop detection, one bit per Direction
+    int teleporterIndex = 0;
+    std::int32_t firstVisit = NOT_VISITED;    // First ballPath step touching the cell
 };
 
 // Add this declaration near the other function declarations
@@ -0,0 +1,43 @@
+#ifndef GRID_DISPATCH_H
+#define GRID_DISPATCH_H
+
+#include <variant>
+#include <vector>
+#include "Grid.h"
+
+// A grid engine chosen once by side: the GridN instantiation for the sides
+// Level.swift uses, SparseGrid for large boards, the generic Grid for any
+// other. Use std::visit to call it.
+using AnyGrid = std::variant<Grid, GridN<5>, GridN<6>, GridN<7>, GridN<10>, SparseGrid>;
+
+// Smallest side makeGrid gives sparse storage. Below it dense storage takes
+// at most 16 MiB and its array loads beat hash probes; above it dense memory
+// grows with the area while a generated board stays mostly empty.
+constexpr int MIN_SPARSE_GRID_SIZE = 1025;
+
+// True for the sides makeGrid gives a GridN engine
+constexpr bool hasFixedEngine(int size) {
+    return size == 5 || size == 6 || size == 7 || size == 10;
+}
+
+// True for the sides makeGrid gives a SparseGrid
+constexpr bool hasSparseEngine(int size) {
+    return size >= MIN_SPARSE_GRID_SIZE;
+}
+
+inline AnyGrid makeGrid(int size, int minObjects, int maxObjects, const std::vector<GridCellType>& objectTypes,
+                        const std::vector<double>& objectWeights = {}) {
+    switch (size) {
+        case 5:  return AnyGrid(std::in_place_type<GridN<5>>, size, minObjects, maxObjects, objectTypes, objectWeights);
+        case 6:  return AnyGrid(std::in_place_type<GridN<6>>, size, minObjects, maxObjects, objectTypes, objectWeights);
+        case 7:  return AnyGrid(std::in_place_type<GridN<7>>, size, minObjects, maxObjects, objectTypes, objectWeights);
+        case 10: return AnyGrid(std::in_place_type<GridN<10>>, size, minObjects, maxObjects, objectTypes, objectWeights);
+        default: break;
+    }
+    if (hasSparseEngine(size)) {
+        return AnyGrid(std::in_place_type<SparseGrid>, size, minObjects, maxObjects, objectTypes, objectWeights);
+    }
+    return AnyGrid(std::in_place_type<Grid>, size, minObjects, maxObjects, objectTypes, objectWeights);
+}
+
+#endif // GRID_DISPATCH_H
@@ -0,0 +1,453 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include "Grid.h"
+#include "GridFormat.h"
+
+namespace {
+    struct CellCode {
+        GridCellType type;
+        Orientation orientation;
+    };
+
+    // Index is the 4-bit code stored for a cell
+    constexpr CellCode CELL_CODES[] = {
+        {GridCellType::Empty, Orientation::None},
+        {GridCellType::Bumper, Orientation::DownRight},
+        {GridCellType::Bumper, Orientation::UpRight},
+        {GridCellType::Tunnel, Orientation::Vertical},
+        {GridCellType::Tunnel, Orientation::Horizontal},
+        {GridCellType::Teleporter, Orientation::None},
+        {GridCellType::ActivatedBumper, Orientation::DownRight},
+        {GridCellType::ActivatedBumper, Orientation::UpRight},
+        {GridCellType::DirectionalBumper, Orientation::TopRight},
+        {GridCellType::DirectionalBumper, Orientation::TopLeft},
+        {GridCellType::DirectionalBumper, Orientation::BottomRight},
+        {GridCellType::DirectionalBumper, Orientation::BottomLeft},
+    };
+    constexpr std::uint8_t CELL_CODE_COUNT = sizeof(CELL_CODES) / sizeof(CELL_CODES[0]);
+    constexpr std::uint8_t NO_CODE = 0xFF;
+
+    // Code of a cell, 0 for one without an object, or NO_CODE for an object
+    // in an orientation it cannot take
+    std::uint8_t cellCode(const GridCell& cell) {
+        if (!isObjectCell(cell.type)) {
+            return 0;
+        }
+        for (std::uint8_t code = 1; code < CELL_CODE_COUNT; code++) {
+            if (CELL_CODES[code].type == cell.type
+                && (cell.type == GridCellType::Teleporter || CELL_CODES[code].orientation == cell.orientation)) {
+                return code;
+            }
+        }
+        return NO_CODE;
+    }
+
+    std::size_t varintSize(std::uint32_t value) {
+        std::size_t bytes = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            bytes++;
+        }
+        return bytes;
+    }
+
+    std::uint8_t* writeVarint(std::uint8_t* out, std::uint32_t value) {
+        while (value >= 0x80) {
+            *out++ = static_cast<std::uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<std::uint8_t>(value);
+        return out;
+    }
+
+    // Reads past the end or malformed varints clear ok; later reads return 0
+    struct Reader {
+        const std::uint8_t* next;
+        const std::uint8_t* end;
+        bool ok = true;
+
+        std::uint8_t byte() {
+            if (next == end) {
+                ok = false;
+                return 0;
+            }
+            return *next++;
+        }
+
+        std::uint32_t varint() {
+            std::uint64_t value = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                std::uint8_t b = byte();
+                value |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+                if ((b & 0x80) == 0) {
+                    if (value > UINT32_MAX) break;
+                    return static_cast<std::uint32_t>(value);
+                }
+            }
+            ok = false;
+            return 0;
+        }
+
+        bool readHeader(std::uint8_t& flags) {
+            for (std::uint8_t expected : GridFormat::MAGIC) {
+                if (byte() != expected) {
+                    return false;
+                }
+            }
+            if (byte() != GridFormat::VERSION) {
+                return false;
+            }
+            flags = byte();
+            return ok && (flags & ~GridFormat::KNOWN_FLAGS) == 0;
+        }
+    };
+
+    // How the cells of a board are written: the shorter of the two encodings
+    struct CellLayout {
+        std::size_t bytes = 0;
+        bool objectList = false;
+        bool valid = true;
+    };
+
+    template <typename Engine>
+    CellLayout cellLayout(const Engine& grid) {
+        const int inner = grid.side() - 2;
+        const std::uint64_t interior = static_cast<std::uint64_t>(inner) * inner;
+        CellLayout layout;
+        std::uint32_t objects = 0;
+        std::size_t listBytes = 0;
+        std::uint32_t previous = 0;
+        for (int row = 1; row <= inner; row++) {
+            for (int col = 1; col <= inner; col++) {
+                const std::uint8_t code = cellCode(grid.cellAt(row, col));
+                if (code == NO_CODE) {
+                    layout.valid = false;
+                    return layout;
+                }
+                if (code != 0) {
+                    const std::uint32_t index = static_cast<std::uint32_t>((row - 1) * inner + (col - 1));
+                    listBytes += varintSize(index - (objects == 0 ? 0 : previous + 1)) + 1;
+                    previous = index;
+                    objects++;
+                }
+            }
+        }
+        listBytes += varintSize(objects);
+        const std::size_t planeBytes = static_cast<std::size_t>((interior + 1) / 2);
+        layout.objectList = listBytes < planeBytes;
+        layout.bytes = layout.objectList ? listBytes : planeBytes;
+        return layout;
+    }
+
+    // Entries sit on the border ring, off its corners
+    bool isEntryCell(CellIndex pos, int gridSize, std::size_t cellCount) {
+        const int row = static_cast<int>(pos / static_cast<CellIndex>(gridSize));
+        const int col = static_cast<int>(pos % static_cast<CellIndex>(gridSize));
+        const bool corner = (row == 0 || row == gridSize - 1) && (col == 0 || col == gridSize - 1);
+        return pos < cellCount && isRingCell(pos, gridSize) && !corner;
+    }
+
+    bool uniformWeights(const std::vector<double>& weights) {
+        for (double weight : weights) {
+            if (weight != 1.0) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool GridFormat::readSide(const std::uint8_t* data, std::size_t size, int& side) {
+    Reader in{data, data + size};
+    std::uint8_t flags = 0;
+    if (!data || !in.readHeader(flags)) {
+        return false;
+    }
+    std::uint32_t value = in.varint();
+    if (!in.ok || value > static_cast<std::uint32_t>(MAX_GRID_SIZE)) {
+        return false;
+    }
+    side = static_cast<int>(value);
+    return true;
+}
+
+template <typename Cells>
+std::size_t BasicGrid<Cells>::serializedSize() const {
+    const CellLayout layout = cellLayout(*this);
+    if (!layout.valid || gridSize != side() || !isEntryCell(entryPos, gridSize, gridCells.size()) || minObjects < 0 || maxObjects < 0 || objectTypes.size() > UINT8_MAX
+        || objectWeights.size() != objectTypes.size()) {
+        return 0;
+    }
+
+    std::size_t bytes = sizeof(GridFormat::MAGIC) + 2;
+    bytes += varintSize(static_cast<std::uint32_t>(gridSize));
+    bytes += varintSize(static_cast<std::uint32_t>(minObjects)) + varintSize(static_cast<std::uint32_t>(maxObjects));
+    bytes += 1 + objectTypes.size();
+    if (!uniformWeights(objectWeights)) {
+        bytes += objectWeights.size() * sizeof(double);
+    }
+    bytes += varintSize(entryPos) + varintSize(ballPath.empty() ? 0 : exitPos + 1);
+    bytes += layout.bytes;
+    bytes += varintSize(static_cast<std::uint32_t>(teleporterPairs.size()));
+    for (const TeleporterPair& pair : teleporterPairs) {
+        if (pair.index < 0 || pair.index >= MAX_TELEPORTER_INDICES) {
+            return 0;
+        }
+        bytes += varintSize(pair.first) + varintSize(pair.second) + 1;
+    }
+    return bytes;
+}
+
+template <typename Cells>
+GridStatus BasicGrid<Cells>::serialize(std::uint8_t* out, std::size_t capacity, std::size_t& written) const {
+    written = serializedSize();
+    if (written == 0) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+    if (!out || capacity < written) {
+        return GRID_STATUS_BUFFER_TOO_SMALL;
+    }
+
+    const CellLayout layout = cellLayout(*this);
+    const bool weighted = !uniformWeights(objectWeights);
+    std::memcpy(out, GridFormat::MAGIC, sizeof(GridFormat::MAGIC));
+    out += sizeof(GridFormat::MAGIC);
+    *out++ = GridFormat::VERSION;
+    *out++ = static_cast<std::uint8_t>((weighted ? GridFormat::FLAG_WEIGHTED : 0)
+                                       | (layout.objectList ? GridFormat::FLAG_OBJECT_LIST : 0)
+                                       | (ballPath.empty() ? GridFormat::FLAG_UNWALKED : 0));
+    out = writeVarint(out, static_cast<std::uint32_t>(gridSize));
+    out = writeVarint(out, static_cast<std::uint32_t>(minObjects));
+    out = writeVarint(out, static_cast<std::uint32_t>(maxObjects));
+    *out++ = static_cast<std::uint8_t>(objectTypes.size());
+    for (GridCellType type : objectTypes) {
+        *out++ = static_cast<std::uint8_t>(type);
+    }
+    if (weighted) {
+        for (double weight : objectWeights) {
+            std::uint64_t bits = 0;
+            std::memcpy(&bits, &weight, sizeof(bits));
+            for (int i = 0; i < 8; i++) {
+                *out++ = static_cast<std::uint8_t>(bits >> (8 * i));
+            }
+        }
+    }
+    out = writeVarint(out, entryPos);
+    out = writeVarint(out, ballPath.empty() ? 0 : exitPos + 1);
+
+    const int inner = side() - 2;
+    if (layout.objectList) {
+        std::uint8_t* countAt = out;
+        std::uint32_t objects = 0;
+        for (int row = 1; row <= inner; row++) {
+            for (int col = 1; col <= inner; col++) {
+                objects += cellCode(cellAt(row, col)) != 0 ? 1 : 0;
+            }
+        }
+        out = writeVarint(countAt, objects);
+        std::uint32_t next = 0;
+        for (int row = 1; row <= inner; row++) {
+            for (int col = 1; col <= inner; col++) {
+                const std::uint8_t code = cellCode(cellAt(row, col));
+                if (code != 0) {
+                    const std::uint32_t index = static_cast<std::uint32_t>((row - 1) * inner + (col - 1));
+                    out = writeVarint(out, index - next);
+                    *out++ = code;
+                    next = index + 1;
+                }
+            }
+        }
+    } else {
+        std::memset(out, 0, layout.bytes);
+        std::size_t nibble = 0;
+        for (int row = 1; row <= inner; row++) {
+            for (int col = 1; col <= inner; col++, nibble++) {
+                out[nibble / 2] |= static_cast<std::uint8_t>(cellCode(cellAt(row, col)) << (4 * (nibble % 2)));
+            }
+        }
+        out += layout.bytes;
+    }
+
+    out = writeVarint(out, static_cast<std::uint32_t>(teleporterPairs.size()));
+    for (const TeleporterPair& pair : teleporterPairs) {
+        out = writeVarint(out, pair.first);
+        out = writeVarint(out, pair.second);
+        *out++ = static_cast<std::uint8_t>(pair.index);
+    }
+    return GRID_STATUS_OK;
+}
+
+template <typename Cells>
+GridStatus BasicGrid<Cells>::deserialize(const std::uint8_t* data, std::size_t size) {
+    Reader in{data, data + size};
+    std::uint8_t flags = 0;
+    if (!data || !in.readHeader(flags)) {
+        return GRID_STATUS_BAD_FORMAT;
+    }
+
+    const std::uint32_t newSize = in.varint();
+    const std::uint32_t newMin = in.varint();
+    const std::uint32_t newMax = in.varint();
+    if (!in.ok || newSize < 3 || newSize > static_cast<std::uint32_t>(MAX_GRID_SIZE)
+        || newMin > INT_MAX || newMax > INT_MAX) {
+        return GRID_STATUS_BAD_FORMAT;
+    }
+    if ((Cells::FIXED_SIZE > 0 && newSize != static_cast<std::uint32_t>(Cells::FIXED_SIZE))
+        || newSize > static_cast<std::uint32_t>(Cells::MAX_SIDE)) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+
+    // The configuration is decoded into arrays on the stack and checked, as
+    // AliasTable::build checks weights, before any of it replaces the grid's,
+    // so a bad header leaves the grid as it was
+    const std::uint8_t typeCount = in.byte();
+    GridCellType types[UINT8_MAX];
+    double weights[UINT8_MAX];
+    for (std::uint8_t i = 0; i < typeCount; i++) {
+        types[i] = static_cast<GridCellType>(in.byte());
+        weights[i] = 1.0;
+        if (!isObjectCell(types[i])) {
+            return GRID_STATUS_BAD_FORMAT;
+        }
+    }
+    double totalWeight = 0.0;
+    for (std::uint8_t i = 0; i < typeCount; i++) {
+        if (flags & GridFormat::FLAG_WEIGHTED) {
+            std::uint64_t bits = 0;
+            for (int b = 0; b < 8; b++) {
+                bits |= static_cast<std::uint64_t>(in.byte()) << (8 * b);
+            }
+            std::memcpy(&weights[i], &bits, sizeof(double));
+        }
+        if (!std::isfinite(weights[i]) || weights[i] < 0.0) {
+            return GRID_STATUS_BAD_FORMAT;
+        }
+        totalWeight += weights[i];
+    }
+    if (!in.ok || typeCount == 0 || !(totalWeight > 0.0) || !std::isfinite(totalWeight)) {
+        return GRID_STATUS_BAD_FORMAT;
+    }
+
+    // Levels of one configuration are loaded one after another; only a new
+    // configuration copies into the grid's vectors and rebuilds its table
+    if (objectTypes.size() != typeCount || objectWeights.size() != typeCount || !std::equal(types, types + typeCount, objectTypes.begin())
+        || !std::equal(weights, weights + typeCount, objectWeights.begin())) {
+        objectTypes.assign(types, types + typeCount);
+        objectWeights.assign(weights, weights + typeCount);
+        setObjectTypes(objectTypes, objectWeights);
+    }
+    gridSize = static_cast<int>(newSize);
+    minObjects = static_cast<int>(newMin);
+    maxObjects = static_cast<int>(newMax);
+    reset();
+
+    auto fail = [this] {
+        reset();
+        return GRID_STATUS_BAD_FORMAT;
+    };
+
+    const CellIndex entry = in.varint();
+    const std::uint32_t storedExit = in.varint();
+    if (!in.ok || !isEntryCell(entry, gridSize, gridCells.size())) {
+        return fail();
+    }
+    entryPos = entry;
+    gridCells.edit(entryPos).type = GridCellType::Entry;
+    touchedCells.push_back(entryPos);
+    toggleFingerprint(entryPos, GridCellType::Entry, Orientation::None);
+
+    unsigned features = configuredFeatures;
+    int teleporterCells = 0;
+    const int inner = gridSize - 2;
+    const std::uint64_t interior = static_cast<std::uint64_t>(inner) * inner;
+    auto place = [&](std::uint64_t index, std::uint8_t code) {
+        const CellIndex pos = toIndex(static_cast<int>(index / inner) + 1, static_cast<int>(index % inner) + 1);
+        GridCell& cell = gridCells.edit(pos);
+        cell.type = CELL_CODES[code].type;
+        cell.orientation = CELL_CODES[code].orientation;
+        touchedCells.push_back(pos);
+        if (cell.type != GridCellType::Teleporter) {
+            toggleFingerprint(pos, cell.type, cell.orientation);
+        }
+        features |= walkFeaturesOf(cell.type);
+        teleporterCells += cell.type == GridCellType::Teleporter ? 1 : 0;
+    };
+
+    if (flags & GridFormat::FLAG_OBJECT_LIST) {
+        const std::uint32_t objects = in.varint();
+        if (objects > interior) {
+            return fail();
+        }
+        std::uint64_t index = 0;
+        for (std::uint32_t i = 0; i < objects && in.ok; i++) {
+            index += in.varint();
+            const std::uint8_t code = in.byte();
+            if (index >= interior || code == 0 || code >= CELL_CODE_COUNT) {
+                return fail();
+            }
+            place(index++, code);
+        }
+    } else {
+        if (static_cast<std::uint64_t>(in.end - in.next) < (interior + 1) / 2) {
+            return fail();
+        }
+        for (std::uint64_t index = 0; index < interior; index++) {
+            const std::uint8_t code = (in.next[index / 2] >> (4 * (index % 2))) & 0x0F;
+            if (code >= CELL_CODE_COUNT) {
+                return fail();
+            }
+            if (code != 0) {
+                place(index, code);
+            }
+        }
+        in.next += (interior + 1) / 2;
+    }
+
+    // Every teleporter is in exactly one pair
+    const std::uint32_t pairs = in.varint();
+    if (!in.ok || static_cast<std::uint64_t>(pairs) * 2 != static_cast<std::uint64_t>(teleporterCells)) {
+        return fail();
+    }
+    for (std::uint32_t i = 0; i < pairs; i++) {
+        const CellIndex first = in.varint();
+        const CellIndex second = in.varint();
+        const int index = in.byte();
+        if (!in.ok || index >= MAX_TELEPORTER_INDICES || first >= gridCells.size() || second >= gridCells.size() || first == second
+            || gridCells[first].type != GridCellType::Teleporter || gridCells[second].type != GridCellType::Teleporter
+            || teleporterPartners.count(first) != 0 || teleporterPartners.count(second) != 0) {
+            return fail();
+        }
+        addTeleporterPair(first, second, index);
+    }
+    if (!in.ok || in.next != in.end) {
+        return fail();
+    }
+
+    selectKernels(features);
+    const CellIndex exit = simulate();
+    if ((flags & GridFormat::FLAG_UNWALKED) == 0 && exit + 1 != storedExit) {
+        return fail();
+    }
+    return GRID_STATUS_OK;
+}
+
+template std::size_t BasicGrid<DenseCells>::serializedSize() const;
+template GridStatus BasicGrid<DenseCells>::serialize(std::uint8_t*, std::size_t, std::size_t&) const;
+template GridStatus BasicGrid<DenseCells>::deserialize(const std::uint8_t*, std::size_t);
+template std::size_t BasicGrid<SparseCells>::serializedSize() const;
+template GridStatus BasicGrid<SparseCells>::serialize(std::uint8_t*, std::size_t, std::size_t&) const;
+template GridStatus BasicGrid<SparseCells>::deserialize(const std::uint8_t*, std::size_t);
+template std::size_t BasicGrid<FixedCells<5>>::serializedSize() const;
+template GridStatus BasicGrid<FixedCells<5>>::serialize(std::uint8_t*, std::size_t, std::size_t&) const;
+template GridStatus BasicGrid<FixedCells<5>>::deserialize(const std::uint8_t*, std::size_t);
+template std::size_t BasicGrid<FixedCells<6>>::serializedSize() const;
+template GridStatus BasicGrid<FixedCells<6>>::serialize(std::uint8_t*, std::size_t, std::size_t&) const;
+template GridStatus BasicGrid<FixedCells<6>>::deserialize(const std::uint8_t*, std::size_t);
+template std::size_t BasicGrid<FixedCells<7>>::serializedSize() const;
+template GridStatus BasicGrid<FixedCells<7>>::serialize(std::uint8_t*, std::size_t, std::size_t&) const;
+template GridStatus BasicGrid<FixedCells<7>>::deserialize(const std::uint8_t*, std::size_t);
+template std::size_t BasicGrid<FixedCells<10>>::serializedSize() const;
+template GridStatus BasicGrid<FixedCells<10>>::serialize(std::uint8_t*, std::size_t, std::size_t&) const;
+template GridStatus BasicGrid<FixedCells<10>>::deserialize(const std::uint8_t*, std::size_t);
@@ -0,0 +1,47 @@
+#ifndef GRID_FORMAT_H
+#define GRID_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Binary grid format, written by BasicGrid::serialize. Integers marked
+// varint are unsigned LEB128; everything else is bytes.
+//
+//   magic       "PPGR"
+//   version     VERSION
+//   flags       FLAG_*
+//   side, minObjects, maxObjects                      varints
+//   type count, then one GridCellType byte per type
+//   weights     one little-endian IEEE double per type, if FLAG_WEIGHTED
+//   entry       varint CellIndex
+//   exit        varint, CellIndex + 1, or 0 if the ball never leaves or
+//               FLAG_UNWALKED is set
+//   cells       FLAG_OBJECT_LIST clear: one 4-bit cell code per interior
+//               cell, row-major, low nibble first
+//               FLAG_OBJECT_LIST set: varint object count, then per object
+//               a varint gap from the previous interior index and a code
+//   pairs       varint count, then per pair two varint CellIndexes and the
+//               teleporter index byte, below the 9 symbols
+//
+// Cell codes cover every object type and orientation, with 0 for a cell
+// without an object. The writer picks whichever cell encoding is shorter:
+// the nibbles for level-sized boards, the list for large sparse ones. Path
+// marks are not stored; loading re-simulates the ball and checks the exit.
+// A board needs an entry on its border ring to be saved.
+namespace GridFormat {
+    constexpr std::uint8_t MAGIC[4] = {'P', 'P', 'G', 'R'};
+    constexpr std::uint8_t VERSION = 1;
+
+    constexpr std::uint8_t FLAG_WEIGHTED = 1u << 0;
+    constexpr std::uint8_t FLAG_OBJECT_LIST = 1u << 1;
+    // Saved before the ball was walked, so there is no exit to check
+    constexpr std::uint8_t FLAG_UNWALKED = 1u << 2;
+    constexpr std::uint8_t KNOWN_FLAGS = FLAG_WEIGHTED | FLAG_OBJECT_LIST | FLAG_UNWALKED;
+
+    // Board side of a serialized grid, without decoding the rest, so a
+    // caller can pick the engine to load it into. Returns false if data does
+    // not start with a readable header of this version.
+    bool readSide(const std::uint8_t* data, std::size_t size, int& side);
+}
+
+#endif // GRID_FORMAT_H
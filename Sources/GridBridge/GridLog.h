@@ -0,0 +1,13 @@
+#ifndef GRID_LOG_H
+#define GRID_LOG_H
+
+// Generation tracing. Compiled out unless GRID_VERBOSE is defined, so the
+// per-step messages cost nothing in the ball walk.
+#ifdef GRID_VERBOSE
+#include <iostream>
+#define GRID_LOG(message) do { std::cout << message << std::endl; } while (0)
+#else
+#define GRID_LOG(message) do { } while (0)
+#endif
+
+#endif // GRID_LOG_H
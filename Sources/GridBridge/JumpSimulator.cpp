@@ -0,0 +1,156 @@
+#include <algorithm>
+#include "JumpSimulator.h"
+#include "DirectionMaps.h"
+
+template <typename Cells>
+void JumpSimulator::build(const BasicGrid<Cells>& grid) {
+    gridSize = grid.side();
+    objectPos.clear();
+    objectType.clear();
+    objectOrientation.clear();
+    rowStart.assign(gridSize + 1, 0);
+    colStart.assign(gridSize + 1, 0);
+
+    grid.gridCells.forEachStored([this](CellIndex pos, const GridCell& cell) {
+        if (isObjectCell(cell.type)) {
+            objectPos.push_back(pos);
+        }
+    });
+    // Sparse storage holds its cells in hash order
+    if constexpr (!Cells::CONTIGUOUS) {
+        std::sort(objectPos.begin(), objectPos.end());
+    }
+    for (CellIndex pos : objectPos) {
+        const GridCell& cell = grid.gridCells[pos];
+        objectType.push_back(cell.type);
+        objectOrientation.push_back(cell.orientation);
+        rowStart[grid.rowOf(pos) + 1]++;
+        colStart[grid.colOf(pos) + 1]++;
+    }
+    for (int i = 0; i < gridSize; i++) {
+        rowStart[i + 1] += rowStart[i];
+        colStart[i + 1] += colStart[i];
+    }
+
+    // Ids arrive in row-major order, so each column fills in row order
+    colIds.resize(objectPos.size());
+    std::vector<std::uint32_t> colFill(colStart.begin(), colStart.end() - 1);
+    for (std::uint32_t id = 0; id < objectPos.size(); id++) {
+        colIds[colFill[grid.colOf(objectPos[id])]++] = id;
+    }
+
+    objectPartner.resize(objectPos.size());
+    for (std::uint32_t id = 0; id < objectPos.size(); id++) {
+        objectPartner[id] = id;
+    }
+    for (const TeleporterPair& pair : grid.teleporterPairs) {
+        std::uint32_t first = idAt(pair.first);
+        std::uint32_t second = idAt(pair.second);
+        if (first != NO_OBJECT && second != NO_OBJECT) {
+            objectPartner[first] = second;
+            objectPartner[second] = first;
+        }
+    }
+
+    activated.assign(objectPos.size(), 0);
+    activatedIds.clear();
+}
+
+std::uint32_t JumpSimulator::idAt(CellIndex pos) const {
+    auto first = objectPos.begin() + rowStart[pos / gridSize];
+    auto last = objectPos.begin() + rowStart[pos / gridSize + 1];
+    auto found = std::lower_bound(first, last, pos);
+    return found != last && *found == pos ? static_cast<std::uint32_t>(found - objectPos.begin()) : NO_OBJECT;
+}
+
+// Id of the first object after pos in direction, or NO_OBJECT with the border
+// cell the ball reaches instead
+std::uint32_t JumpSimulator::nextObject(CellIndex pos, Direction direction, CellIndex& borderPos) const {
+    // CellIndex math: on the largest boards positions pass INT_MAX
+    const CellIndex side = static_cast<CellIndex>(gridSize);
+    const CellIndex row = pos / side;
+    const CellIndex col = pos % side;
+
+    if (direction == Direction::Left || direction == Direction::Right) {
+        auto first = objectPos.begin() + rowStart[row];
+        auto last = objectPos.begin() + rowStart[row + 1];
+        if (direction == Direction::Right) {
+            auto found = std::upper_bound(first, last, pos);
+            if (found != last) return static_cast<std::uint32_t>(found - objectPos.begin());
+            borderPos = row * side + side - 1;
+        } else {
+            auto found = std::lower_bound(first, last, pos);
+            if (found != first) return static_cast<std::uint32_t>(found - 1 - objectPos.begin());
+            borderPos = row * side;
+        }
+        return NO_OBJECT;
+    }
+
+    auto first = colIds.begin() + colStart[col];
+    auto last = colIds.begin() + colStart[col + 1];
+    auto rowBefore = [this](std::uint32_t id, CellIndex p) { return objectPos[id] < p; };
+    auto found = std::lower_bound(first, last, pos, rowBefore);
+    if (direction == Direction::Down) {
+        if (found != last && objectPos[*found] == pos) ++found;
+        if (found != last) return *found;
+        borderPos = (side - 1) * side + col;
+    } else {
+        if (found != first) return *(found - 1);
+        borderPos = col;
+    }
+    return NO_OBJECT;
+}
+
+EntryExit JumpSimulator::simulate(CellIndex entry) {
+    const CellIndex side = static_cast<CellIndex>(gridSize);
+    const CellIndex row = entry / side;
+    const CellIndex col = entry % side;
+    Direction direction = row == 0 ? Direction::Down
+                        : row == side - 1 ? Direction::Up
+                        : col == 0 ? Direction::Right
+                        : Direction::Left;
+
+    // Without activations the state (object, direction) cannot repeat, so
+    // one bounce per state bounds a walk; each activation allows another
+    const long long sweep = 4LL * static_cast<long long>(objectPos.size()) + 1;
+    long long bounceBudget = sweep;
+
+    EntryExit result{entry, INVALID_CELL, 0};
+    CellIndex pos = entry;
+    std::uint64_t steps = 0;
+    while (bounceBudget-- > 0) {
+        CellIndex borderPos = INVALID_CELL;
+        std::uint32_t id = nextObject(pos, direction, borderPos);
+        CellIndex target = id == NO_OBJECT ? borderPos : objectPos[id];
+        steps += target > pos ? (target - pos) / (direction == Direction::Down ? gridSize : 1)
+                              : (pos - target) / (direction == Direction::Up ? gridSize : 1);
+
+        if (id == NO_OBJECT) {
+            result.exit = borderPos;
+            result.steps = static_cast<std::uint32_t>(steps);
+            break;
+        }
+
+        if (objectType[id] == GridCellType::ActivatedBumper && !activated[id]) {
+            activated[id] = 1;
+            activatedIds.push_back(id);
+            bounceBudget += sweep;
+        } else {
+            direction = DirectionMaps::transition(objectType[id], objectOrientation[id], direction);
+        }
+        pos = objectPos[objectPartner[id]];
+    }
+
+    for (std::uint32_t id : activatedIds) {
+        activated[id] = 0;
+    }
+    activatedIds.clear();
+    return result;
+}
+
+template void JumpSimulator::build(const Grid&);
+template void JumpSimulator::build(const SparseGrid&);
+template void JumpSimulator::build(const GridN<5>&);
+template void JumpSimulator::build(const GridN<6>&);
+template void JumpSimulator::build(const GridN<7>&);
+template void JumpSimulator::build(const GridN<10>&);
@@ -0,0 +1,46 @@
+#ifndef JUMP_SIMULATOR_H
+#define JUMP_SIMULATOR_H
+
+#include <cstdint>
+#include <vector>
+#include "Grid.h"
+
+// Ball walk that moves from object to object instead of cell to cell. The
+// objects of each row and column are kept sorted, so finding the next one in
+// the ball's direction is a binary search and a walk costs O(bounces * log n)
+// however far apart the objects are. Exits and step counts match
+// BasicGrid::simulate. Any engine can be indexed; on SparseGrid, the engine
+// of the largest boards, the index is built from the stored cells only.
+class JumpSimulator {
+public:
+    // Indexes the objects of grid; call again after the grid changes
+    template <typename Cells>
+    void build(const BasicGrid<Cells>& grid);
+
+    // Walks the ball from an edge cell with every ActivatedBumper off
+    EntryExit simulate(CellIndex entry);
+
+    int objectCount() const { return static_cast<int>(objectPos.size()); }
+
+private:
+    static constexpr std::uint32_t NO_OBJECT = UINT32_MAX;
+
+    int gridSize = 0;
+    // Objects are numbered in row-major order, so the objects of row r are
+    // ids rowStart[r] .. rowStart[r + 1] - 1. colIds lists ids by column,
+    // each column sorted by row.
+    std::vector<CellIndex> objectPos;
+    std::vector<GridCellType> objectType;
+    std::vector<Orientation> objectOrientation;
+    std::vector<std::uint32_t> objectPartner;
+    std::vector<std::uint32_t> rowStart;
+    std::vector<std::uint32_t> colStart;
+    std::vector<std::uint32_t> colIds;
+    std::vector<std::uint8_t> activated;
+    std::vector<std::uint32_t> activatedIds;
+
+    std::uint32_t idAt(CellIndex pos) const;
+    std::uint32_t nextObject(CellIndex pos, Direction direction, CellIndex& borderPos) const;
+};
+
+#endif // JUMP_SIMULATOR_H
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include "DirectionMaps.h"
+#include "LevelEnumerator.h"
+#include "Symmetry.h"
+
+namespace {
+    // Cell states of a search besides the index of an object state
+    constexpr std::uint8_t OPEN = 0xFF;      // Not decided: the ball has not entered it
+    constexpr std::uint8_t CROSSED = 0xFE;   // Empty, on the ball's path
+    constexpr std::uint8_t RING = 0xFD;
+
+    bool followsTransitions(GridCellType type) {
+        return type == GridCellType::Bumper || type == GridCellType::Tunnel
+            || type == GridCellType::DirectionalBumper;
+    }
+}
+
+LevelEnumerator::LevelEnumerator(int size, int minObjects, int maxObjects,
+                                 const std::vector<GridCellType>& objectTypes)
+    : size(size), minObjects(minObjects), maxObjects(maxObjects) {
+    const bool typesOk = !objectTypes.empty()
+        && std::all_of(objectTypes.begin(), objectTypes.end(), followsTransitions);
+    if (size < 3 || size > MAX_GRID_SIZE || minObjects < 0 || maxObjects < minObjects || !typesOk) {
+        configStatus = GRID_STATUS_INVALID_ARGUMENT;
+        return;
+    }
+
+    // The orientations a type can take are those that turn the ball some way
+    for (GridCellType type : objectTypes) {
+        for (int o = 0; o < static_cast<int>(Orientation::None); o++) {
+            const Orientation orientation = static_cast<Orientation>(o);
+            bool deflects = false;
+            for (int d = 0; d < 4; d++) {
+                deflects = deflects || DirectionMaps::transition(type, orientation, static_cast<Direction>(d))
+                                           != static_cast<Direction>(d);
+            }
+            const bool listed = std::any_of(objectStates.begin(), objectStates.end(), [&](const BoardObject& state) {
+                return state.type == type && state.orientation == orientation;
+            });
+            if (deflects && !listed) {
+                objectStates.push_back({INVALID_CELL, type, orientation});
+            }
+        }
+    }
+
+    // Entries in orbit order: an entry is searched if no transform moves it
+    // lower
+    const CellIndex n = static_cast<CellIndex>(size);
+    for (CellIndex entry = 0; entry < n * n; entry++) {
+        const int row = static_cast<int>(entry / n);
+        const int col = static_cast<int>(entry % n);
+        const bool corner = (row == 0 || row == size - 1) && (col == 0 || col == size - 1);
+        if (!isRingCell(entry, size) || corner) {
+            continue;
+        }
+        bool lowest = true;
+        for (int s = 1; s < SYMMETRY_COUNT; s++) {
+            lowest = lowest && Symmetries::mapIndex(static_cast<Symmetry>(s), size, entry) >= entry;
+        }
+        if (!lowest) {
+            continue;
+        }
+        const int ray = size - 2;
+        if (maxObjects > 0) {
+            for (int empty = 0; empty < ray; empty++) {
+                for (std::size_t state = 0; state < objectStates.size(); state++) {
+                    jobList.push_back({entry, empty, static_cast<std::uint8_t>(state)});
+                }
+            }
+        }
+        if (minObjects == 0) {
+            jobList.push_back({entry, ray, NO_OBJECT});
+        }
+    }
+}
+
+class LevelEnumerator::Search {
+public:
+    Search(const LevelEnumerator& enumerator, CellIndex entry, const Visit& visit)
+        : enumerator(enumerator), visit(visit), entry(entry), cells(static_cast<std::size_t>(enumerator.size) * enumerator.size),
+          seen(cells.size(), 0) {
+        const int n = enumerator.size;
+        for (CellIndex pos = 0; pos < cells.size(); pos++) {
+            cells[pos] = isRingCell(pos, n) ? RING : OPEN;
+        }
+        delta[static_cast<int>(Direction::Up)] = -n;
+        delta[static_cast<int>(Direction::Down)] = n;
+        delta[static_cast<int>(Direction::Left)] = -1;
+        delta[static_cast<int>(Direction::Right)] = 1;
+    }
+
+    std::uint64_t run(const Job& job) {
+        const int n = enumerator.size;
+        const CellIndex row = entry / static_cast<CellIndex>(n);
+        const CellIndex col = entry % static_cast<CellIndex>(n);
+        const Direction direction = row == 0 ? Direction::Down
+                                  : row == static_cast<CellIndex>(n - 1) ? Direction::Up
+                                  : col == 0 ? Direction::Right
+                                  : Direction::Left;
+        CellIndex pos = entry;
+        for (int i = 0; i < job.emptyCells; i++) {
+            pos = step(pos, direction);
+            cells[pos] = CROSSED;
+        }
+        if (job.firstObject == NO_OBJECT) {
+            follow(pos, direction);
+        } else {
+            enter(step(pos, direction), direction, job.firstObject);
+        }
+        return found;
+    }
+
+private:
+    const LevelEnumerator& enumerator;
+    const Visit& visit;
+    const CellIndex entry;
+    int delta[4];
+    std::vector<std::uint8_t> cells;
+    // Directions the ball has left each object in, as bits, to find loops
+    std::vector<std::uint8_t> seen;
+    // The path's objects in order, then the decoys
+    std::vector<BoardObject> objects;
+    std::vector<CellIndex> open;
+    std::uint64_t found = 0;
+
+    CellIndex step(CellIndex pos, Direction direction) const {
+        return static_cast<CellIndex>(static_cast<int>(pos) + delta[static_cast<int>(direction)]);
+    }
+
+    // Moves the ball on from pos until it reaches a cell not yet decided,
+    // which branches, the ring, or a state it has been in before
+    void follow(CellIndex pos, Direction direction) {
+        for (;;) {
+            pos = step(pos, direction);
+            const std::uint8_t state = cells[pos];
+            if (state == CROSSED) {
+                continue;
+            }
+            if (state == RING) {
+                finish();
+                return;
+            }
+            if (state == OPEN) {
+                cells[pos] = CROSSED;
+                follow(pos, direction);
+                if (objects.size() < static_cast<std::size_t>(enumerator.maxObjects)) {
+                    for (std::size_t object = 0; object < enumerator.objectStates.size(); object++) {
+                        enter(pos, direction, static_cast<std::uint8_t>(object));
+                    }
+                }
+                cells[pos] = OPEN;
+                return;
+            }
+            const BoardObject& object = enumerator.objectStates[state];
+            direction = DirectionMaps::transition(object.type, object.orientation, direction);
+            const std::uint8_t bit = static_cast<std::uint8_t>(1u << static_cast<int>(direction));
+            if ((seen[pos] & bit) != 0) {
+                return;
+            }
+            seen[pos] |= bit;
+            follow(pos, direction);
+            seen[pos] &= static_cast<std::uint8_t>(~bit);
+            return;
+        }
+    }
+
+    // Places an object on the open cell the ball moves into
+    void enter(CellIndex pos, Direction direction, std::uint8_t state) {
+        const BoardObject& object = enumerator.objectStates[state];
+        const Direction out = DirectionMaps::transition(object.type, object.orientation, direction);
+        cells[pos] = state;
+        objects.push_back({pos, object.type, object.orientation});
+        seen[pos] = static_cast<std::uint8_t>(1u << static_cast<int>(out));
+        follow(pos, out);
+        seen[pos] = 0;
+        objects.pop_back();
+        cells[pos] = OPEN;
+    }
+
+    // The ball is out: a board for each set of decoys on the open cells
+    void finish() {
+        if (objects.size() < static_cast<std::size_t>(enumerator.minObjects)) {
+            return;
+        }
+        open.clear();
+        for (CellIndex pos = 0; pos < cells.size(); pos++) {
+            if (cells[pos] == OPEN) {
+                open.push_back(pos);
+            }
+        }
+        addDecoys(0);
+    }
+
+    void addDecoys(std::size_t first) {
+        visit(entry, objects);
+        found++;
+        if (objects.size() >= static_cast<std::size_t>(enumerator.maxObjects)) {
+            return;
+        }
+        for (std::size_t i = first; i < open.size(); i++) {
+            for (const BoardObject& object : enumerator.objectStates) {
+                objects.push_back({open[i], object.type, object.orientation});
+                addDecoys(i + 1);
+                objects.pop_back();
+            }
+        }
+    }
+};
+
+std::uint64_t LevelEnumerator::run(const Job& job, const Visit& visit) const {
+    if (configStatus != GRID_STATUS_OK) {
+        return 0;
+    }
+    Search search(*this, job.entry, visit);
+    return search.run(job);
+}
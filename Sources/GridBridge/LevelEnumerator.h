@@ -0,0 +1,69 @@
+#ifndef LEVEL_ENUMERATOR_H
+#define LEVEL_ENUMERATOR_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Grid.h"
+
+// Every board of a small configuration rather than a sample of them: each
+// entry with each object layout whose ball leaves the board after entering at
+// least minObjects objects, with at most maxObjects objects in all. Those are
+// the boards generateGrid can produce for the configuration, and a few more
+// it would reach only by luck, such as ones with extra objects on the path.
+//
+// The search follows the ball. A cell is decided when the ball first reaches
+// it, as empty or as each object the budget still allows, so a branch ends as
+// soon as its ball loops or its budget runs out, before anything else on the
+// board is chosen. Once the ball is out, the cells it never entered take
+// every set of decoys the budget leaves. Only the lowest entry of each
+// symmetry orbit is searched (see Symmetry.h); the boards entering elsewhere
+// are transforms of those. The search is cut into jobs by where the ball
+// meets its first object, so they can run on separate threads.
+//
+// Object types must resolve through the transition table alone: Bumper,
+// Tunnel and DirectionalBumper.
+class LevelEnumerator {
+public:
+    // First object is NO_OBJECT for the job whose ball crosses the whole
+    // initial ray, which exists only when minObjects is 0
+    static constexpr std::uint8_t NO_OBJECT = 0xFF;
+
+    struct Job {
+        CellIndex entry;
+        int emptyCells;              // Cells the ball crosses before its first object
+        std::uint8_t firstObject;    // Index into objects() of that object's type and orientation
+    };
+
+    // Called with each board found: its entry and objects, those the ball
+    // enters first, in order. The vector is reused between calls.
+    using Visit = std::function<void(CellIndex entry, const std::vector<BoardObject>& objects)>;
+
+    LevelEnumerator(int size, int minObjects, int maxObjects, const std::vector<GridCellType>& objectTypes);
+
+    // GRID_STATUS_INVALID_ARGUMENT for a side outside 3..MAX_GRID_SIZE, bad
+    // object counts or an object type the search cannot follow; such an
+    // enumerator has no jobs
+    GridStatus status() const { return configStatus; }
+    // Jobs covering the search, in a fixed order
+    const std::vector<Job>& jobs() const { return jobList; }
+    // Each object type with each orientation it can take
+    const std::vector<BoardObject>& objects() const { return objectStates; }
+
+    // Runs one job of jobs(), calling visit for every board it finds, and
+    // returns how many that was. Safe to call from several threads at once.
+    std::uint64_t run(const Job& job, const Visit& visit) const;
+
+private:
+    int size;
+    int minObjects;
+    int maxObjects;
+    GridStatus configStatus = GRID_STATUS_OK;
+    std::vector<BoardObject> objectStates;    // pos unused
+    std::vector<Job> jobList;
+
+    // State of one run
+    class Search;
+};
+
+#endif // LEVEL_ENUMERATOR_H
@@ -0,0 +1,355 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "LevelPack.h"
+
+// Tables and records are written and mapped as they lie in memory
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "level packs are little-endian"
+#endif
+
+using namespace LevelPackFormat;
+
+LevelPack::~LevelPack() {
+    close();
+}
+
+GridStatus LevelPack::open(const char* path) {
+    close();
+    if (!path) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return GRID_STATUS_IO_ERROR;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return GRID_STATUS_IO_ERROR;
+    }
+    if (static_cast<std::uint64_t>(info.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return GRID_STATUS_BAD_FORMAT;
+    }
+
+    void* mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file open
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return GRID_STATUS_IO_ERROR;
+    }
+    // Levels are picked at random, so reading ahead of one only wastes memory
+    madvise(mapped, static_cast<std::size_t>(info.st_size), MADV_RANDOM);
+
+    data = static_cast<const std::uint8_t*>(mapped);
+    size = static_cast<std::size_t>(info.st_size);
+    header = reinterpret_cast<const Header*>(data);
+    configs = reinterpret_cast<const Config*>(header + 1);
+    buckets = reinterpret_cast<const Bucket*>(configs + header->configCount);
+    if (!validate()) {
+        close();
+        return GRID_STATUS_BAD_FORMAT;
+    }
+    return GRID_STATUS_OK;
+}
+
+void LevelPack::close() {
+    if (data) {
+        munmap(const_cast<std::uint8_t*>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+    header = nullptr;
+    configs = nullptr;
+    buckets = nullptr;
+}
+
+// Checks the tables, not the records: the work depends on the number of
+// configs and buckets, never on the number of levels
+bool LevelPack::validate() const {
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION) {
+        return false;
+    }
+    const std::uint64_t tablesEnd = sizeof(Header) + static_cast<std::uint64_t>(header->configCount) * sizeof(Config)
+                                  + static_cast<std::uint64_t>(header->bucketCount) * sizeof(Bucket);
+    if (tablesEnd > size) {
+        return false;
+    }
+
+    for (std::uint32_t i = 0; i < header->configCount; i++) {
+        const Config& config = configs[i];
+        if (config.side < 3 || config.side > static_cast<std::uint32_t>(MAX_GRID_SIZE)
+            || (config.flags & ~CONFIG_SEEDS) != 0 || !recordSizeFits(config)
+            || config.recordSize != recordSize(config)
+            || config.bucketCount > MAX_BUCKETS
+            || static_cast<std::uint64_t>(config.firstBucket) + config.bucketCount > header->bucketCount
+            || config.firstRecord < tablesEnd || config.firstRecord > size || config.firstRecord % 8 != 0
+            || config.levelCount > (size - config.firstRecord) / config.recordSize) {
+            return false;
+        }
+        for (std::uint32_t b = 0; b < config.bucketCount; b++) {
+            const Bucket& bucket = buckets[config.firstBucket + b];
+            if (bucket.firstLevel > config.levelCount || bucket.levelCount > config.levelCount - bucket.firstLevel) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int LevelPack::findConfig(int size, int minObjects, int maxObjects, const std::vector<GridCellType>& objectTypes) const {
+    const std::uint32_t mask = objectTypeMask(objectTypes);
+    for (int i = 0; i < configCount(); i++) {
+        const Config& config = configs[i];
+        if (static_cast<int>(config.side) == size && static_cast<int>(config.minObjects) == minObjects
+            && static_cast<int>(config.maxObjects) == maxObjects && config.objectTypeMask == mask) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int LevelPack::bucketCount(int config) const {
+    if (config < 0 || config >= configCount()) {
+        return 0;
+    }
+    return static_cast<int>(configs[config].bucketCount);
+}
+
+std::uint64_t LevelPack::levelCount(int config, int bucket) const {
+    if (bucket < 0 || bucket >= bucketCount(config)) {
+        return 0;
+    }
+    return buckets[configs[config].firstBucket + bucket].levelCount;
+}
+
+const LevelHeader* LevelPack::level(int config, int bucket, std::uint64_t random) const {
+    const std::uint64_t count = levelCount(config, bucket);
+    if (count == 0 || (configs[config].flags & CONFIG_SEEDS)) {
+        return nullptr;
+    }
+    const Config& entry = configs[config];
+    const std::uint64_t index = buckets[entry.firstBucket + bucket].firstLevel + random % count;
+    const auto* level = reinterpret_cast<const LevelHeader*>(data + entry.firstRecord + index * entry.recordSize);
+    // Records are not checked on open; a record of the wrong side would send
+    // cell reads past it
+    return level->side == entry.side ? level : nullptr;
+}
+
+bool LevelPack::levelSeed(int config, int bucket, std::uint64_t random, std::uint32_t& seed,
+                          Symmetry& symmetry) const {
+    const std::uint64_t count = levelCount(config, bucket);
+    if (count == 0 || !(configs[config].flags & CONFIG_SEEDS)) {
+        return false;
+    }
+    const Config& entry = configs[config];
+    const std::uint64_t index = buckets[entry.firstBucket + bucket].firstLevel + random % count;
+    const auto* record = reinterpret_cast<const SeedRecord*>(data + entry.firstRecord + index * entry.recordSize);
+    if (record->symmetry >= static_cast<std::uint32_t>(SYMMETRY_COUNT)) {
+        return false;
+    }
+    seed = record->seed;
+    symmetry = static_cast<Symmetry>(record->symmetry);
+    return true;
+}
+
+template <typename Cells>
+Config LevelPackFormat::configOf(const BasicGrid<Cells>& grid) {
+    Config config = {};
+    config.side = static_cast<std::uint32_t>(grid.side());
+    config.minObjects = static_cast<std::uint32_t>(grid.minObjects);
+    config.maxObjects = static_cast<std::uint32_t>(grid.maxObjects);
+    config.objectTypeMask = objectTypeMask(grid.objectTypes);
+    return config;
+}
+
+template <typename Cells>
+GridStatus LevelPackFormat::encodeLevel(const BasicGrid<Cells>& grid, std::uint8_t* record) {
+    const int side = grid.side();
+    const std::size_t cellCount = static_cast<std::size_t>(side) * static_cast<std::size_t>(side);
+    if (side < 3 || grid.ballPath.empty() || grid.entryPos >= cellCount || !isRingCell(grid.entryPos, side)) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+
+    // Records keep no pair list: a teleporter's partner is the other one
+    // with its index, so every pair needs an index of its own
+    std::uint64_t pairIndexes[4] = {};
+    for (const TeleporterPair& pair : grid.teleporterPairs) {
+        if (pair.index < 0 || pair.index > UINT8_MAX || (pairIndexes[pair.index / 64] >> (pair.index % 64) & 1) != 0) {
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+        pairIndexes[pair.index / 64] |= std::uint64_t{1} << (pair.index % 64);
+    }
+
+    std::uint8_t* cells = record + sizeof(LevelHeader);
+    LevelHeader level = {static_cast<std::uint32_t>(side), grid.entryPos, grid.exitPos, 0};
+    for (CellIndex pos = 0; pos < cellCount; pos++) {
+        const GridCell& cell = grid.gridCells[pos];
+        if (cell.teleporterIndex < 0 || cell.teleporterIndex > UINT8_MAX) {
+            return GRID_STATUS_INVALID_ARGUMENT;
+        }
+        const GridCellType type = cell.type == GridCellType::Border ? GridCellType::Empty : cell.type;
+        cells[pos * CELL_BYTES] = static_cast<std::uint8_t>(static_cast<unsigned>(type)
+                                                             | static_cast<unsigned>(cell.orientation) << 4);
+        cells[pos * CELL_BYTES + 1] = static_cast<std::uint8_t>(cell.teleporterIndex);
+        level.objectCount += isObjectCell(type) ? 1 : 0;
+    }
+    std::memcpy(record, &level, sizeof(level));
+    // Padding up to the next record
+    std::memset(cells + cellCount * CELL_BYTES, 0,
+                recordSize(static_cast<std::size_t>(side)) - sizeof(LevelHeader) - cellCount * CELL_BYTES);
+    return GRID_STATUS_OK;
+}
+
+std::uint8_t* LevelPackWriter::appendRecord(const Config& config, std::uint32_t difficulty) {
+    if (config.side < 3 || config.side > static_cast<std::uint32_t>(MAX_GRID_SIZE)
+        || config.minObjects > config.maxObjects || (config.flags & ~CONFIG_SEEDS) != 0
+        || !recordSizeFits(config) || difficulty >= MAX_BUCKETS) {
+        return nullptr;
+    }
+
+    ConfigLevels* levelsOf = nullptr;
+    for (ConfigLevels& candidate : configs) {
+        const Config& filed = candidate.config;
+        if (filed.side == config.side && filed.minObjects == config.minObjects
+            && filed.maxObjects == config.maxObjects && filed.objectTypeMask == config.objectTypeMask) {
+            levelsOf = &candidate;
+            break;
+        }
+    }
+    if (!levelsOf) {
+        Config filed = {};
+        filed.side = config.side;
+        filed.minObjects = config.minObjects;
+        filed.maxObjects = config.maxObjects;
+        filed.objectTypeMask = config.objectTypeMask;
+        filed.flags = config.flags;
+        filed.recordSize = static_cast<std::uint32_t>(recordSize(filed));
+        configs.push_back({filed, {}});
+        levelsOf = &configs.back();
+    } else if (levelsOf->config.flags != config.flags) {
+        return nullptr;
+    }
+    if (levelsOf->buckets.size() <= difficulty) {
+        levelsOf->buckets.resize(difficulty + 1);
+    }
+
+    std::vector<std::uint8_t>& bucket = levelsOf->buckets[difficulty];
+    const std::size_t start = bucket.size();
+    bucket.resize(start + levelsOf->config.recordSize);
+    levels++;
+    return bucket.data() + start;
+}
+
+template <typename Cells>
+GridStatus LevelPackWriter::add(const BasicGrid<Cells>& grid, std::uint32_t difficulty) {
+    if (grid.minObjects < 0 || grid.maxObjects < grid.minObjects) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+    const Config config = configOf(grid);
+    if (!recordSizeFits(config)) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+    recordScratch.resize(recordSize(config));
+    const GridStatus status = encodeLevel(grid, recordScratch.data());
+    if (status != GRID_STATUS_OK) {
+        return status;
+    }
+    return addRecord(config, difficulty, recordScratch.data());
+}
+
+GridStatus LevelPackWriter::addRecord(const Config& config, std::uint32_t difficulty, const std::uint8_t* record) {
+    std::uint8_t* slot = record ? appendRecord(config, difficulty) : nullptr;
+    if (!slot) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+    std::memcpy(slot, record, recordSize(config));
+    return GRID_STATUS_OK;
+}
+
+GridStatus LevelPackWriter::addSeed(const Config& config, std::uint32_t difficulty, std::uint32_t seed,
+                                    Symmetry symmetry) {
+    Config seeds = config;
+    seeds.flags |= CONFIG_SEEDS;
+    const SeedRecord record = {seed, static_cast<std::uint32_t>(symmetry)};
+    return addRecord(seeds, difficulty, reinterpret_cast<const std::uint8_t*>(&record));
+}
+
+// Written beside path and renamed over it, so a pack already mapped from
+// path stays intact and a failed write leaves no partial pack
+GridStatus LevelPackWriter::write(const char* path) const {
+    if (!path) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+
+    std::uint32_t bucketTotal = 0;
+    for (const ConfigLevels& levelsOf : configs) {
+        bucketTotal += static_cast<std::uint32_t>(levelsOf.buckets.size());
+    }
+    const Header header = {{MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3]}, VERSION,
+                           static_cast<std::uint32_t>(configs.size()), bucketTotal};
+
+    std::vector<Config> configTable;
+    std::vector<Bucket> bucketTable;
+    std::uint64_t offset = sizeof(Header) + configs.size() * sizeof(Config) + bucketTotal * sizeof(Bucket);
+    for (const ConfigLevels& levelsOf : configs) {
+        Config config = levelsOf.config;
+        config.firstBucket = static_cast<std::uint32_t>(bucketTable.size());
+        config.bucketCount = static_cast<std::uint32_t>(levelsOf.buckets.size());
+        config.firstRecord = offset;
+        config.levelCount = 0;
+        for (const std::vector<std::uint8_t>& bucket : levelsOf.buckets) {
+            const std::uint64_t count = bucket.size() / config.recordSize;
+            bucketTable.push_back({config.levelCount, count});
+            config.levelCount += count;
+            offset += bucket.size();
+        }
+        configTable.push_back(config);
+    }
+
+    const std::string partial = std::string(path) + ".part";
+    std::FILE* file = std::fopen(partial.c_str(), "wb");
+    if (!file) {
+        return GRID_STATUS_IO_ERROR;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+           && std::fwrite(configTable.data(), sizeof(Config), configTable.size(), file) == configTable.size()
+           && std::fwrite(bucketTable.data(), sizeof(Bucket), bucketTable.size(), file) == bucketTable.size();
+    for (const ConfigLevels& levelsOf : configs) {
+        for (const std::vector<std::uint8_t>& bucket : levelsOf.buckets) {
+            // Buckets below the highest one used may be empty, with no data
+            ok = ok && (bucket.empty() || std::fwrite(bucket.data(), 1, bucket.size(), file) == bucket.size());
+        }
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(partial.c_str(), path) != 0) {
+        std::remove(partial.c_str());
+        return GRID_STATUS_IO_ERROR;
+    }
+    return GRID_STATUS_OK;
+}
+
+template Config LevelPackFormat::configOf(const BasicGrid<DenseCells>&);
+template Config LevelPackFormat::configOf(const BasicGrid<SparseCells>&);
+template Config LevelPackFormat::configOf(const BasicGrid<FixedCells<5>>&);
+template Config LevelPackFormat::configOf(const BasicGrid<FixedCells<6>>&);
+template Config LevelPackFormat::configOf(const BasicGrid<FixedCells<7>>&);
+template Config LevelPackFormat::configOf(const BasicGrid<FixedCells<10>>&);
+template GridStatus LevelPackFormat::encodeLevel(const BasicGrid<DenseCells>&, std::uint8_t*);
+template GridStatus LevelPackFormat::encodeLevel(const BasicGrid<SparseCells>&, std::uint8_t*);
+template GridStatus LevelPackFormat::encodeLevel(const BasicGrid<FixedCells<5>>&, std::uint8_t*);
+template GridStatus LevelPackFormat::encodeLevel(const BasicGrid<FixedCells<6>>&, std::uint8_t*);
+template GridStatus LevelPackFormat::encodeLevel(const BasicGrid<FixedCells<7>>&, std::uint8_t*);
+template GridStatus LevelPackFormat::encodeLevel(const BasicGrid<FixedCells<10>>&, std::uint8_t*);
+template GridStatus LevelPackWriter::add(const BasicGrid<DenseCells>&, std::uint32_t);
+template GridStatus LevelPackWriter::add(const BasicGrid<SparseCells>&, std::uint32_t);
+template GridStatus LevelPackWriter::add(const BasicGrid<FixedCells<5>>&, std::uint32_t);
+template GridStatus LevelPackWriter::add(const BasicGrid<FixedCells<6>>&, std::uint32_t);
+template GridStatus LevelPackWriter::add(const BasicGrid<FixedCells<7>>&, std::uint32_t);
+template GridStatus LevelPackWriter::add(const BasicGrid<FixedCells<10>>&, std::uint32_t);
@@ -0,0 +1,227 @@
+#ifndef LEVEL_PACK_H
+#define LEVEL_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Grid.h"
+
+// A library of pre-generated levels in one file. The reader maps the file
+// rather than reading it: opening checks the header and the config and
+// bucket tables only, so it costs the same for ten levels as for ten
+// million, and a level is a fixed-size record read in place.
+//
+// Layout, little-endian, every section 8-byte aligned:
+//   Header
+//   Config[configCount]    one per (side, object counts, object types)
+//   Bucket[bucketCount]    each config's difficulty buckets, 0 upwards
+//   records                each config's levels, sorted by bucket,
+//                          recordSize bytes apart
+//
+// A record is a LevelHeader followed by two bytes per cell, row-major: the
+// cell type as the bridge reports it in the low nibble with the orientation
+// in the high nibble, then the teleporter index. No pair list is kept; the
+// two teleporters sharing an index are a pair, so a board whose pairs
+// share an index cannot be stored. A config flagged
+// CONFIG_SEEDS stores each level as a SeedRecord instead: the seed that
+// regenerates it with BasicGrid::seed and generateGrid, and the symmetry
+// transformFrom then turns or flips it by (see Symmetry.h), at a few bytes
+// per level rather than a few hundred.
+namespace LevelPackFormat {
+    constexpr char MAGIC[4] = {'P', 'P', 'L', 'P'};
+    constexpr std::uint32_t VERSION = 1;
+    // Difficulty buckets per config
+    constexpr std::uint32_t MAX_BUCKETS = 1024;
+    // Config flags
+    constexpr std::uint32_t CONFIG_SEEDS = 1u << 0;
+
+    struct Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t configCount;
+        std::uint32_t bucketCount;
+    };
+
+    struct Config {
+        std::uint32_t side;
+        std::uint32_t minObjects;
+        std::uint32_t maxObjects;
+        std::uint32_t objectTypeMask;   // cellTypeBit of each object type
+        std::uint32_t firstBucket;
+        std::uint32_t bucketCount;
+        std::uint32_t recordSize;
+        std::uint32_t flags;            // CONFIG_*
+        std::uint64_t firstRecord;      // File offset of the config's first level
+        std::uint64_t levelCount;
+    };
+
+    struct Bucket {
+        std::uint64_t firstLevel;       // Index among the config's levels
+        std::uint64_t levelCount;
+    };
+
+    struct LevelHeader {
+        std::uint32_t side;
+        CellIndex entry;
+        CellIndex exit;                 // INVALID_CELL if the ball never leaves
+        std::uint32_t objectCount;
+    };
+
+    struct SeedRecord {
+        std::uint32_t seed;
+        std::uint32_t symmetry;         // A Symmetry; 0, Identity, for the board as generated
+    };
+
+    static_assert(sizeof(Header) == 16 && sizeof(Config) == 48 && sizeof(Bucket) == 16
+                  && sizeof(LevelHeader) == 16 && sizeof(SeedRecord) == 8, "pack tables must have no padding");
+
+    constexpr std::size_t CELL_BYTES = 2;
+
+    // Bytes between records of a side, rounded up to keep records aligned
+    constexpr std::size_t recordSize(std::size_t side) {
+        return (sizeof(LevelHeader) + side * side * CELL_BYTES + 7) & ~std::size_t{7};
+    }
+
+    // Bytes between records of a config, by its side and flags
+    constexpr std::size_t recordSize(const Config& config) {
+        return (config.flags & CONFIG_SEEDS) ? sizeof(SeedRecord) : recordSize(static_cast<std::size_t>(config.side));
+    }
+
+    // Largest side whose records fit Config::recordSize; a config of seeds
+    // takes any side
+    constexpr std::uint32_t MAX_RECORD_SIDE = 46340;
+    static_assert(sizeof(std::size_t) < 8 || (recordSize(std::size_t{MAX_RECORD_SIDE}) <= UINT32_MAX
+                                              && recordSize(std::size_t{MAX_RECORD_SIDE} + 1) > UINT32_MAX),
+                  "MAX_RECORD_SIDE is the last side with a 32-bit record size");
+
+    constexpr bool recordSizeFits(const Config& config) {
+        return (config.flags & CONFIG_SEEDS) || config.side <= MAX_RECORD_SIDE;
+    }
+
+    inline std::uint32_t objectTypeMask(const std::vector<GridCellType>& types) {
+        std::uint32_t mask = 0;
+        for (GridCellType type : types) {
+            mask |= cellTypeBit(type);
+        }
+        return mask;
+    }
+
+    // The config a grid is filed under; only the parameter fields are set,
+    // with no flags
+    template <typename Cells>
+    Config configOf(const BasicGrid<Cells>& grid);
+
+    // Writes the record of a generated or simulated grid, recordSize(side)
+    // bytes, to record. Returns GRID_STATUS_INVALID_ARGUMENT for a grid
+    // without an entry or walk, with teleporter indexes above 255, or with
+    // two teleporter pairs of one index.
+    template <typename Cells>
+    GridStatus encodeLevel(const BasicGrid<Cells>& grid, std::uint8_t* record);
+}
+
+// One level of an open pack; valid while the pack stays open
+class PackLevel {
+public:
+    explicit PackLevel(const LevelPackFormat::LevelHeader* level) : level(level) {}
+
+    int side() const { return static_cast<int>(level->side); }
+    CellIndex entry() const { return level->entry; }
+    CellIndex exit() const { return level->exit; }
+    int objectCount() const { return static_cast<int>(level->objectCount); }
+
+    // Cells as the bridge reports them; (row, col) must be on the board
+    GridCellType type(int row, int col) const { return static_cast<GridCellType>(cell(row, col)[0] & 0x0F); }
+    Orientation orientation(int row, int col) const { return static_cast<Orientation>(cell(row, col)[0] >> 4); }
+    int teleporterIndex(int row, int col) const { return cell(row, col)[1]; }
+
+private:
+    const LevelPackFormat::LevelHeader* level;
+
+    const std::uint8_t* cell(int row, int col) const {
+        const auto* cells = reinterpret_cast<const std::uint8_t*>(level + 1);
+        return cells + (static_cast<std::size_t>(row) * level->side + static_cast<std::size_t>(col))
+                       * LevelPackFormat::CELL_BYTES;
+    }
+};
+
+// Read-only view of a pack file
+class LevelPack {
+public:
+    LevelPack() = default;
+    ~LevelPack();
+    LevelPack(const LevelPack&) = delete;
+    LevelPack& operator=(const LevelPack&) = delete;
+
+    // Maps the file at path, replacing any pack already open. Returns
+    // GRID_STATUS_IO_ERROR if it cannot be opened or mapped and
+    // GRID_STATUS_BAD_FORMAT if its tables are not a pack of this version.
+    GridStatus open(const char* path);
+    void close();
+
+    // Index of the config with exactly these parameters and object types, in
+    // any order, or -1
+    int findConfig(int size, int minObjects, int maxObjects, const std::vector<GridCellType>& objectTypes) const;
+    int configCount() const { return header ? static_cast<int>(header->configCount) : 0; }
+    // Parameters and tables of a config; index below configCount()
+    const LevelPackFormat::Config& config(int index) const { return configs[index]; }
+    int bucketCount(int config) const;
+    std::uint64_t levelCount(int config, int bucket) const;
+
+    // Level random % levelCount of the bucket, or null for an empty or
+    // unknown bucket or a seeds-only config. Constant time: a table lookup
+    // and a pointer offset.
+    const LevelPackFormat::LevelHeader* level(int config, int bucket, std::uint64_t random) const;
+    // For a CONFIG_SEEDS config, sets seed and symmetry to those of level
+    // random % levelCount; false for an empty or unknown bucket, a config of
+    // records or a damaged record
+    bool levelSeed(int config, int bucket, std::uint64_t random, std::uint32_t& seed, Symmetry& symmetry) const;
+
+private:
+    const std::uint8_t* data = nullptr;
+    std::size_t size = 0;
+    const LevelPackFormat::Header* header = nullptr;
+    const LevelPackFormat::Config* configs = nullptr;
+    const LevelPackFormat::Bucket* buckets = nullptr;
+
+    bool validate() const;
+};
+
+// Collects levels in memory and writes them as a pack
+class LevelPackWriter {
+public:
+    // Adds a generated or simulated grid under its configuration. difficulty
+    // is the bucket, 0 the easiest, below MAX_BUCKETS. Fails as encodeLevel,
+    // and for sides above MAX_RECORD_SIDE.
+    template <typename Cells>
+    GridStatus add(const BasicGrid<Cells>& grid, std::uint32_t difficulty);
+    // Adds an encoded record, such as one read from another pack, under the
+    // parameters of config
+    GridStatus addRecord(const LevelPackFormat::Config& config, std::uint32_t difficulty,
+                         const std::uint8_t* record);
+    // Adds a level as the seed that generates it under config, turned or
+    // flipped by symmetry. A config holds records or seeds, not both:
+    // GRID_STATUS_INVALID_ARGUMENT if it already holds the other.
+    GridStatus addSeed(const LevelPackFormat::Config& config, std::uint32_t difficulty, std::uint32_t seed,
+                       Symmetry symmetry = Symmetry::Identity);
+
+    std::uint64_t levelCount() const { return levels; }
+
+    // Returns GRID_STATUS_IO_ERROR if the file cannot be written
+    GridStatus write(const char* path) const;
+
+private:
+    struct ConfigLevels {
+        LevelPackFormat::Config config;
+        // Record bytes per bucket, in the order added
+        std::vector<std::vector<std::uint8_t>> buckets;
+    };
+    std::vector<ConfigLevels> configs;
+    std::uint64_t levels = 0;
+    std::vector<std::uint8_t> recordScratch;
+
+    // Space for one more record of config, with config.flags, in the
+    // bucket, or null
+    std::uint8_t* appendRecord(const LevelPackFormat::Config& config, std::uint32_t difficulty);
+};
+
+#endif // LEVEL_PACK_H
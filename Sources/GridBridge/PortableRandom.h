@@ -0,0 +1,29 @@
+#ifndef PORTABLE_RANDOM_H
+#define PORTABLE_RANDOM_H
+
+#include <cstdint>
+#include <limits>
+
+// Bounded draws that come out the same with every standard library. The
+// standard fixes std::mt19937's output sequence but not what the
+// std::*_distribution adaptors make of it, so seeded generation maps the
+// engine's 32-bit outputs to a range here instead: Lemire's multiply-shift,
+// with rejection to keep it unbiased, which usually costs one draw and no
+// division.
+template <typename Rng>
+std::uint32_t uniformBelow(Rng& rng, std::uint32_t bound) {
+    static_assert(Rng::min() == 0 && Rng::max() == std::numeric_limits<std::uint32_t>::max(),
+                  "uniformBelow needs a generator of full 32-bit outputs");
+    std::uint64_t product = static_cast<std::uint64_t>(static_cast<std::uint32_t>(rng())) * bound;
+    std::uint32_t low = static_cast<std::uint32_t>(product);
+    if (low < bound) {
+        const std::uint32_t threshold = (0u - bound) % bound;
+        while (low < threshold) {
+            product = static_cast<std::uint64_t>(static_cast<std::uint32_t>(rng())) * bound;
+            low = static_cast<std::uint32_t>(product);
+        }
+    }
+    return static_cast<std::uint32_t>(product >> 32);
+}
+
+#endif // PORTABLE_RANDOM_H
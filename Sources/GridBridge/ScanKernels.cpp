@@ -0,0 +1,88 @@
+#include <cstddef>
+#include "ScanKernels.h"
+#include "CpuFeatures.h"
+
+namespace ScanKernels {
+namespace {
+    // The kernels read a cell's first 32 bits and keep the low byte
+    static_assert(sizeof(GridCell) == 16 && offsetof(GridCell, type) == 0,
+                  "scan kernels assume 16-byte cells that start with their type");
+    constexpr int WORDS_PER_CELL = sizeof(GridCell) / sizeof(std::int32_t);
+
+#if GRID_X86_SIMD
+    // Type bytes of eight cells of the ray, starting at cell
+    GRID_TARGET_AVX2
+    __m256i gatherTypes(const GridCell* cell, __m256i offsets) {
+        const __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(cell), offsets, 4);
+        return _mm256_and_si256(words, _mm256_set1_epi32(0xFF));
+    }
+
+    GRID_TARGET_AVX2
+    __m256i rayOffsets(std::ptrdiff_t stride) {
+        const int step = static_cast<int>(stride) * WORDS_PER_CELL;
+        return _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(step));
+    }
+
+    GRID_TARGET_AVX2
+    std::uint32_t firstObstacleAvx2(const Ray& ray) {
+        const __m256i offsets = rayOffsets(ray.stride);
+        const __m256i empty = _mm256_set1_epi32(static_cast<int>(GridCellType::Empty));
+        const __m256i inBallPath = _mm256_set1_epi32(static_cast<int>(GridCellType::InBallPath));
+
+        const GridCell* cell = ray.first;
+        std::uint32_t i = 0;
+        for (; i + 8 <= ray.count; i += 8, cell += 8 * ray.stride) {
+            const __m256i types = gatherTypes(cell, offsets);
+            const __m256i passable = _mm256_or_si256(_mm256_cmpeq_epi32(types, empty),
+                                                     _mm256_cmpeq_epi32(types, inBallPath));
+            const unsigned blocked = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(passable))) & 0xFFu;
+            if (blocked != 0) {
+                return i + static_cast<std::uint32_t>(__builtin_ctz(blocked));
+            }
+        }
+        return i + firstObstacleScalar({cell, ray.stride, ray.count - i});
+    }
+
+    GRID_TARGET_AVX2
+    void openMaskAvx2(const Ray& ray, std::uint64_t* mask) {
+        const __m256i offsets = rayOffsets(ray.stride);
+        const __m256i empty = _mm256_set1_epi32(static_cast<int>(GridCellType::Empty));
+        for (std::uint32_t word = 0; word < (ray.count + 63) / 64; word++) {
+            mask[word] = 0;
+        }
+
+        const GridCell* cell = ray.first;
+        std::uint32_t i = 0;
+        for (; i + 8 <= ray.count; i += 8, cell += 8 * ray.stride) {
+            const __m256i open = _mm256_cmpeq_epi32(gatherTypes(cell, offsets), empty);
+            const std::uint64_t bits = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(open)));
+            mask[i / 64] |= bits << (i % 64);
+        }
+        for (; i < ray.count; i++, cell += ray.stride) {
+            if (cell->type == GridCellType::Empty) {
+                mask[i / 64] |= std::uint64_t{1} << (i % 64);
+            }
+        }
+    }
+#endif
+}
+
+std::uint32_t firstObstacleVector(const Ray& ray) {
+#if GRID_X86_SIMD
+    if (cpuHasAvx2()) {
+        return firstObstacleAvx2(ray);
+    }
+#endif
+    return firstObstacleScalar(ray);
+}
+
+void openMaskVector(const Ray& ray, std::uint64_t* mask) {
+#if GRID_X86_SIMD
+    if (cpuHasAvx2()) {
+        openMaskAvx2(ray, mask);
+        return;
+    }
+#endif
+    openMaskScalar(ray, mask);
+}
+}
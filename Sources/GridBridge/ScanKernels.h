@@ -0,0 +1,69 @@
+#ifndef SCAN_KERNELS_H
+#define SCAN_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "GridCell.h"
+
+// Occupancy queries along a straight run of cells in contiguous storage: a
+// row has a stride of one cell, a column a stride of one row. The vector
+// kernels read the type byte of eight cells per gather whatever the stride,
+// so columns need no transposed copy. Rays shorter than VECTOR_MIN_CELLS
+// stay on the scalar loops, which are also the reference the kernels are
+// tested against.
+namespace ScanKernels {
+    struct Ray {
+        const GridCell* first;   // The first cell scanned
+        std::ptrdiff_t stride;   // Cells between consecutive cells of the ray
+        std::uint32_t count;     // Cells scanned
+    };
+
+    constexpr std::uint32_t VECTOR_MIN_CELLS = 16;
+
+    // Cells the ball passes freely: nothing there yet, or only its own path
+    constexpr unsigned PASSABLE_CELL_TYPES = cellTypeBit(GridCellType::Empty)
+                                           | cellTypeBit(GridCellType::InBallPath);
+
+    // Index of the first cell on the ray that is not passable, or ray.count
+    inline std::uint32_t firstObstacleScalar(const Ray& ray) {
+        const GridCell* cell = ray.first;
+        for (std::uint32_t i = 0; i < ray.count; i++, cell += ray.stride) {
+            if ((cellTypeBit(cell->type) & PASSABLE_CELL_TYPES) == 0) {
+                return i;
+            }
+        }
+        return ray.count;
+    }
+
+    // Sets bit i of mask (64 cells per word, (count + 63) / 64 words) for
+    // each Empty cell i of the ray; other bits are cleared
+    inline void openMaskScalar(const Ray& ray, std::uint64_t* mask) {
+        for (std::uint32_t word = 0; word < (ray.count + 63) / 64; word++) {
+            mask[word] = 0;
+        }
+        const GridCell* cell = ray.first;
+        for (std::uint32_t i = 0; i < ray.count; i++, cell += ray.stride) {
+            if (cell->type == GridCellType::Empty) {
+                mask[i / 64] |= std::uint64_t{1} << (i % 64);
+            }
+        }
+    }
+
+    // The same queries on the widest kernel this CPU runs
+    std::uint32_t firstObstacleVector(const Ray& ray);
+    void openMaskVector(const Ray& ray, std::uint64_t* mask);
+
+    inline std::uint32_t firstObstacle(const Ray& ray) {
+        return ray.count < VECTOR_MIN_CELLS ? firstObstacleScalar(ray) : firstObstacleVector(ray);
+    }
+
+    inline void openMask(const Ray& ray, std::uint64_t* mask) {
+        if (ray.count < VECTOR_MIN_CELLS) {
+            openMaskScalar(ray, mask);
+        } else {
+            openMaskVector(ray, mask);
+        }
+    }
+}
+
+#endif // SCAN_KERNELS_H
@@ -0,0 +1,275 @@
+#include <cstdint>
+#include "Grid.h"
+#include "LevelPack.h"
+#include "Symmetry.h"
+
+namespace {
+    constexpr std::uint64_t HASH_OFFSET = 0xCBF29CE484222325ull;
+    constexpr std::uint64_t HASH_PRIME = 0x100000001B3ull;
+
+    // FNV-1a a word at a time, with a shift so the high bits of each word
+    // reach the low bits of the hash too
+    std::uint64_t mix(std::uint64_t hash, std::uint64_t word) {
+        hash = (hash ^ word) * HASH_PRIME;
+        return hash ^ (hash >> 29);
+    }
+
+    // Entries sit on the border ring, off its corners
+    bool isEntryCell(CellIndex pos, int side) {
+        const CellIndex n = static_cast<CellIndex>(side);
+        const int row = static_cast<int>(pos / n);
+        const int col = static_cast<int>(pos % n);
+        const bool corner = (row == 0 || row == side - 1) && (col == 0 || col == side - 1);
+        return side >= 3 && pos < n * n && isRingCell(pos, side) && !corner;
+    }
+
+    // The board of a grid, as canonicalFormOf reads it
+    template <typename Cells>
+    struct GridBoard {
+        const BasicGrid<Cells>& grid;
+
+        int side() const { return grid.side(); }
+        CellIndex entry() const { return grid.entryPos; }
+        GridCellType type(int row, int col) const { return grid.cellAt(row, col).type; }
+        Orientation orientation(int row, int col) const { return grid.cellAt(row, col).orientation; }
+        CellIndex partner(int row, int col) const {
+            const CellIndex pos = grid.toIndex(row, col);
+            for (const TeleporterPair& pair : grid.teleporterPairs) {
+                if (pair.first == pos || pair.second == pos) {
+                    return pair.first == pos ? pair.second : pair.first;
+                }
+            }
+            return INVALID_CELL;
+        }
+    };
+
+    // The board of a pack level. Records keep no pair list, but encodeLevel
+    // stores only boards whose pairs have indexes of their own, so a
+    // teleporter's partner is the other teleporter with its index.
+    struct PackBoard {
+        const PackLevel& level;
+
+        int side() const { return level.side(); }
+        CellIndex entry() const { return level.entry(); }
+        GridCellType type(int row, int col) const { return level.type(row, col); }
+        Orientation orientation(int row, int col) const { return level.orientation(row, col); }
+        CellIndex partner(int row, int col) const {
+            const int index = level.teleporterIndex(row, col);
+            for (int r = 1; r < side() - 1; r++) {
+                for (int c = 1; c < side() - 1; c++) {
+                    if ((r != row || c != col) && level.type(r, c) == GridCellType::Teleporter
+                        && level.teleporterIndex(r, c) == index) {
+                        return static_cast<CellIndex>(r) * static_cast<CellIndex>(side()) + static_cast<CellIndex>(c);
+                    }
+                }
+            }
+            return INVALID_CELL;
+        }
+    };
+
+    // What the cell at (row, col) of the board transformed by symmetry holds:
+    // 0 for no object, else the type and orientation, and for a teleporter
+    // where its partner lands, one-based
+    template <typename Board>
+    std::uint64_t cellKey(const Board& board, Symmetry symmetry, int row, int col) {
+        int sourceRow = 0;
+        int sourceCol = 0;
+        Symmetries::mapCoordinates(Symmetries::inverse(symmetry), board.side(), row, col, sourceRow, sourceCol);
+        const GridCellType type = board.type(sourceRow, sourceCol);
+        if (!isObjectCell(type)) {
+            return 0;
+        }
+        const std::uint64_t typeKey = static_cast<std::uint64_t>(type) << 4;
+        if (type == GridCellType::Teleporter) {
+            const CellIndex partner = board.partner(sourceRow, sourceCol);
+            const std::uint64_t partnerKey = partner == INVALID_CELL
+                ? 0 : static_cast<std::uint64_t>(Symmetries::mapIndex(symmetry, board.side(), partner)) + 1;
+            return typeKey | (partnerKey << 8);
+        }
+        const Orientation orientation = Symmetries::mapOrientation(symmetry, type, board.orientation(sourceRow, sourceCol));
+        return typeKey | static_cast<std::uint64_t>(orientation);
+    }
+
+    template <typename Board>
+    bool canonicalFormOf(const Board& board, CanonicalForm& form) {
+        const int n = board.side();
+        if (!isEntryCell(board.entry(), n)) {
+            return false;
+        }
+
+        // Transforms putting the entry at the lowest index
+        Symmetry candidates[SYMMETRY_COUNT];
+        int count = 0;
+        CellIndex entry = INVALID_CELL;
+        for (int s = 0; s < SYMMETRY_COUNT; s++) {
+            const Symmetry symmetry = static_cast<Symmetry>(s);
+            const CellIndex mapped = Symmetries::mapIndex(symmetry, n, board.entry());
+            if (mapped < entry) {
+                entry = mapped;
+                count = 0;
+            }
+            if (mapped == entry) {
+                candidates[count++] = symmetry;
+            }
+        }
+
+        // Then the smallest interior, cell by cell. Candidates still tied at
+        // the end give the same board, one with a symmetry of its own.
+        for (int row = 1; row < n - 1 && count > 1; row++) {
+            for (int col = 1; col < n - 1 && count > 1; col++) {
+                std::uint64_t keys[SYMMETRY_COUNT];
+                std::uint64_t lowest = UINT64_MAX;
+                for (int i = 0; i < count; i++) {
+                    keys[i] = cellKey(board, candidates[i], row, col);
+                    lowest = keys[i] < lowest ? keys[i] : lowest;
+                }
+                int kept = 0;
+                for (int i = 0; i < count; i++) {
+                    if (keys[i] == lowest) {
+                        candidates[kept++] = candidates[i];
+                    }
+                }
+                count = kept;
+            }
+        }
+
+        form.symmetry = candidates[0];
+        std::uint64_t hash = mix(mix(HASH_OFFSET, static_cast<std::uint64_t>(n)), entry);
+        for (int row = 1; row < n - 1; row++) {
+            for (int col = 1; col < n - 1; col++) {
+                hash = mix(hash, cellKey(board, form.symmetry, row, col));
+            }
+        }
+        form.hash = hash;
+        return true;
+    }
+}
+
+template <typename Cells>
+int symmetryVariants(const BasicGrid<Cells>& grid, Symmetry (&variants)[SYMMETRY_COUNT]) {
+    const GridBoard<Cells> board{grid};
+    const int n = board.side();
+    if (!isEntryCell(board.entry(), n)) {
+        return 0;
+    }
+
+    // A transform repeats an earlier one if it puts the entry and every
+    // interior cell in the same place; most differ within a few cells
+    int count = 0;
+    for (int s = 0; s < SYMMETRY_COUNT; s++) {
+        const Symmetry symmetry = static_cast<Symmetry>(s);
+        const CellIndex entry = Symmetries::mapIndex(symmetry, n, board.entry());
+        bool repeats = false;
+        for (int i = 0; i < count && !repeats; i++) {
+            repeats = Symmetries::mapIndex(variants[i], n, board.entry()) == entry;
+            for (int row = 1; row < n - 1 && repeats; row++) {
+                for (int col = 1; col < n - 1 && repeats; col++) {
+                    repeats = cellKey(board, symmetry, row, col) == cellKey(board, variants[i], row, col);
+                }
+            }
+        }
+        if (!repeats) {
+            variants[count++] = symmetry;
+        }
+    }
+    return count;
+}
+
+template <typename Cells>
+bool canonicalForm(const BasicGrid<Cells>& grid, CanonicalForm& form) {
+    return canonicalFormOf(GridBoard<Cells>{grid}, form);
+}
+
+bool canonicalForm(const PackLevel& level, CanonicalForm& form) {
+    return canonicalFormOf(PackBoard{level}, form);
+}
+
+template <typename Cells>
+GridStatus canonicalize(BasicGrid<Cells>& grid) {
+    CanonicalForm form;
+    if (!canonicalForm(grid, form)) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+    const BasicGrid<Cells> source = grid;
+    return grid.transformFrom(source, form.symmetry);
+}
+
+template <typename Cells>
+GridStatus BasicGrid<Cells>::transformFrom(const BasicGrid& source, Symmetry symmetry) {
+    const int n = source.side();
+    if (&source == this || source.gridCells.size() != static_cast<std::size_t>(n) * n
+        || !isEntryCell(source.entryPos, n)) {
+        return GRID_STATUS_INVALID_ARGUMENT;
+    }
+
+    gridSize = source.gridSize;
+    minObjects = source.minObjects;
+    maxObjects = source.maxObjects;
+    if (objectTypes != source.objectTypes || objectWeights != source.objectWeights) {
+        setObjectTypes(source.objectTypes, source.objectWeights);
+    }
+    reset();
+
+    entryPos = Symmetries::mapIndex(symmetry, n, source.entryPos);
+    gridCells.edit(entryPos).type = GridCellType::Entry;
+    touchedCells.push_back(entryPos);
+    toggleFingerprint(entryPos, GridCellType::Entry, Orientation::None);
+
+    unsigned features = configuredFeatures;
+    for (int row = 1; row < n - 1; row++) {
+        for (int col = 1; col < n - 1; col++) {
+            const GridCell& from = source.cellAt(row, col);
+            if (!isObjectCell(from.type)) {
+                continue;
+            }
+            int toRow = 0;
+            int toCol = 0;
+            Symmetries::mapCoordinates(symmetry, n, row, col, toRow, toCol);
+            // Teleporters are keyed with their pairs below
+            GridCell& cell = cellAt(toRow, toCol);
+            cell.type = from.type;
+            cell.orientation = Symmetries::mapOrientation(symmetry, from.type, from.orientation);
+            touchedCells.push_back(toIndex(toRow, toCol));
+            if (from.type != GridCellType::Teleporter) {
+                toggleFingerprint(toIndex(toRow, toCol), cell.type, cell.orientation);
+            }
+            features |= walkFeaturesOf(from.type);
+        }
+    }
+    for (const TeleporterPair& pair : source.teleporterPairs) {
+        addTeleporterPair(Symmetries::mapIndex(symmetry, n, pair.first), Symmetries::mapIndex(symmetry, n, pair.second),
+                          pair.index);
+    }
+
+    selectKernels(features);
+    simulate();
+    return GRID_STATUS_OK;
+}
+
+template GridStatus BasicGrid<DenseCells>::transformFrom(const BasicGrid&, Symmetry);
+template GridStatus BasicGrid<SparseCells>::transformFrom(const BasicGrid&, Symmetry);
+template GridStatus BasicGrid<FixedCells<5>>::transformFrom(const BasicGrid&, Symmetry);
+template GridStatus BasicGrid<FixedCells<6>>::transformFrom(const BasicGrid&, Symmetry);
+template GridStatus BasicGrid<FixedCells<7>>::transformFrom(const BasicGrid&, Symmetry);
+template GridStatus BasicGrid<FixedCells<10>>::transformFrom(const BasicGrid&, Symmetry);
+
+template bool canonicalForm(const Grid&, CanonicalForm&);
+template bool canonicalForm(const SparseGrid&, CanonicalForm&);
+template bool canonicalForm(const GridN<5>&, CanonicalForm&);
+template bool canonicalForm(const GridN<6>&, CanonicalForm&);
+template bool canonicalForm(const GridN<7>&, CanonicalForm&);
+template bool canonicalForm(const GridN<10>&, CanonicalForm&);
+
+template int symmetryVariants(const Grid&, Symmetry (&)[SYMMETRY_COUNT]);
+template int symmetryVariants(const SparseGrid&, Symmetry (&)[SYMMETRY_COUNT]);
+template int symmetryVariants(const GridN<5>&, Symmetry (&)[SYMMETRY_COUNT]);
+template int symmetryVariants(const GridN<6>&, Symmetry (&)[SYMMETRY_COUNT]);
+template int symmetryVariants(const GridN<7>&, Symmetry (&)[SYMMETRY_COUNT]);
+template int symmetryVariants(const GridN<10>&, Symmetry (&)[SYMMETRY_COUNT]);
+
+template GridStatus canonicalize(Grid&);
+template GridStatus canonicalize(SparseGrid&);
+template GridStatus canonicalize(GridN<5>&);
+template GridStatus canonicalize(GridN<6>&);
+template GridStatus canonicalize(GridN<7>&);
+template GridStatus canonicalize(GridN<10>&);
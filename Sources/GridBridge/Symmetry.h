@@ -0,0 +1,175 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <cstdint>
+#include "CellStorage.h"
+#include "DirectionMaps.h"
+#include "GridCell.h"
+#include "GridStatus.h"
+
+template <typename Cells> class BasicGrid;
+class PackLevel;
+
+// The eight ways to turn or flip a square board onto itself. Rotations are
+// clockwise. A transformed board is a different puzzle with the same
+// solution, moved: the ball enters at the transformed entry, passes the
+// transformed cells and leaves at the transformed exit.
+enum class Symmetry : std::uint8_t {
+    Identity,
+    Rotate90,
+    Rotate180,
+    Rotate270,
+    MirrorColumns,   // Left and right swap
+    MirrorRows,      // Top and bottom swap
+    Transpose,       // About the diagonal from the top left
+    AntiTranspose    // About the diagonal from the top right
+};
+
+constexpr int SYMMETRY_COUNT = 8;
+
+namespace Symmetries {
+    constexpr Symmetry inverse(Symmetry symmetry) {
+        return symmetry == Symmetry::Rotate90    ? Symmetry::Rotate270
+             : symmetry == Symmetry::Rotate270   ? Symmetry::Rotate90
+             : symmetry;
+    }
+
+    // Where (row, col) of a board of the given side lands
+    constexpr void mapCoordinates(Symmetry symmetry, int side, int row, int col, int& outRow, int& outCol) {
+        const int last = side - 1;
+        switch (symmetry) {
+            case Symmetry::Identity:      outRow = row;        outCol = col;        break;
+            case Symmetry::Rotate90:      outRow = col;        outCol = last - row; break;
+            case Symmetry::Rotate180:     outRow = last - row; outCol = last - col; break;
+            case Symmetry::Rotate270:     outRow = last - col; outCol = row;        break;
+            case Symmetry::MirrorColumns: outRow = row;        outCol = last - col; break;
+            case Symmetry::MirrorRows:    outRow = last - row; outCol = col;        break;
+            case Symmetry::Transpose:     outRow = col;        outCol = row;        break;
+            case Symmetry::AntiTranspose: outRow = last - col; outCol = last - row; break;
+        }
+    }
+
+    constexpr CellIndex mapIndex(Symmetry symmetry, int side, CellIndex pos) {
+        const CellIndex n = static_cast<CellIndex>(side);
+        int row = 0;
+        int col = 0;
+        mapCoordinates(symmetry, side, static_cast<int>(pos / n), static_cast<int>(pos % n), row, col);
+        return static_cast<CellIndex>(row) * n + static_cast<CellIndex>(col);
+    }
+
+    // A direction is a step between neighbouring cells, so it turns with the
+    // coordinates about the origin
+    constexpr Direction mapDirection(Symmetry symmetry, Direction direction) {
+        constexpr int rowStep[4] = {-1, 1, 0, 0};
+        constexpr int colStep[4] = {0, 0, -1, 1};
+        if (direction == Direction::None) {
+            return Direction::None;
+        }
+        int row = 0;
+        int col = 0;
+        mapCoordinates(symmetry, 1, rowStep[static_cast<int>(direction)], colStep[static_cast<int>(direction)],
+                       row, col);
+        return row < 0 ? Direction::Up : row > 0 ? Direction::Down : col < 0 ? Direction::Left : Direction::Right;
+    }
+
+    struct OrientationTable {
+        std::uint8_t next[SYMMETRY_COUNT][DirectionMaps::CELL_TYPE_COUNT][DirectionMaps::ORIENTATION_COUNT];
+    };
+
+    // The orientation an object takes on the transformed board is the one
+    // whose transitions are its own, transformed: for every direction d,
+    // transition(type, o', S(d)) == S(transition(type, o, d)). Derived from
+    // the transition table rather than listed, so a Bumper's diagonals swap
+    // under reflections and a Tunnel's axes under quarter turns without
+    // either being spelled out. Cells without an orientation keep theirs.
+    constexpr OrientationTable buildOrientations() {
+        OrientationTable table{};
+        for (int s = 0; s < SYMMETRY_COUNT; s++) {
+            for (int t = 0; t < DirectionMaps::CELL_TYPE_COUNT; t++) {
+                for (int o = 0; o < DirectionMaps::ORIENTATION_COUNT; o++) {
+                    table.next[s][t][o] = static_cast<std::uint8_t>(o);
+                }
+            }
+        }
+
+        constexpr GridCellType oriented[] = {
+            GridCellType::Bumper, GridCellType::Tunnel, GridCellType::ActivatedBumper, GridCellType::DirectionalBumper,
+        };
+        for (int s = 0; s < SYMMETRY_COUNT; s++) {
+            const Symmetry symmetry = static_cast<Symmetry>(s);
+            for (GridCellType type : oriented) {
+                for (int o = 0; o < static_cast<int>(Orientation::None); o++) {
+                    // Orientations the type cannot take pass every direction
+                    // straight through and are left alone
+                    bool deflects = false;
+                    for (int d = 0; d < 4; d++) {
+                        deflects = deflects || DirectionMaps::transition(type, static_cast<Orientation>(o),
+                                                                         static_cast<Direction>(d)) != static_cast<Direction>(d);
+                    }
+                    if (!deflects) {
+                        continue;
+                    }
+                    for (int candidate = 0; candidate < static_cast<int>(Orientation::None); candidate++) {
+                        bool matches = true;
+                        for (int d = 0; d < 4; d++) {
+                            const Direction direction = static_cast<Direction>(d);
+                            const Direction original = DirectionMaps::transition(type, static_cast<Orientation>(o),
+                                                                                 direction);
+                            matches = matches && DirectionMaps::transition(type, static_cast<Orientation>(candidate),
+                                                                           mapDirection(symmetry, direction))
+                                                 == mapDirection(symmetry, original);
+                        }
+                        if (matches) {
+                            table.next[s][static_cast<int>(type)][o] = static_cast<std::uint8_t>(candidate);
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        return table;
+    }
+
+    inline constexpr OrientationTable orientations = buildOrientations();
+
+    constexpr Orientation mapOrientation(Symmetry symmetry, GridCellType type, Orientation orientation) {
+        return static_cast<Orientation>(
+            orientations.next[static_cast<int>(symmetry)][static_cast<int>(type)][static_cast<int>(orientation)]);
+    }
+}
+
+// A board's representative among its eight transforms, so boards that are
+// turns or flips of one another are found equal. The representative is the
+// transform with the lowest entry index, then the smallest interior read
+// row-major, each cell compared by type, orientation and, for a teleporter,
+// where its partner lands; teleporter symbols do not count. hash identifies
+// the representative's board, entry and cells, and is the same for all
+// eight transforms of a board.
+struct CanonicalForm {
+    Symmetry symmetry;   // Takes the board to its representative
+    std::uint64_t hash;
+};
+
+// Canonical form of a grid's board, or of a level read from a pack, found
+// without building any transformed board: the candidates are compared a cell
+// at a time and most drop out within the first few cells. Returns false for
+// a board without an entry on its border ring.
+template <typename Cells>
+bool canonicalForm(const BasicGrid<Cells>& grid, CanonicalForm& form);
+bool canonicalForm(const PackLevel& level, CanonicalForm& form);
+
+// The transforms that take grid's board to distinct boards, Identity first,
+// written to variants; returns how many there are. Eight for most boards,
+// fewer for one with a symmetry of its own, and 0 for a board without an
+// entry on its border ring. Each is a valid puzzle with the same ball walk,
+// turned or flipped, so one generated board gives up to eight levels
+// through transformFrom.
+template <typename Cells>
+int symmetryVariants(const BasicGrid<Cells>& grid, Symmetry (&variants)[SYMMETRY_COUNT]);
+
+// Turns grid into its canonical representative and re-simulates the ball.
+// Fails as BasicGrid::transformFrom.
+template <typename Cells>
+GridStatus canonicalize(BasicGrid<Cells>& grid);
+
+#endif // SYMMETRY_H
@@ -1,6 +1,8 @@
 #ifndef GRID_BRIDGE_H
 #define GRID_BRIDGE_H
 
+#include "GridStatus.h"
+
 #ifdef __cplusplus
 #include "Grid.h"
 // Define the actual struct
@@ -10,6 +12,7 @@ struct Grid_t {
 };
 extern "C" {
 #else
+#include <stdbool.h>
 // Opaque struct for C/Swift
 struct Grid_t;
 #endif
@@ -20,24 +23,107 @@ typedef struct Grid_t* GridHandle;
 GridHandle create_grid(int size, int min_objects, int max_objects);
 void destroy_grid(GridHandle grid);
 
-// Generate grid and get cell info
-void generate_grid(GridHandle grid);
+// Generate grid and get cell info. generate_grid returns a GridStatus.
+int generate_grid(GridHandle grid);
 int get_cell_type(GridHandle grid, int row, int col);
 int get_cell_orientation(GridHandle grid, int row, int col);
 
 // Test function
 bool test_bridge(void);
 
-extern "C" {
-    void* Grid_Create(int size, int minObjects, int maxObjects, const int* objectTypes, int objectTypesCount);
-    void Grid_GenerateGrid(void* grid);
-    int Grid_GetCellType(void* grid, int row, int col);
-    int Grid_GetCellOrientation(void* grid, int row, int col);
-    void Grid_Destroy(void* grid);
-}
+// Returns null if the configuration is unusable (size outside 3..65535, object counts
+// out of range, no object types, or a type that is not an object). Generation
+// places only the given types, all equally likely. Sides above 1024 keep only
+// their non-empty cells, so a mostly empty large board stays small.
+void* Grid_Create(int size, int minObjects, int maxObjects, const int* objectTypes, int objectTypesCount);
+// As Grid_Create, with a relative weight per object type (non-negative, not
+// all zero); null weights means equal weights
+void* Grid_CreateWeighted(int size, int minObjects, int maxObjects, const int* objectTypes,
+                          const double* objectWeights, int objectTypesCount);
+// Returns a GridStatus
+int Grid_GenerateGrid(void* grid);
+// Seeds the grid's generator and generates. The same seed and configuration
+// give the same board on every platform. Returns a GridStatus.
+int Grid_GenerateSeeded(void* grid, unsigned int seed);
+// Generates by building the ball's walk back from the exit, with exactly
+// minObjects objects on it (see BasicGrid::generateGridBackward). Returns a
+// GridStatus.
+int Grid_GenerateBackward(void* grid);
+// Turns or flips the board by a Symmetry (0 leaves it, 1-3 rotate it 90,
+// 180 and 270 degrees clockwise, 4-7 mirror it left-right, top-bottom and
+// about either diagonal), objects and teleporter pairs included, and
+// re-simulates the ball. Returns a GridStatus.
+int Grid_Transform(void* grid, int symmetry);
+int Grid_GetCellType(void* grid, int row, int col);
+int Grid_GetCellOrientation(void* grid, int row, int col);
+int Grid_GetTeleporterIndex(void* grid, int row, int col);
+// Edits one interior cell and re-simulates the ball from the first step the
+// edit affects. Returns a GridStatus; the new exit is read with Grid_GetExit.
+int Grid_SetCell(void* grid, int row, int col, int type, int orientation);
+// Writes the exit of the current grid to row/col, or -1/-1 if the ball never
+// leaves the playfield. Returns a GridStatus.
+int Grid_GetExit(void* grid, int* row, int* col);
+// Difficulty measures of the ball's current walk, as BasicGrid::pathMetrics
+// keeps them
+typedef struct {
+    unsigned int steps;                   // Cells entered, the exit included
+    unsigned int bounces;                 // Visits to Bumpers, Tunnels, DirectionalBumpers and switched-on ActivatedBumpers
+    unsigned int directionChanges;
+    unsigned int teleporterHops;
+    unsigned int selfCrossings;           // Steps into an interior cell entered before
+    unsigned int activatedPassThroughs;   // ActivatedBumpers let through on their first visit
+} GridPathMetrics;
+// Writes the metrics of the grid's walk. Returns a GridStatus.
+int Grid_GetPathMetrics(void* grid, GridPathMetrics* metrics);
+// Writes the board's 64-bit fingerprint, equal for equal boards and kept up
+// to date as the board changes, so comparing two is one integer compare.
+// Returns a GridStatus.
+int Grid_GetFingerprint(void* grid, unsigned long long* fingerprint);
+// Writes the board and its configuration in the binary grid format to
+// buffer and the byte count to written. Returns a GridStatus; with
+// GRID_STATUS_BUFFER_TOO_SMALL, written is the size needed.
+int Grid_Serialize(void* grid, unsigned char* buffer, int capacity, int* written);
+// Replaces the board and configuration with serialized ones, switching the
+// handle to the engine for the stored side. Returns a GridStatus; on failure
+// the grid keeps its old board and configuration, except that a board of
+// the grid's own engine whose configuration decodes but whose cells do not
+// leaves that configuration with an empty board. It generates as configured
+// either way.
+int Grid_Deserialize(void* grid, const unsigned char* data, int size);
+void Grid_Destroy(void* grid);
+
+// Maps a level pack file (see LevelPack.h) read-only; returns null if it
+// cannot be opened or is not a pack. Opening reads only the pack's tables,
+// whatever its level count.
+void* LevelPack_Open(const char* path);
+void LevelPack_Close(void* pack);
+// Index of the pack config matching a Level.swift entry, or -1
+int LevelPack_FindConfig(void* pack, int size, int minObjects, int maxObjects,
+                         const int* objectTypes, int objectTypesCount);
+// Difficulty buckets of a config, 0 the easiest, and the levels in each
+int LevelPack_GetBucketCount(void* pack, int config);
+long long LevelPack_GetLevelCount(void* pack, int config, int bucket);
+// Level random % count of the bucket, read in place, or null if the bucket
+// is empty or the config is stored as seeds. The handle stays valid until
+// the pack is closed.
+const void* LevelPack_GetLevel(void* pack, int config, int bucket, unsigned long long random);
+// For a config stored as seeds, writes the seed and symmetry of level
+// random % count of the bucket; rebuild the level with Grid_GenerateSeeded
+// on a grid of the config, then Grid_Transform. Returns a GridStatus;
+// GRID_STATUS_INVALID_ARGUMENT for an empty bucket or a config stored as
+// boards.
+int LevelPack_GetLevelSeed(void* pack, int config, int bucket, unsigned long long random, unsigned int* seed,
+                           int* symmetry);
+// Board of a pack level, read as with the Grid_* accessors
+int PackLevel_GetSize(const void* level);
+int PackLevel_GetCellType(const void* level, int row, int col);
+int PackLevel_GetCellOrientation(const void* level, int row, int col);
+int PackLevel_GetTeleporterIndex(const void* level, int row, int col);
+// As Grid_GetExit. Returns a GridStatus.
+int PackLevel_GetExit(const void* level, int* row, int* col);
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif // GRID_BRIDGE_H 
\ No newline at end of file
+#endif // GRID_BRIDGE_H
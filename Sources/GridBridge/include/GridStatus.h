@@ -0,0 +1,17 @@
+#ifndef GRID_STATUS_H
+#define GRID_STATUS_H
+
+// Result codes shared by the grid engine and the C bridge. Nothing in either
+// throws; failures are reported through these values instead.
+typedef enum GridStatus {
+    GRID_STATUS_OK = 0,
+    GRID_STATUS_NULL_GRID = 1,            // Handle was null
+    GRID_STATUS_INVALID_ARGUMENT = 2,     // Size, object counts or types unusable
+    GRID_STATUS_OUT_OF_BOUNDS = 3,        // Row/column outside the grid
+    GRID_STATUS_GENERATION_FAILED = 4,    // No valid grid within the attempt limit
+    GRID_STATUS_BAD_FORMAT = 5,           // Serialized grid truncated, corrupt or of an unknown version
+    GRID_STATUS_BUFFER_TOO_SMALL = 6,     // Output buffer shorter than the serialized grid
+    GRID_STATUS_IO_ERROR = 7              // File could not be opened, mapped or written
+} GridStatus;
+
+#endif // GRID_STATUS_H
@@ -14,6 +14,16 @@ enum GridCellType: Int {
     case directionalBumper = 8
 }
 
+// Difficulty measures of the ball's walk, laid out as GridPathMetrics
+struct PathMetrics {
+    var steps: UInt32 = 0
+    var bounces: UInt32 = 0
+    var directionChanges: UInt32 = 0
+    var teleporterHops: UInt32 = 0
+    var selfCrossings: UInt32 = 0
+    var activatedPassThroughs: UInt32 = 0
+}
+
 enum GridOrientation: Int {
     case downRight = 0
     case upRight = 1
@@ -36,7 +46,18 @@ class GridBridge {
         
         // Convert Swift array to vector
         let objectTypesVector = objectTypes.map { Int32($0.rawValue) }
-        grid = Grid_Create(size, minObjects, maxObjects, objectTypesVector, Int32(objectTypesVector.count))
+        guard let handle = Grid_Create(size, minObjects, maxObjects, objectTypesVector, Int32(objectTypesVector.count)) else {
+            fatalError("Invalid grid configuration: size \(size), objects \(minObjects)...\(maxObjects)")
+        }
+        grid = handle
+    }
+    
+    // Grid that generates with exactly the level's configuration and object types
+    convenience init(level: Level) {
+        self.init(size: Int32(level.gridSize),
+                  minObjects: Int32(level.minObjects),
+                  maxObjects: Int32(level.maxObjects),
+                  objectTypes: level.viableObjectTypes)
     }
     
     deinit {
@@ -44,10 +65,37 @@ class GridBridge {
         Grid_Destroy(grid)
     }
     
-    func generateGrid() {
+    // Returns false if the engine could not produce a valid grid
+    @discardableResult
+    func generateGrid() -> Bool {
         print("Swift: Calling generateGrid...")
-        Grid_GenerateGrid(grid)
-        print("Swift: generateGrid call complete")
+        let status = Grid_GenerateGrid(grid)
+        print("Swift: generateGrid call complete, status \(status)")
+        return status == gridStatusOK
+    }
+    
+    // Generates the board the seed gives for this configuration, the same
+    // on every platform, turned or flipped by symmetry as transform(symmetry:)
+    // does; returns false if the engine could not produce one
+    @discardableResult
+    func generateGrid(seed: UInt32, symmetry: Int32 = 0) -> Bool {
+        return Grid_GenerateSeeded(grid, seed) == gridStatusOK
+            && (symmetry == 0 || transform(symmetry: symmetry))
+    }
+    
+    // Generates a board whose ball meets exactly minObjects objects, built
+    // back from the exit; returns false if the engine could not produce one
+    @discardableResult
+    func generateGridBackward() -> Bool {
+        return Grid_GenerateBackward(grid) == gridStatusOK
+    }
+    
+    // Rotates (1-3: 90, 180 and 270 degrees clockwise) or mirrors (4-7:
+    // left-right, top-bottom and about either diagonal) the current board
+    // into another puzzle with the same solution, turned the same way
+    @discardableResult
+    func transform(symmetry: Int32) -> Bool {
+        return Grid_Transform(grid, symmetry) == gridStatusOK
     }
     
     func getCellType(row: Int32, col: Int32) -> GridCellType {
@@ -63,10 +111,157 @@ class GridBridge {
     func getTeleporterIndex(row: Int32, col: Int32) -> Int {
         return Int(Grid_GetTeleporterIndex(grid, row, col))
     }
+    
+    // Replaces one interior cell; returns false if the edit was rejected
+    @discardableResult
+    func setCell(row: Int32, col: Int32, type: GridCellType, orientation: GridOrientation) -> Bool {
+        return Grid_SetCell(grid, row, col, Int32(type.rawValue), Int32(orientation.rawValue)) == gridStatusOK
+    }
+    
+    // Measures of the current walk, counted while it was generated or
+    // simulated
+    var pathMetrics: PathMetrics {
+        var metrics = PathMetrics()
+        _ = Grid_GetPathMetrics(grid, &metrics)
+        return metrics
+    }
+    
+    // Fingerprint of the current board: equal for equal boards, so a level
+    // seen before is found with one compare
+    var fingerprint: UInt64 {
+        var value: UInt64 = 0
+        _ = Grid_GetFingerprint(grid, &value)
+        return value
+    }
+    
+    // The board and its configuration in the binary grid format, or nil if
+    // the board has no entry yet
+    func serialized() -> [UInt8]? {
+        var written: Int32 = 0
+        guard Grid_Serialize(grid, nil, 0, &written) == gridStatusBufferTooSmall else {
+            return nil
+        }
+        var bytes = [UInt8](repeating: 0, count: Int(written))
+        guard Grid_Serialize(grid, &bytes, written, &written) == gridStatusOK else {
+            return nil
+        }
+        return bytes
+    }
+    
+    // Replaces the board with one from serialized(); returns false if the
+    // bytes are not a valid grid, leaving the board empty
+    @discardableResult
+    func load(_ bytes: [UInt8]) -> Bool {
+        return Grid_Deserialize(grid, bytes, Int32(bytes.count)) == gridStatusOK
+    }
+    
+    // Where the ball leaves the current grid, or nil if it never does
+    func getExit() -> Pos? {
+        var row: Int32 = -1
+        var col: Int32 = -1
+        guard Grid_GetExit(grid, &row, &col) == gridStatusOK, row >= 0 else {
+            return nil
+        }
+        return (row, col)
+    }
+}
+
+// A level pack file mapped read-only. Picking a level reads it in place, so
+// neither opening nor picking depends on how many levels the pack holds.
+class LevelPack {
+    private var pack: OpaquePointer
+
+    // Returns nil if the file cannot be opened or is not a level pack
+    init?(path: String) {
+        guard let handle = LevelPack_Open(path) else {
+            return nil
+        }
+        pack = handle
+    }
+
+    deinit {
+        LevelPack_Close(pack)
+    }
+
+    // Number of difficulty buckets the pack has for a level, 0 if none
+    func bucketCount(level: Level) -> Int {
+        guard let config = config(for: level) else {
+            return 0
+        }
+        return Int(LevelPack_GetBucketCount(pack, config))
+    }
+
+    // A random level of the given configuration and difficulty bucket, or nil
+    // if the pack has none or stores the configuration as seeds
+    func randomLevel(_ level: Level, bucket: Int) -> PackLevel? {
+        guard let config = config(for: level),
+              let handle = LevelPack_GetLevel(pack, config, Int32(bucket), UInt64.random(in: 0...UInt64.max)) else {
+            return nil
+        }
+        return PackLevel(pack: self, level: handle)
+    }
+
+    // Seed and symmetry of a random level of a configuration the pack stores
+    // as seeds, for GridBridge(level:).generateGrid(seed:symmetry:), or nil if
+    // it has none
+    func randomSeed(_ level: Level, bucket: Int) -> (seed: UInt32, symmetry: Int32)? {
+        var seed: UInt32 = 0
+        var symmetry: Int32 = 0
+        guard let config = config(for: level),
+              LevelPack_GetLevelSeed(pack, config, Int32(bucket), UInt64.random(in: 0...UInt64.max),
+                                     &seed, &symmetry) == gridStatusOK else {
+            return nil
+        }
+        return (seed, symmetry)
+    }
+
+    private func config(for level: Level) -> Int32? {
+        let objectTypes = level.viableObjectTypes.map { Int32($0.rawValue) }
+        let config = LevelPack_FindConfig(pack, Int32(level.gridSize), Int32(level.minObjects),
+                                          Int32(level.maxObjects), objectTypes, Int32(objectTypes.count))
+        return config >= 0 ? config : nil
+    }
+}
+
+// One level of a pack, read with the same accessors as GridBridge. Holds the
+// pack open for as long as it lives.
+struct PackLevel {
+    fileprivate let pack: LevelPack
+    fileprivate let level: OpaquePointer
+
+    var size: Int32 {
+        return PackLevel_GetSize(level)
+    }
+
+    func getCellType(row: Int32, col: Int32) -> GridCellType {
+        return GridCellType(rawValue: Int(PackLevel_GetCellType(level, row, col))) ?? .empty
+    }
+
+    func getCellOrientation(row: Int32, col: Int32) -> GridOrientation {
+        return GridOrientation(rawValue: Int(PackLevel_GetCellOrientation(level, row, col))) ?? .none
+    }
+
+    func getTeleporterIndex(row: Int32, col: Int32) -> Int {
+        return Int(PackLevel_GetTeleporterIndex(level, row, col))
+    }
+
+    // Where the ball leaves the level, or nil if it never does
+    func getExit() -> Pos? {
+        var row: Int32 = -1
+        var col: Int32 = -1
+        guard PackLevel_GetExit(level, &row, &col) == gridStatusOK, row >= 0 else {
+            return nil
+        }
+        return (row, col)
+    }
 }
 
 private let gridBridgeLib = "libGridBridge.dylib"
 
+// GRID_STATUS_OK and GRID_STATUS_BUFFER_TOO_SMALL in GridStatus.h
+private let gridStatusOK: Int32 = 0
+private let gridStatusBufferTooSmall: Int32 = 6
+
 @_silgen_name("create_grid")
 private func create_grid(_ size: Int32, _ min_objects: Int32, _ max_objects: Int32) -> OpaquePointer?
 
@@ -74,7 +269,7 @@ private func create_grid(_ size: Int32, _ min_objects: Int32, _ max_objects: Int
 private func destroy_grid(_ handle: OpaquePointer)
 
 @_silgen_name("generate_grid")
-private func generate_grid(_ handle: OpaquePointer)
+private func generate_grid(_ handle: OpaquePointer) -> Int32
 
 @_silgen_name("get_cell_type")
 private func get_cell_type(_ handle: OpaquePointer, _ row: Int32, _ col: Int32) -> Int32
@@ -90,10 +285,25 @@ private func Grid_Destroy(_ grid: OpaquePointer)
 
 @_silgen_name("Grid_Create")
 private func Grid_Create(_ size: Int32, _ minObjects: Int32, _ maxObjects: Int32, 
-                        _ objectTypes: [Int32], _ objectTypesCount: Int32) -> OpaquePointer 
+                        _ objectTypes: [Int32], _ objectTypesCount: Int32) -> OpaquePointer?
 
 @_silgen_name("Grid_GenerateGrid")
-private func Grid_GenerateGrid(_ grid: OpaquePointer) 
+private func Grid_GenerateGrid(_ grid: OpaquePointer) -> Int32
+
+@_silgen_name("Grid_GenerateSeeded")
+private func Grid_GenerateSeeded(_ grid: OpaquePointer, _ seed: UInt32) -> Int32
+
+@_silgen_name("Grid_GenerateBackward")
+private func Grid_GenerateBackward(_ grid: OpaquePointer) -> Int32
+
+@_silgen_name("Grid_GetPathMetrics")
+private func Grid_GetPathMetrics(_ grid: OpaquePointer, _ metrics: UnsafeMutablePointer<PathMetrics>) -> Int32
+
+@_silgen_name("Grid_GetFingerprint")
+private func Grid_GetFingerprint(_ grid: OpaquePointer, _ fingerprint: UnsafeMutablePointer<UInt64>) -> Int32
+
+@_silgen_name("Grid_Transform")
+private func Grid_Transform(_ grid: OpaquePointer, _ symmetry: Int32) -> Int32
 
 @_silgen_name("Grid_GetCellType")
 private func Grid_GetCellType(_ grid: OpaquePointer, _ row: Int32, _ col: Int32) -> Int32
@@ -102,4 +312,52 @@ private func Grid_GetCellType(_ grid: OpaquePointer, _ row: Int32, _ col: Int32)
 private func Grid_GetCellOrientation(_ grid: OpaquePointer, _ row: Int32, _ col: Int32) -> Int32 
 
 @_silgen_name("Grid_GetTeleporterIndex")
-private func Grid_GetTeleporterIndex(_ grid: OpaquePointer, _ row: Int32, _ col: Int32) -> Int32 
\ No newline at end of file
+private func Grid_GetTeleporterIndex(_ grid: OpaquePointer, _ row: Int32, _ col: Int32) -> Int32 
+
+@_silgen_name("Grid_SetCell")
+private func Grid_SetCell(_ grid: OpaquePointer, _ row: Int32, _ col: Int32, _ type: Int32, _ orientation: Int32) -> Int32
+
+@_silgen_name("Grid_GetExit")
+private func Grid_GetExit(_ grid: OpaquePointer, _ row: UnsafeMutablePointer<Int32>, _ col: UnsafeMutablePointer<Int32>) -> Int32
+
+@_silgen_name("Grid_Serialize")
+private func Grid_Serialize(_ grid: OpaquePointer, _ buffer: UnsafeMutablePointer<UInt8>?, _ capacity: Int32, _ written: UnsafeMutablePointer<Int32>) -> Int32
+
+@_silgen_name("Grid_Deserialize")
+private func Grid_Deserialize(_ grid: OpaquePointer, _ data: UnsafePointer<UInt8>, _ size: Int32) -> Int32
+
+@_silgen_name("LevelPack_Open")
+private func LevelPack_Open(_ path: UnsafePointer<CChar>) -> OpaquePointer?
+
+@_silgen_name("LevelPack_Close")
+private func LevelPack_Close(_ pack: OpaquePointer)
+
+@_silgen_name("LevelPack_FindConfig")
+private func LevelPack_FindConfig(_ pack: OpaquePointer, _ size: Int32, _ minObjects: Int32, _ maxObjects: Int32,
+                                  _ objectTypes: [Int32], _ objectTypesCount: Int32) -> Int32
+
+@_silgen_name("LevelPack_GetBucketCount")
+private func LevelPack_GetBucketCount(_ pack: OpaquePointer, _ config: Int32) -> Int32
+
+@_silgen_name("LevelPack_GetLevel")
+private func LevelPack_GetLevel(_ pack: OpaquePointer, _ config: Int32, _ bucket: Int32, _ random: UInt64) -> OpaquePointer?
+
+@_silgen_name("LevelPack_GetLevelSeed")
+private func LevelPack_GetLevelSeed(_ pack: OpaquePointer, _ config: Int32, _ bucket: Int32, _ random: UInt64,
+                                    _ seed: UnsafeMutablePointer<UInt32>,
+                                    _ symmetry: UnsafeMutablePointer<Int32>) -> Int32
+
+@_silgen_name("PackLevel_GetSize")
+private func PackLevel_GetSize(_ level: OpaquePointer) -> Int32
+
+@_silgen_name("PackLevel_GetCellType")
+private func PackLevel_GetCellType(_ level: OpaquePointer, _ row: Int32, _ col: Int32) -> Int32
+
+@_silgen_name("PackLevel_GetCellOrientation")
+private func PackLevel_GetCellOrientation(_ level: OpaquePointer, _ row: Int32, _ col: Int32) -> Int32
+
+@_silgen_name("PackLevel_GetTeleporterIndex")
+private func PackLevel_GetTeleporterIndex(_ level: OpaquePointer, _ row: Int32, _ col: Int32) -> Int32
+
+@_silgen_name("PackLevel_GetExit")
+private func PackLevel_GetExit(_ level: OpaquePointer, _ row: UnsafeMutablePointer<Int32>, _ col: UnsafeMutablePointer<Int32>) -> Int32
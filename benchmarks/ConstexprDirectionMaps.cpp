@@ -0,0 +1,8 @@
+// The current constant-initialized transition table in a library of its
+// own, the "after" side of LoadTimeBenchmark next to LegacyDirectionMaps.
+#include <cstddef>
+#include "DirectionMaps.h"
+
+extern "C" std::size_t ConstexprDirectionMaps_Size() {
+    return sizeof(DirectionMaps::transitions);
+}
@@ -0,0 +1,449 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+#include "Grid.h"
+#include "AllEntriesSolver.h"
+#include "JumpSimulator.h"
+#include "BatchSimulator.h"
+#include "ScanKernels.h"
+#include "LevelEnumerator.h"
+#include "LevelPack.h"
+#include "Symmetry.h"
+
+// Times `iterations` calls of body and prints the mean cost per call
+template <typename Body>
+static void runBenchmark(const char* name, int iterations, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        body();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double nanoseconds = std::chrono::duration<double, std::nano>(elapsed).count();
+    std::printf("%-32s %10d iterations %12.1f ns/op\n", name, iterations, nanoseconds / iterations);
+}
+
+int main() {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+
+    for (int size : {5, 7, 10}) {
+        Grid grid(size, size - 3, size, objectTypes);
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "generateGrid %dx%d", size, size);
+        runBenchmark(name, 20000, [&] { grid.generateGrid(); });
+
+        std::snprintf(name, sizeof(name), "simulate %dx%d", size, size);
+        volatile int sink = 0;
+        runBenchmark(name, 1000000, [&] { sink += grid.simulate(); });
+    }
+
+    // Decoys fill the board up to maxObjects after the solution path is laid
+    Grid withoutDecoys(10, 6, 6, objectTypes);
+    runBenchmark("generateGrid 10x10 no decoys", 20000, [&] { withoutDecoys.generateGrid(); });
+    Grid withDecoys(10, 6, 20, objectTypes);
+    runBenchmark("generateGrid 10x10 decoys", 20000, [&] { withDecoys.generateGrid(); });
+
+    // Forward against backward generation: cost per board, then what the
+    // boards look like. Forward walks retry until a path takes minObjects
+    // objects; backward chains lay exactly that many in one pass.
+    {
+        struct Shape {
+            double made = 0, steps = 0, turns = 0, pathObjects = 0, sameSide = 0;
+            std::set<std::uint64_t> boards;
+        };
+        auto measure = [](const Grid& grid, Shape& shape) {
+            std::set<CellIndex> entered;
+            for (std::size_t step = 0; step < grid.ballPath.size(); step++) {
+                const PathStep& path = grid.ballPath[step];
+                entered.insert(path.pos);
+                entered.insert(path.landed);
+                shape.turns += step > 0 && step + 1 < grid.ballPath.size()
+                    && path.direction != grid.ballPath[step - 1].direction ? 1 : 0;
+            }
+            for (CellIndex pos : entered) {
+                shape.pathObjects += isObjectCell(grid.gridCells[pos].type) ? 1 : 0;
+            }
+            shape.made++;
+            shape.steps += static_cast<double>(grid.ballPath.size());
+            const int n = grid.side();
+            auto edge = [&](CellIndex pos) {
+                return grid.rowOf(pos) == 0 ? 0 : grid.rowOf(pos) == n - 1 ? 1 : grid.colOf(pos) == 0 ? 2 : 3;
+            };
+            shape.sameSide += edge(grid.entryPos) == edge(grid.exitPos) ? 1 : 0;
+            shape.boards.insert(grid.fingerprint());
+        };
+        const struct {
+            int size, minObjects, maxObjects;
+            std::vector<GridCellType> types;
+        } configs[] = {
+            {6, 3, 4, {GridCellType::Bumper, GridCellType::Tunnel}},
+            {10, 10, 12, objectTypes},
+            {32, 40, 60, objectTypes},
+            {100, 100, 150, objectTypes},
+        };
+        for (const auto& config : configs) {
+            const int boards = config.size >= 100 ? 50 : 2000;
+            for (bool backward : {false, true}) {
+                Grid grid(config.size, config.minObjects, config.maxObjects, config.types);
+                grid.seed(49);
+                Shape shape;
+                char name[64];
+                std::snprintf(name, sizeof(name), "generateGrid%s %dx%d %d-%d", backward ? "Backward" : "",
+                              config.size, config.size, config.minObjects, config.maxObjects);
+                runBenchmark(name, boards, [&] {
+                    if ((backward ? grid.generateGridBackward() : grid.generateGrid()) == GRID_STATUS_OK) {
+                        measure(grid, shape);
+                    }
+                });
+                const double made = std::max(1.0, shape.made);
+                std::printf("    %.0f of %d generated: %.1f steps, %.1f turns, %.2f objects on the path, "
+                            "%.0f%% exit on the entry's side, %.1f%% distinct\n",
+                            shape.made, boards, shape.steps / made, shape.turns / made, shape.pathObjects / made,
+                            100.0 * shape.sameSide / made, 100.0 * static_cast<double>(shape.boards.size()) / made);
+            }
+        }
+    }
+
+    // Toggling one cell re-walks only the path after the first step it touches
+    Grid edited(10, 6, 12, objectTypes);
+    edited.generateGrid();
+    int editCount = 0;
+    runBenchmark("setCell 10x10", 1000000, [&] {
+        int row = 1 + editCount % 8;
+        int col = 1 + (editCount / 8) % 8;
+        bool place = (editCount++ / 64) % 2 == 0;
+        edited.setCell(row, col, place ? GridCellType::Bumper : GridCellType::Empty,
+                       place ? Orientation::UpRight : Orientation::None);
+    });
+
+    // Every edge entry, solved with shared segments versus one walk per entry
+    AllEntriesSolver solver;
+    for (int size : {10, 32}) {
+        Grid board(size, size - 3, 2 * size, objectTypes);
+        board.generateGrid();
+        Grid walker = board;
+        const std::vector<EntryExit>& entries = solver.solve(board);
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "all entries solver %dx%d", size, size);
+        volatile std::uint32_t sink = 0;
+        runBenchmark(name, 20000, [&] { sink += solver.solve(board).size(); });
+
+        std::snprintf(name, sizeof(name), "all entries simulate %dx%d", size, size);
+        runBenchmark(name, 20000, [&] {
+            for (const EntryExit& entry : entries) {
+                walker.entryPos = entry.entry;
+                sink += walker.simulate();
+            }
+        });
+    }
+
+    // Large sparse boards, where the ball crosses long empty stretches
+    // between bounces
+    const GridCellType sparseTypes[] = {GridCellType::Bumper, GridCellType::DirectionalBumper, GridCellType::Tunnel};
+    JumpSimulator jumper;
+    for (int size : {100, 1000}) {
+        Grid board(size, 0, 0, objectTypes);
+        std::mt19937 placement(size);
+        for (int i = 0; i < 2 * size; i++) {
+            GridCell& cell = board.cellAt(1 + placement() % (size - 2), 1 + placement() % (size - 2));
+            cell.type = sparseTypes[placement() % 3];
+            cell.orientation = board.getViableOrientation(cell.type);
+        }
+        board.entryPos = board.toIndex(0, size / 2);
+        board.simulate();
+        jumper.build(board);
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "simulate %dx%d sparse", size, size);
+        volatile std::uint32_t sink = 0;
+        runBenchmark(name, 1000, [&] { sink += board.simulate(); });
+
+        std::snprintf(name, sizeof(name), "jump simulate %dx%d sparse", size, size);
+        runBenchmark(name, 1000, [&] { sink += jumper.simulate(board.entryPos).exit; });
+    }
+
+    // Large boards: generation, cell-stepping simulation and jump simulation.
+    // The solution chain rarely reaches much past 100 objects, so larger
+    // boards get more decoys rather than a longer required path.
+    for (int size : {100, 1000, 4096}) {
+        Grid board(size, std::min(size / 10, 100), size, objectTypes);
+        int iterations = size == 100 ? 1000 : size == 1000 ? 20 : 3;
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "generateGrid %dx%d", size, size);
+        runBenchmark(name, iterations, [&] { board.generateGrid(); });
+
+        std::snprintf(name, sizeof(name), "simulate %dx%d", size, size);
+        volatile std::uint32_t sink = 0;
+        runBenchmark(name, iterations, [&] { sink += board.simulate(); });
+
+        jumper.build(board);
+        std::snprintf(name, sizeof(name), "jump simulate %dx%d", size, size);
+        runBenchmark(name, iterations, [&] { sink += jumper.simulate(board.entryPos).exit; });
+    }
+
+    // Dense against sparse storage at a fixed object budget. Sparse memory
+    // falls below dense around 32x32; sparse time stays higher, since every
+    // read is a hash probe, but the gap narrows once dense boards leave cache
+    for (int size : {10, 32, 100, 316, 1000, 2048}) {
+        Grid dense(size, 10, 40, objectTypes);
+        SparseGrid sparse(size, 10, 40, objectTypes);
+        int iterations = size <= 100 ? 2000 : size <= 316 ? 200 : 5;
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "dense generate %dx%d", size, size);
+        runBenchmark(name, iterations, [&] { dense.generateGrid(); });
+        std::snprintf(name, sizeof(name), "sparse generate %dx%d", size, size);
+        runBenchmark(name, iterations, [&] { sparse.generateGrid(); });
+
+        std::snprintf(name, sizeof(name), "dense simulate %dx%d", size, size);
+        volatile std::uint32_t sink = 0;
+        runBenchmark(name, iterations, [&] { sink += dense.simulate(); });
+        std::snprintf(name, sizeof(name), "sparse simulate %dx%d", size, size);
+        runBenchmark(name, iterations, [&] { sink += sparse.simulate(); });
+
+        std::printf("%-32s dense %10zu bytes   sparse %10zu bytes\n", "cell memory",
+                    dense.gridCells.memoryBytes(), sparse.gridCells.memoryBytes());
+    }
+
+    // Compile-time sized engines against the generic one, per level size. At
+    // these sizes both stay within noise of each other: the walk is bound by
+    // cell loads and branches, not the row-stride multiply the constant removes
+    auto compareFixed = [&](auto& fixed, Grid& generic, int size) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "generic generate %dx%d", size, size);
+        runBenchmark(name, 20000, [&] { generic.generateGrid(); });
+        std::snprintf(name, sizeof(name), "GridN generate %dx%d", size, size);
+        runBenchmark(name, 20000, [&] { fixed.generateGrid(); });
+
+        // Boards are random, so both sides simulate a fresh board every 1000
+        // walks and are compared over the same number of boards
+        volatile std::uint32_t sink = 0;
+        int walks = 0;
+        std::snprintf(name, sizeof(name), "generic simulate %dx%d", size, size);
+        runBenchmark(name, 1000000, [&] {
+            if (walks++ % 1000 == 0) generic.generateGrid();
+            sink += generic.simulate();
+        });
+        walks = 0;
+        std::snprintf(name, sizeof(name), "GridN simulate %dx%d", size, size);
+        runBenchmark(name, 1000000, [&] {
+            if (walks++ % 1000 == 0) fixed.generateGrid();
+            sink += fixed.simulate();
+        });
+    };
+    {
+        Grid generic5(5, 2, 5, objectTypes);
+        GridN<5> fixed5(5, 2, 5, objectTypes);
+        compareFixed(fixed5, generic5, 5);
+        Grid generic6(6, 3, 6, objectTypes);
+        GridN<6> fixed6(6, 3, 6, objectTypes);
+        compareFixed(fixed6, generic6, 6);
+        Grid generic7(7, 4, 7, objectTypes);
+        GridN<7> fixed7(7, 4, 7, objectTypes);
+        compareFixed(fixed7, generic7, 7);
+        Grid generic10(10, 7, 10, objectTypes);
+        GridN<10> fixed10(10, 7, 10, objectTypes);
+        compareFixed(fixed10, generic10, 10);
+    }
+
+    // Bumper and tunnel levels: the walk specialized on those types against
+    // the all-types walk over the same boards. Reconfiguring the copy keeps
+    // its board and selects the all-types kernel until it is regenerated.
+    {
+        Grid specialized(10, 7, 10, {GridCellType::Bumper, GridCellType::Tunnel});
+        volatile std::uint32_t sink = 0;
+        double specializedNs = 0;
+        double generalNs = 0;
+        for (int board = 0; board < 200; board++) {
+            specialized.generateGrid();
+            Grid general = specialized;
+            general.setObjectTypes(objectTypes);
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < 5000; i++) sink += specialized.simulate();
+            auto middle = std::chrono::steady_clock::now();
+            for (int i = 0; i < 5000; i++) sink += general.simulate();
+            auto end = std::chrono::steady_clock::now();
+            specializedNs += std::chrono::duration<double, std::nano>(middle - start).count();
+            generalNs += std::chrono::duration<double, std::nano>(end - middle).count();
+        }
+        std::printf("%-32s %10d iterations %12.1f ns/op\n", "specialized simulate 10x10 B+T", 1000000, specializedNs / 1000000);
+        std::printf("%-32s %10d iterations %12.1f ns/op\n", "all-types simulate 10x10 B+T", 1000000, generalNs / 1000000);
+    }
+
+    // Many boards walked one at a time against the batch walker, per board
+    BatchSimulator batch;
+    for (int size : {7, 10, 32}) {
+        std::vector<Grid> boards(4096, Grid(size, size - 3, size, objectTypes));
+        std::vector<const Grid*> pointers;
+        for (Grid& board : boards) {
+            board.generateGrid();
+            pointers.push_back(&board);
+        }
+        batch.build(pointers);
+
+        char name[64];
+        volatile std::uint32_t sink = 0;
+        std::snprintf(name, sizeof(name), "per-board simulate %dx%d", size, size);
+        int next = 0;
+        runBenchmark(name, 409600, [&] { sink += boards[next++ % 4096].simulate(); });
+        std::snprintf(name, sizeof(name), "batch scalar %dx%d", size, size);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 100; i++) sink += batch.simulateScalar().back().exit;
+        double scalarNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-32s %10d iterations %12.1f ns/op\n", name, 409600, scalarNs / 409600);
+        std::snprintf(name, sizeof(name), "batch %s %dx%d", BatchSimulator::hasAvx2() ? "AVX2" : "scalar", size, size);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 100; i++) sink += batch.simulate().back().exit;
+        double batchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-32s %10d iterations %12.1f ns/op\n", name, 409600, batchNs / 409600);
+    }
+
+    // Ray queries on a mostly open 1024x1024 board, along rows and columns
+    {
+        const int side = 1024;
+        std::vector<GridCell> cells(side * side);
+        std::mt19937 fill(side);
+        for (int i = 0; i < side * 4; i++) {
+            cells[fill() % cells.size()].type = GridCellType::Bumper;
+        }
+        std::vector<std::uint64_t> mask(side / 64);
+        volatile std::uint32_t sink = 0;
+        int next = 0;
+        for (std::ptrdiff_t stride : {std::ptrdiff_t{1}, std::ptrdiff_t{side}}) {
+            const char* axis = stride == 1 ? "row" : "column";
+            auto ray = [&] {
+                int line = next++ % side;
+                const GridCell* first = stride == 1 ? &cells[line * side] : &cells[line];
+                return ScanKernels::Ray{first, stride, side};
+            };
+            char name[64];
+            std::snprintf(name, sizeof(name), "first obstacle %s scalar", axis);
+            runBenchmark(name, 100000, [&] { sink += ScanKernels::firstObstacleScalar(ray()); });
+            std::snprintf(name, sizeof(name), "first obstacle %s vector", axis);
+            runBenchmark(name, 100000, [&] { sink += ScanKernels::firstObstacleVector(ray()); });
+            std::snprintf(name, sizeof(name), "open mask %s scalar", axis);
+            runBenchmark(name, 100000, [&] { ScanKernels::openMaskScalar(ray(), mask.data()); sink += mask[0]; });
+            std::snprintf(name, sizeof(name), "open mask %s vector", axis);
+            runBenchmark(name, 100000, [&] { ScanKernels::openMaskVector(ray(), mask.data()); sink += mask[0]; });
+        }
+    }
+
+    // Saving and loading a level board in the binary format
+    {
+        Grid level(10, 7, 10, objectTypes);
+        level.generateGrid();
+        Grid loaded = level;
+        std::vector<std::uint8_t> bytes(level.serializedSize());
+        std::size_t written = 0;
+        volatile std::size_t sink = 0;
+        runBenchmark("serialize 10x10", 1000000, [&] {
+            level.serialize(bytes.data(), bytes.size(), written);
+            sink += written;
+        });
+        runBenchmark("deserialize 10x10", 1000000, [&] { sink += loaded.deserialize(bytes.data(), written); });
+        std::printf("%-32s %10zu bytes   ASCII %10zu bytes\n", "10x10 serialized", written, level.toASCII().size());
+    }
+
+    // Opening a level pack reads its tables only, so it should cost the same
+    // at any level count; picking a level is a table lookup
+    {
+        Grid level(10, 7, 10, objectTypes);
+        level.generateGrid();
+        volatile std::uint64_t sink = 0;
+        for (int levels : {1000, 1000000}) {
+            LevelPackWriter writer;
+            for (int i = 0; i < levels; i++) {
+                writer.add(level, static_cast<std::uint32_t>(i % 8));
+            }
+            const char* path = "GridBenchmarks.pack";
+            writer.write(path);
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "pack open %d levels", levels);
+            runBenchmark(name, 10000, [&] {
+                LevelPack pack;
+                sink += pack.open(path);
+            });
+
+            LevelPack pack;
+            pack.open(path);
+            std::mt19937_64 random(1);
+            std::snprintf(name, sizeof(name), "pack pick+read %d levels", levels);
+            runBenchmark(name, 1000000, [&] {
+                PackLevel picked(pack.level(0, static_cast<int>(random() % 8), random()));
+                for (int row = 0; row < 10; row++) {
+                    for (int col = 0; col < 10; col++) {
+                        sink += static_cast<std::uint64_t>(picked.type(row, col));
+                    }
+                }
+            });
+            pack.close();
+            std::remove(path);
+        }
+    }
+
+    // The pack compiler keys every generated level by its canonical form, so
+    // it should cost a small fraction of generating the level
+    {
+        Grid level(10, 7, 10, objectTypes);
+        level.generateGrid();
+        Grid transformed = level;
+        volatile std::uint64_t sink = 0;
+        runBenchmark("canonicalForm 10x10", 1000000, [&] {
+            CanonicalForm form;
+            canonicalForm(level, form);
+            sink += form.hash;
+        });
+        runBenchmark("transformFrom 10x10", 1000000, [&] {
+            sink += transformed.transformFrom(level, Symmetry::Rotate90);
+        });
+    }
+
+    // Duplicate checks: different boards are told apart by their
+    // fingerprints alone, equal ones are confirmed on the cells
+    {
+        Grid level(10, 7, 10, objectTypes);
+        level.generateGrid();
+        Grid same = level;
+        Grid other(10, 7, 10, objectTypes);
+        other.generateGrid();
+        volatile std::uint64_t sink = 0;
+        runBenchmark("sameBoard 10x10 different", 10000000, [&] { sink += level.sameBoard(other); });
+        runBenchmark("sameBoard 10x10 equal", 1000000, [&] { sink += level.sameBoard(same); });
+    }
+
+    // Exhaustive enumeration of the 6x6 Bumper and Tunnel level: the search
+    // alone, one searched entry's boards, and loading a board it finds
+    {
+        const std::vector<GridCellType> early = {GridCellType::Bumper, GridCellType::Tunnel};
+        const LevelEnumerator enumerator(6, 3, 4, early);
+        GridN<6> board(6, 3, 4, early);
+        std::vector<BoardObject> found;
+        CellIndex foundEntry = INVALID_CELL;
+        volatile std::uint64_t sink = 0;
+        runBenchmark("LevelEnumerator 6x6 3-4 objects, all jobs", 20, [&] {
+            for (const LevelEnumerator::Job& job : enumerator.jobs()) {
+                sink += enumerator.run(job, [&](CellIndex entry, const std::vector<BoardObject>& objects) {
+                    foundEntry = entry;
+                    found = objects;
+                });
+            }
+        });
+        runBenchmark("loadBoard 6x6", 1000000, [&] {
+            sink += board.loadBoard(foundEntry, found.data(), found.size());
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <dlfcn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Library load cost, measured as the time dlopen takes in a fresh child
+// process so every sample pays relocation and static initialization again.
+//
+// LegacyDirectionMaps holds the hash-map transition data the way every
+// translation unit that included DirectionMaps.h used to build it, and
+// ConstexprDirectionMaps the constant table that replaced it. The gap
+// between the two is the startup cost GridBridge paid per including file.
+
+static double sampleLoadMicroseconds(const char* path) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1.0;
+    }
+
+    pid_t child = fork();
+    if (child == 0) {
+        close(fds[0]);
+        auto start = std::chrono::steady_clock::now();
+        void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        double microseconds = handle ? std::chrono::duration<double, std::micro>(elapsed).count() : -1.0;
+        ssize_t written = write(fds[1], &microseconds, sizeof(microseconds));
+        _exit(written == sizeof(microseconds) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    double microseconds = -1.0;
+    if (read(fds[0], &microseconds, sizeof(microseconds)) != sizeof(microseconds)) {
+        microseconds = -1.0;
+    }
+    close(fds[0]);
+    waitpid(child, nullptr, 0);
+    return microseconds;
+}
+
+static void runLoadBenchmark(const char* name, const char* path, int samples) {
+    std::vector<double> times;
+    for (int i = 0; i < samples; i++) {
+        double microseconds = sampleLoadMicroseconds(path);
+        if (microseconds < 0) {
+            std::printf("%-24s failed to load %s\n", name, path);
+            return;
+        }
+        times.push_back(microseconds);
+    }
+    std::sort(times.begin(), times.end());
+    std::printf("%-24s %6d loads   median %8.1f us   min %8.1f us\n",
+                name, samples, times[times.size() / 2], times.front());
+}
+
+int main() {
+    const int samples = 200;
+    runLoadBenchmark("GridBridge", GRID_BRIDGE_LIBRARY, samples);
+    runLoadBenchmark("LegacyDirectionMaps", LEGACY_DIRECTION_MAPS_LIBRARY, samples);
+    runLoadBenchmark("ConstexprDirectionMaps", CONSTEXPR_DIRECTION_MAPS_LIBRARY, samples);
+    return 0;
+}
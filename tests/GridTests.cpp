@@ -1,11 +1,22 @@
 #define CATCH_CONFIG_MAIN
+#include <cstdio>
+#include <filesystem>
 #include <vector>
-#include <utility>
 #include <set>
+#include <random>
 #include "catch.hpp"
 #include "../Sources/GridBridge/GridCell.h"
 #include "../Sources/GridBridge/DirectionMaps.h"
 #include "../Sources/GridBridge/Grid.h"
+#include "../Sources/GridBridge/AllEntriesSolver.h"
+#include "../Sources/GridBridge/JumpSimulator.h"
+#include "../Sources/GridBridge/BatchSimulator.h"
+#include "../Sources/GridBridge/ScanKernels.h"
+#include "../Sources/GridBridge/GridDispatch.h"
+#include "../Sources/GridBridge/LevelEnumerator.h"
+#include "../Sources/GridBridge/LevelPack.h"
+#include "../Sources/GridBridge/Symmetry.h"
+#include "../Sources/GridBridge/include/GridBridge.h"
 
 TEST_CASE("Grid initialization", "[grid]") {
     std::vector<GridCellType> objectTypes = {
@@ -23,10 +34,12 @@ TEST_CASE("Entry position is valid", "[grid]") {
     std::vector<GridCellType> objectTypes = {GridCellType::Bumper};
     Grid grid(5, 2, 3, objectTypes);
     
-    Pos entryPos = grid.getEntryPosition();
+    CellIndex entryPos = grid.getEntryPosition();
+    int row = grid.rowOf(entryPos);
+    int col = grid.colOf(entryPos);
     bool isValidEntry = 
-        (entryPos.first == 0 || entryPos.first == 4 || 
-         entryPos.second == 0 || entryPos.second == 4);
+        (row == 0 || row == 4 || 
+         col == 0 || col == 4);
     
     REQUIRE(isValidEntry);
 }
@@ -76,7 +89,7 @@ TEST_CASE("DirectionalBumper direction changes", "[grid]") {
             GridCellType::DirectionalBumper,
             Direction::Up,
             Orientation::TopRight,
-            {2, 2}
+            grid.toIndex(2, 2)
         );
         REQUIRE(newDir == Direction::Left);
         
@@ -84,8 +97,1973 @@ TEST_CASE("DirectionalBumper direction changes", "[grid]") {
             GridCellType::DirectionalBumper,
             Direction::Right,
             Orientation::TopRight,
-            {2, 2}
+            grid.toIndex(2, 2)
         );
         REQUIRE(newDir == Direction::Down);
     }
-} 
\ No newline at end of file
+} 
+TEST_CASE("Simulated exit matches generated exit", "[grid]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    Grid grid(10, 6, 8, objectTypes);
+
+    for (int i = 0; i < 200; i++) {
+        grid.generateGrid();
+        REQUIRE(grid.simulate() == grid.exitPos);
+        REQUIRE(grid.gridCells[grid.exitPos].type == GridCellType::Exit);
+    }
+}
+
+TEST_CASE("Object count stays within bounds and decoys keep the exit", "[grid]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    Grid grid(10, 4, 20, objectTypes);
+
+    bool sawDecoy = false;
+    for (int i = 0; i < 200; i++) {
+        REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+
+        std::set<CellIndex> onPath;
+        for (const PathStep& step : grid.ballPath) {
+            onPath.insert(step.pos);
+            onPath.insert(step.landed);
+        }
+
+        int objects = 0;
+        for (CellIndex pos = 0; pos < grid.gridCells.size(); pos++) {
+            if (isObjectCell(grid.gridCells[pos].type)) {
+                objects++;
+                sawDecoy = sawDecoy || onPath.count(pos) == 0;
+            }
+        }
+        REQUIRE(objects >= grid.minObjects);
+        REQUIRE(objects <= grid.maxObjects);
+
+        CellIndex exitPos = grid.exitPos;
+        REQUIRE(grid.simulate() == exitPos);
+    }
+    REQUIRE(sawDecoy);
+
+    SECTION("maxObjects below minObjects is rejected") {
+        Grid invalid(10, 6, 4, objectTypes);
+        REQUIRE(invalid.generateGrid() == GRID_STATUS_INVALID_ARGUMENT);
+    }
+}
+
+TEST_CASE("Cell edits re-simulate to the same exit as a full walk", "[grid]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    const GridCellType editTypes[] = {
+        GridCellType::Empty,
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::ActivatedBumper
+    };
+    const Orientation editOrientations[] = {
+        Orientation::None,
+        Orientation::UpRight,
+        Orientation::TopLeft,
+        Orientation::Vertical,
+        Orientation::DownRight
+    };
+    Grid grid(10, 6, 12, objectTypes);
+
+    for (int i = 0; i < 50; i++) {
+        REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+        for (int edit = 0; edit < 20; edit++) {
+            int row = 1 + (i * 7 + edit * 3) % 8;
+            int col = 1 + (i * 5 + edit * 11) % 8;
+            int choice = (i + edit) % 5;
+            REQUIRE(grid.setCell(row, col, editTypes[choice], editOrientations[choice]) == GRID_STATUS_OK);
+            REQUIRE(grid.cellAt(row, col).orientation == editOrientations[choice]);
+
+            Grid fresh = grid;
+            REQUIRE(fresh.simulate() == grid.exitPos);
+            if (grid.exitPos != INVALID_CELL) {
+                REQUIRE(fresh.ballPath.size() == grid.ballPath.size());
+            }
+        }
+    }
+
+    SECTION("Re-walks leave the cells a full walk leaves") {
+        // A partial re-walk of a ball that left through its own entry once
+        // kept the entry typed Exit
+        const auto sameCells = [](const Grid& walked, const Grid& fresh) {
+            for (CellIndex pos = 0; pos < walked.gridCells.size(); pos++) {
+                REQUIRE(walked.gridCells[pos].type == fresh.gridCells[pos].type);
+                REQUIRE(walked.gridCells[pos].hasBeenActivated == fresh.gridCells[pos].hasBeenActivated);
+                REQUIRE(walked.gridCells[pos].firstVisit == fresh.gridCells[pos].firstVisit);
+            }
+        };
+        Grid weighted(10, 6, 12, objectTypes, {4.0, 1.0, 2.0, 1.0, 1.0});
+        for (std::uint32_t seed : {158u, 251u, 287u}) {
+            weighted.seed(seed);
+            REQUIRE(weighted.generateGrid() == GRID_STATUS_OK);
+            REQUIRE(weighted.setCell(4, 4, GridCellType::ActivatedBumper, Orientation::UpRight) == GRID_STATUS_OK);
+            Grid fresh = weighted;
+            fresh.simulate();
+            sameCells(weighted, fresh);
+        }
+
+        for (std::uint32_t seed = 0; seed < 300; seed++) {
+            weighted.seed(seed);
+            REQUIRE(weighted.generateGrid() == GRID_STATUS_OK);
+            for (int edit = 0; edit < 4; edit++) {
+                const int choice = static_cast<int>(seed + edit) % 5;
+                const int row = 1 + static_cast<int>(seed * 3 + edit * 5) % 8;
+                const int col = 1 + static_cast<int>(seed * 7 + edit) % 8;
+                REQUIRE(weighted.setCell(row, col, editTypes[choice], editOrientations[choice]) == GRID_STATUS_OK);
+                Grid fresh = weighted;
+                fresh.simulate();
+                sameCells(weighted, fresh);
+            }
+        }
+    }
+
+    SECTION("Invalid edits are rejected") {
+        REQUIRE(grid.setCell(0, 3, GridCellType::Bumper, Orientation::UpRight) == GRID_STATUS_OUT_OF_BOUNDS);
+        REQUIRE(grid.setCell(3, 9, GridCellType::Bumper, Orientation::UpRight) == GRID_STATUS_OUT_OF_BOUNDS);
+        REQUIRE(grid.setCell(3, 3, GridCellType::Teleporter, Orientation::None) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(grid.setCell(3, 3, GridCellType::Bumper, Orientation::Vertical) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(grid.setCell(3, 3, GridCellType::Exit, Orientation::None) == GRID_STATUS_INVALID_ARGUMENT);
+    }
+
+    SECTION("Edits through the bridge") {
+        int types[] = {static_cast<int>(GridCellType::Bumper)};
+        void* handle = Grid_Create(7, 2, 4, types, 1);
+        REQUIRE(Grid_GenerateGrid(handle) == GRID_STATUS_OK);
+        REQUIRE(Grid_SetCell(handle, 3, 3, static_cast<int>(GridCellType::Bumper),
+                             static_cast<int>(Orientation::UpRight)) == GRID_STATUS_OK);
+        REQUIRE(Grid_SetCell(handle, 3, 3, 42, 0) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(Grid_SetCell(nullptr, 3, 3, 0, 8) == GRID_STATUS_NULL_GRID);
+
+        int row = 0;
+        int col = 0;
+        REQUIRE(Grid_GetExit(handle, &row, &col) == GRID_STATUS_OK);
+        GridN<7>& engine = std::get<GridN<7>>(*static_cast<AnyGrid*>(handle));
+        REQUIRE(engine.toIndex(row, col) == engine.simulate());
+        Grid_Destroy(handle);
+    }
+}
+
+TEST_CASE("Walks specialized on the object types match the full walk", "[grid]") {
+    // The type sets Level.swift configures, each of which selects its own kernel
+    const std::vector<std::vector<GridCellType>> levelTypes = {
+        {GridCellType::Bumper},
+        {GridCellType::Bumper, GridCellType::Tunnel},
+        {GridCellType::Bumper, GridCellType::Tunnel, GridCellType::Teleporter},
+        {GridCellType::Bumper, GridCellType::Tunnel, GridCellType::Teleporter, GridCellType::ActivatedBumper},
+        {GridCellType::Bumper, GridCellType::Tunnel, GridCellType::Teleporter, GridCellType::ActivatedBumper,
+         GridCellType::DirectionalBumper},
+    };
+    JumpSimulator jumper;
+
+    for (const std::vector<GridCellType>& objectTypes : levelTypes) {
+        Grid grid(10, 6, 9, objectTypes);
+        for (int i = 0; i < 50; i++) {
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+            jumper.build(grid);
+            EntryExit expected = jumper.simulate(grid.entryPos);
+            REQUIRE(grid.simulate() == expected.exit);
+            REQUIRE(grid.ballPath.size() - 1 == expected.steps);
+        }
+    }
+
+    SECTION("setCell widens the walk to the type it places") {
+        Grid grid(10, 6, 9, levelTypes[0]);
+        for (int i = 0; i < 50; i++) {
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+            const PathStep& crossed = grid.ballPath[grid.ballPath.size() / 2];
+            if (grid.gridCells[crossed.pos].type != GridCellType::InBallPath) {
+                continue;
+            }
+            REQUIRE(grid.setCell(grid.rowOf(crossed.pos), grid.colOf(crossed.pos), GridCellType::ActivatedBumper,
+                                 Orientation::UpRight) == GRID_STATUS_OK);
+            jumper.build(grid);
+            REQUIRE(jumper.simulate(grid.entryPos).exit == grid.exitPos);
+        }
+    }
+}
+
+TEST_CASE("All-entries solver matches simulating each entry", "[grid][solver]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    AllEntriesSolver solver;
+
+    for (int size : {5, 10}) {
+        Grid grid(size, size - 3, 2 * size, objectTypes);
+        for (int i = 0; i < 100; i++) {
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+            const std::vector<EntryExit>& results = solver.solve(grid);
+            REQUIRE(results.size() == static_cast<std::size_t>(4 * (size - 2)));
+
+            Grid walker = grid;
+            for (const EntryExit& result : results) {
+                walker.entryPos = result.entry;
+                REQUIRE(walker.simulate() == result.exit);
+                if (result.exit != INVALID_CELL) {
+                    REQUIRE(walker.ballPath.size() - 1 == result.steps);
+                }
+            }
+        }
+    }
+    SECTION("Sparse and fixed-size engines") {
+        Grid dense(10, 7, 20, objectTypes);
+        SparseGrid sparse(10, 7, 20, objectTypes);
+        GridN<10> fixed(10, 7, 20, objectTypes);
+        for (std::uint32_t seed = 0; seed < 50; seed++) {
+            dense.seed(seed);
+            sparse.seed(seed);
+            fixed.seed(seed);
+            REQUIRE(dense.generateGrid() == GRID_STATUS_OK);
+            REQUIRE(sparse.generateGrid() == GRID_STATUS_OK);
+            REQUIRE(fixed.generateGrid() == GRID_STATUS_OK);
+            const std::vector<EntryExit> expected = solver.solve(dense);
+            const std::vector<EntryExit> fromSparse = solver.solve(sparse);
+            const std::vector<EntryExit> fromFixed = solver.solve(fixed);
+            REQUIRE(fromSparse.size() == expected.size());
+            REQUIRE(fromFixed.size() == expected.size());
+            for (std::size_t i = 0; i < expected.size(); i++) {
+                REQUIRE(fromSparse[i].exit == expected[i].exit);
+                REQUIRE(fromSparse[i].steps == expected[i].steps);
+                REQUIRE(fromFixed[i].exit == expected[i].exit);
+                REQUIRE(fromFixed[i].steps == expected[i].steps);
+            }
+        }
+    }
+}
+
+TEST_CASE("Jump simulation matches the cell-stepping walk", "[grid][jump]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    AllEntriesSolver solver;
+    JumpSimulator jumper;
+
+    for (int size : {5, 10, 16}) {
+        Grid grid(size, size - 3, 2 * size, objectTypes);
+        for (int i = 0; i < 100; i++) {
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+            jumper.build(grid);
+
+            for (const EntryExit& expected : solver.solve(grid)) {
+                EntryExit jumped = jumper.simulate(expected.entry);
+                REQUIRE(jumped.exit == expected.exit);
+                REQUIRE(jumped.steps == expected.steps);
+            }
+        }
+    }
+    SECTION("Sparse and fixed-size engines") {
+        Grid dense(10, 7, 20, objectTypes);
+        SparseGrid sparse(10, 7, 20, objectTypes);
+        GridN<10> fixed(10, 7, 20, objectTypes);
+        const auto requireJumps = [&](const auto& engine, const std::vector<EntryExit>& expected) {
+            jumper.build(engine);
+            for (const EntryExit& entry : expected) {
+                EntryExit jumped = jumper.simulate(entry.entry);
+                REQUIRE(jumped.exit == entry.exit);
+                REQUIRE(jumped.steps == entry.steps);
+            }
+        };
+        for (std::uint32_t seed = 0; seed < 50; seed++) {
+            dense.seed(seed);
+            sparse.seed(seed);
+            fixed.seed(seed);
+            REQUIRE(dense.generateGrid() == GRID_STATUS_OK);
+            REQUIRE(sparse.generateGrid() == GRID_STATUS_OK);
+            REQUIRE(fixed.generateGrid() == GRID_STATUS_OK);
+            const std::vector<EntryExit> expected = solver.solve(dense);
+            requireJumps(sparse, expected);
+            requireJumps(fixed, expected);
+        }
+
+        // Positions past INT_MAX, indexed from the stored cells alone
+        SparseGrid large(MAX_GRID_SIZE, 20, 40, objectTypes);
+        large.seed(5);
+        REQUIRE(large.generateGrid() == GRID_STATUS_OK);
+        jumper.build(large);
+        REQUIRE(jumper.objectCount() >= 20);
+        const EntryExit jumped = jumper.simulate(large.entryPos);
+        REQUIRE(jumped.exit == large.exitPos);
+        REQUIRE(jumped.steps == large.ballPath.size() - 1);
+    }
+}
+
+TEST_CASE("Large grids generate and simulate", "[grid][large]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    Grid grid(300, 30, 300, objectTypes);
+    JumpSimulator jumper;
+
+    for (int i = 0; i < 5; i++) {
+        REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+
+        int objects = 0;
+        for (const GridCell& cell : grid.gridCells) {
+            objects += isObjectCell(cell.type) ? 1 : 0;
+        }
+        REQUIRE(objects >= grid.minObjects);
+        REQUIRE(objects <= grid.maxObjects);
+
+        CellIndex exitPos = grid.exitPos;
+        jumper.build(grid);
+        REQUIRE(jumper.simulate(grid.entryPos).exit == exitPos);
+        REQUIRE(grid.simulate() == exitPos);
+    }
+
+    Grid tooLarge(3, 0, 0, objectTypes);
+    tooLarge.gridSize = MAX_GRID_SIZE + 1;
+    REQUIRE(tooLarge.generateGrid() == GRID_STATUS_INVALID_ARGUMENT);
+
+    // Past what dense storage may allocate, a grid holds no cells and
+    // refuses to generate rather than asking for gigabytes
+    Grid tooDense(MAX_GRID_SIZE, 1, 2, objectTypes);
+    REQUIRE(tooDense.gridCells.size() == 0);
+    REQUIRE(tooDense.generateGrid() == GRID_STATUS_INVALID_ARGUMENT);
+    REQUIRE(tooDense.loadBoard(1, nullptr, 0) == GRID_STATUS_INVALID_ARGUMENT);
+}
+
+TEST_CASE("Sparse cell storage reads like dense storage", "[storage]") {
+    DenseCells dense;
+    SparseCells sparse;
+    dense.reset(40);
+    sparse.reset(40);
+    REQUIRE(sparse.size() == dense.size());
+    REQUIRE(sparse.storedCells() == 0);
+
+    std::mt19937 rng(7);
+    for (int i = 0; i < 20000; i++) {
+        CellIndex pos = rng() % dense.size();
+        switch (rng() % 3) {
+            case 0:
+                dense.edit(pos).type = GridCellType::Bumper;
+                sparse.edit(pos).type = GridCellType::Bumper;
+                break;
+            case 1:
+                dense.edit(pos).firstVisit = i;
+                sparse.edit(pos).firstVisit = i;
+                break;
+            default:
+                dense.erase(pos);
+                sparse.erase(pos);
+                break;
+        }
+    }
+
+    for (CellIndex pos = 0; pos < dense.size(); pos++) {
+        REQUIRE(sparse[pos].type == dense[pos].type);
+        REQUIRE(sparse[pos].firstVisit == dense[pos].firstVisit);
+    }
+}
+
+TEST_CASE("Batch simulation matches simulating each grid", "[grid][batch]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    BatchSimulator batch;
+
+    for (int size : {5, 10}) {
+        // Not a multiple of the lane count, so the last group is partly empty
+        std::vector<Grid> grids(60, Grid(size, size - 3, 2 * size, objectTypes));
+        std::mt19937 edits(size);
+        const Orientation corners[] = {Orientation::TopLeft, Orientation::TopRight,
+                                       Orientation::BottomLeft, Orientation::BottomRight};
+        for (Grid& grid : grids) {
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+            for (int edit = 0; edit < 4 && grid.exitPos != INVALID_CELL; edit++) {
+                CellIndex pos = grid.ballPath[1 + edits() % (grid.ballPath.size() - 2)].pos;
+                if (grid.gridCells[pos].type == GridCellType::InBallPath) {
+                    bool directional = edit != 3;
+                    grid.setCell(grid.rowOf(pos), grid.colOf(pos),
+                                 directional ? GridCellType::DirectionalBumper : GridCellType::ActivatedBumper,
+                                 directional ? corners[edits() % 4] : Orientation::UpRight);
+                }
+            }
+        }
+
+        // Four DirectionalBumpers the ball circles forever
+        Grid trap(size, 0, 0, objectTypes);
+        trap.entryPos = trap.toIndex(0, 1);
+        trap.setCell(1, 1, GridCellType::DirectionalBumper, Orientation::TopLeft);
+        trap.setCell(1, 3, GridCellType::DirectionalBumper, Orientation::TopRight);
+        trap.setCell(3, 3, GridCellType::DirectionalBumper, Orientation::BottomRight);
+        trap.setCell(3, 1, GridCellType::DirectionalBumper, Orientation::BottomLeft);
+        REQUIRE(trap.simulate() == INVALID_CELL);
+        grids.push_back(trap);
+
+        std::vector<const Grid*> boards;
+        for (const Grid& grid : grids) {
+            boards.push_back(&grid);
+        }
+        REQUIRE(batch.build(boards) == GRID_STATUS_OK);
+        REQUIRE(batch.boardCount() == 61);
+
+        for (int pass = 0; pass < 2; pass++) {
+            const std::vector<EntryExit>& results = pass == 0 ? batch.simulate() : batch.simulateScalar();
+            for (std::size_t i = 0; i < grids.size(); i++) {
+                REQUIRE(results[i].entry == grids[i].entryPos);
+                REQUIRE(results[i].exit == grids[i].simulate());
+                if (results[i].exit != INVALID_CELL) {
+                    REQUIRE(results[i].steps == grids[i].ballPath.size() - 1);
+                }
+            }
+        }
+    }
+
+    SECTION("Boards of different sides are rejected") {
+        Grid small(5, 2, 5, objectTypes);
+        Grid large(6, 2, 5, objectTypes);
+        REQUIRE(batch.build({&small, &large}) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(batch.build({}) == GRID_STATUS_INVALID_ARGUMENT);
+    }
+}
+
+TEST_CASE("Vector scan kernels match the scalar references", "[grid][scan]") {
+    // A 200x200 block of cells, a fifth of them not passable and a fifth on
+    // the ball path
+    const int side = 200;
+    std::vector<GridCell> cells(side * side);
+    std::mt19937 fill(40);
+    const GridCellType types[] = {GridCellType::Empty, GridCellType::Empty, GridCellType::Empty,
+                                  GridCellType::InBallPath, GridCellType::Bumper};
+    for (GridCell& cell : cells) {
+        cell.type = types[fill() % 5];
+        cell.orientation = static_cast<Orientation>(fill() % 9);
+    }
+
+    std::uint64_t scalarMask[4];
+    std::uint64_t vectorMask[4];
+    for (int i = 0; i < 2000; i++) {
+        const int row = static_cast<int>(fill() % side);
+        const int col = static_cast<int>(fill() % side);
+        const int direction = static_cast<int>(fill() % 4);
+        const std::ptrdiff_t strides[] = {-side, side, -1, 1};
+        const int room[] = {row + 1, side - row, col + 1, side - col};
+        const std::uint32_t count = static_cast<std::uint32_t>(fill() % room[direction]);
+        const ScanKernels::Ray ray{cells.data() + row * side + col, strides[direction], count};
+
+        REQUIRE(ScanKernels::firstObstacleVector(ray) == ScanKernels::firstObstacleScalar(ray));
+        ScanKernels::openMaskScalar(ray, scalarMask);
+        ScanKernels::openMaskVector(ray, vectorMask);
+        for (std::uint32_t word = 0; word < (count + 63) / 64; word++) {
+            REQUIRE(vectorMask[word] == scalarMask[word]);
+        }
+    }
+
+    SECTION("Obstacles are found past a clear prefix") {
+        std::vector<GridCell> clear(100);
+        clear[77].type = GridCellType::Teleporter;
+        REQUIRE(ScanKernels::firstObstacleVector({clear.data(), 1, 100}) == 77);
+        REQUIRE(ScanKernels::firstObstacleVector({clear.data(), 1, 77}) == 77);
+    }
+}
+
+// Same board, walk and configuration; path marks included
+template <typename A, typename B>
+static void requireSameGrid(const A& a, const B& b) {
+    REQUIRE(a.gridSize == b.gridSize);
+    REQUIRE(a.minObjects == b.minObjects);
+    REQUIRE(a.maxObjects == b.maxObjects);
+    REQUIRE(a.objectTypes == b.objectTypes);
+    REQUIRE(a.objectWeights == b.objectWeights);
+    REQUIRE(a.entryPos == b.entryPos);
+    REQUIRE(a.exitPos == b.exitPos);
+    REQUIRE(a.ballPath.size() == b.ballPath.size());
+    for (CellIndex pos = 0; pos < a.gridCells.size(); pos++) {
+        REQUIRE(a.gridCells[pos].type == b.gridCells[pos].type);
+        if (isObjectCell(a.gridCells[pos].type)) {
+            REQUIRE(a.gridCells[pos].orientation == b.gridCells[pos].orientation);
+            REQUIRE(a.gridCells[pos].teleporterIndex == b.gridCells[pos].teleporterIndex);
+        }
+    }
+}
+
+TEST_CASE("Grids round-trip through the binary format", "[grid][format]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    std::vector<std::uint8_t> bytes(4096);
+    std::size_t written = 0;
+
+    Grid grid(10, 6, 12, objectTypes, {4, 1, 2, 1, 1});
+    grid.seed(41);
+    Grid loaded(5, 1, 1, {GridCellType::Bumper});
+    for (int i = 0; i < 100; i++) {
+        REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+        REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+        REQUIRE(written == grid.serializedSize());
+        // 32 bytes of cells and 40 of weights
+        REQUIRE(written < 100);
+        REQUIRE(loaded.deserialize(bytes.data(), written) == GRID_STATUS_OK);
+        requireSameGrid(grid, loaded);
+    }
+
+    SECTION("Level boards take a few dozen bytes") {
+        // Under half the ASCII rendering, which also drops teleporter links
+        Grid level(10, 7, 9, objectTypes);
+        REQUIRE(level.generateGrid() == GRID_STATUS_OK);
+        REQUIRE(level.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+        REQUIRE(written < 56);
+        REQUIRE(written < level.toASCII().size() / 2);
+    }
+
+    SECTION("Fixed-size engines and edited boards") {
+        GridN<10> fixed(10, 1, 1, {GridCellType::Bumper});
+        REQUIRE(grid.setCell(4, 4, GridCellType::ActivatedBumper, Orientation::UpRight) == GRID_STATUS_OK);
+        REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+        REQUIRE(fixed.deserialize(bytes.data(), written) == GRID_STATUS_OK);
+        requireSameGrid(grid, fixed);
+
+        GridN<7> wrongSide(7, 1, 1, {GridCellType::Bumper});
+        REQUIRE(wrongSide.deserialize(bytes.data(), written) == GRID_STATUS_INVALID_ARGUMENT);
+    }
+
+    SECTION("Large sparse boards store an object list") {
+        SparseGrid large(1000, 20, 40, objectTypes);
+        REQUIRE(large.generateGrid() == GRID_STATUS_OK);
+        REQUIRE(large.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+        REQUIRE(written < 300);
+        SparseGrid copy(3, 0, 0, {GridCellType::Bumper});
+        REQUIRE(copy.deserialize(bytes.data(), written) == GRID_STATUS_OK);
+        requireSameGrid(large, copy);
+    }
+
+    SECTION("Short buffers and boards without an entry are reported") {
+        REQUIRE(grid.serialize(bytes.data(), 10, written) == GRID_STATUS_BUFFER_TOO_SMALL);
+        REQUIRE(written == grid.serializedSize());
+        Grid fresh(10, 6, 12, objectTypes);
+        REQUIRE(fresh.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_INVALID_ARGUMENT);
+    }
+
+    SECTION("Truncated and corrupted data is rejected") {
+        REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+        for (std::size_t size = 0; size < written; size++) {
+            REQUIRE(loaded.deserialize(bytes.data(), size) == GRID_STATUS_BAD_FORMAT);
+        }
+        std::vector<std::uint8_t> longer(bytes.begin(), bytes.begin() + written + 1);
+        REQUIRE(loaded.deserialize(longer.data(), longer.size()) == GRID_STATUS_BAD_FORMAT);
+
+        // Any single flipped bit either fails cleanly or still decodes to a
+        // board whose walk matches its stored exit
+        for (std::size_t bit = 0; bit < written * 8; bit++) {
+            std::vector<std::uint8_t> corrupt(bytes.begin(), bytes.begin() + written);
+            corrupt[bit / 8] ^= static_cast<std::uint8_t>(1u << (bit % 8));
+            GridStatus status = loaded.deserialize(corrupt.data(), corrupt.size());
+            REQUIRE((status == GRID_STATUS_OK || status == GRID_STATUS_BAD_FORMAT));
+        }
+        bytes[0] = 'X';
+        REQUIRE(loaded.deserialize(bytes.data(), written) == GRID_STATUS_BAD_FORMAT);
+    }
+
+    SECTION("Teleporter symbols outside the nine are rejected") {
+        while (grid.teleporterPairs.empty()) {
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+        }
+        // The last byte is the last pair's symbol
+        REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+        REQUIRE(bytes[written - 1] == grid.teleporterPairs.back().index);
+        for (std::uint8_t symbol : {std::uint8_t{9}, std::uint8_t{200}, std::uint8_t{255}}) {
+            bytes[written - 1] = symbol;
+            REQUIRE(loaded.deserialize(bytes.data(), written) == GRID_STATUS_BAD_FORMAT);
+        }
+        grid.teleporterPairs.back().index = 9;
+        REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_INVALID_ARGUMENT);
+    }
+
+    SECTION("A rejected configuration leaves the grid as it was") {
+        // Byte 9 is the type count, then the types and their weights
+        REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+        REQUIRE(bytes[9] == objectTypes.size());
+        Grid bumpers(7, 2, 4, {GridCellType::Bumper});
+        bumpers.seed(3);
+        REQUIRE(bumpers.generateGrid() == GRID_STATUS_OK);
+        const Grid before = bumpers;
+        for (std::uint8_t badType : {std::uint8_t{0}, std::uint8_t{2}, std::uint8_t{9}, std::uint8_t{36}}) {
+            std::vector<std::uint8_t> corrupt(bytes.begin(), bytes.begin() + written);
+            corrupt[11] = badType;
+            REQUIRE(bumpers.deserialize(corrupt.data(), corrupt.size()) == GRID_STATUS_BAD_FORMAT);
+            requireSameGrid(before, bumpers);
+        }
+        // All-zero weights fail after the types decode
+        std::vector<std::uint8_t> zeroWeights(bytes.begin(), bytes.begin() + written);
+        const auto weightsAt = zeroWeights.begin() + 10 + static_cast<std::ptrdiff_t>(objectTypes.size());
+        std::fill(weightsAt, weightsAt + 8 * static_cast<std::ptrdiff_t>(objectTypes.size()), 0);
+        REQUIRE(bumpers.deserialize(zeroWeights.data(), zeroWeights.size()) == GRID_STATUS_BAD_FORMAT);
+        requireSameGrid(before, bumpers);
+
+        for (int i = 0; i < 50; i++) {
+            REQUIRE(bumpers.generateGrid() == GRID_STATUS_OK);
+            for (const GridCell& cell : bumpers.gridCells) {
+                REQUIRE((!isObjectCell(cell.type) || cell.type == GridCellType::Bumper));
+            }
+        }
+    }
+
+    SECTION("Through the bridge") {
+        int types[] = {static_cast<int>(GridCellType::Bumper), static_cast<int>(GridCellType::Teleporter)};
+        void* source = Grid_Create(10, 4, 8, types, 2);
+        void* target = Grid_Create(7, 2, 4, types, 1);
+        REQUIRE(Grid_GenerateGrid(source) == GRID_STATUS_OK);
+
+        int size = 0;
+        REQUIRE(Grid_Serialize(source, nullptr, 0, &size) == GRID_STATUS_BUFFER_TOO_SMALL);
+        std::vector<unsigned char> saved(size);
+        REQUIRE(Grid_Serialize(source, saved.data(), size, &size) == GRID_STATUS_OK);
+        REQUIRE(Grid_Deserialize(target, saved.data(), size) == GRID_STATUS_OK);
+        REQUIRE(std::holds_alternative<GridN<10>>(*static_cast<AnyGrid*>(target)));
+        requireSameGrid(std::get<GridN<10>>(*static_cast<AnyGrid*>(source)),
+                        std::get<GridN<10>>(*static_cast<AnyGrid*>(target)));
+        REQUIRE(Grid_Deserialize(target, saved.data(), 3) == GRID_STATUS_BAD_FORMAT);
+        Grid_Destroy(source);
+        Grid_Destroy(target);
+    }
+
+    SECTION("A damaged board of another side leaves the handle as configured") {
+        int types[] = {static_cast<int>(GridCellType::Bumper), static_cast<int>(GridCellType::Teleporter)};
+        void* source = Grid_Create(10, 4, 8, types, 2);
+        void* target = Grid_Create(7, 2, 4, types, 1);
+        REQUIRE(Grid_GenerateGrid(source) == GRID_STATUS_OK);
+        REQUIRE(Grid_GenerateGrid(target) == GRID_STATUS_OK);
+        const GridN<7> before = std::get<GridN<7>>(*static_cast<AnyGrid*>(target));
+
+        int size = 0;
+        REQUIRE(Grid_Serialize(source, nullptr, 0, &size) == GRID_STATUS_BUFFER_TOO_SMALL);
+        std::vector<unsigned char> saved(size);
+        REQUIRE(Grid_Serialize(source, saved.data(), size, &size) == GRID_STATUS_OK);
+        std::vector<unsigned char> badType = saved;
+        badType[11] = static_cast<unsigned char>(GridCellType::Border);
+
+        // A truncated payload and a bad type byte; the header reads as side 10
+        REQUIRE(Grid_Deserialize(target, saved.data(), size - 1) == GRID_STATUS_BAD_FORMAT);
+        REQUIRE(Grid_Deserialize(target, badType.data(), size) == GRID_STATUS_BAD_FORMAT);
+        REQUIRE(std::holds_alternative<GridN<7>>(*static_cast<AnyGrid*>(target)));
+        GridN<7>& kept = std::get<GridN<7>>(*static_cast<AnyGrid*>(target));
+        requireSameGrid(before, kept);
+        REQUIRE(kept.minObjects == 2);
+        REQUIRE(kept.maxObjects == 4);
+        REQUIRE(kept.objectTypes == std::vector<GridCellType>{GridCellType::Bumper});
+
+        for (int i = 0; i < 20; i++) {
+            REQUIRE(Grid_GenerateGrid(target) == GRID_STATUS_OK);
+            int objects = 0;
+            for (int row = 1; row < 6; row++) {
+                for (int col = 1; col < 6; col++) {
+                    const GridCellType type = kept.cellAt(row, col).type;
+                    REQUIRE((type == GridCellType::Empty || type == GridCellType::Bumper
+                             || type == GridCellType::InBallPath));
+                    objects += type == GridCellType::Bumper ? 1 : 0;
+                }
+            }
+            REQUIRE(objects >= 2);
+            REQUIRE(objects <= 4);
+        }
+        Grid_Destroy(source);
+        Grid_Destroy(target);
+    }
+}
+
+// Whether a pack level reads the same as the grid it was written from
+template <typename Engine>
+static void requirePackLevelMatches(const PackLevel& level, const Engine& grid) {
+    REQUIRE(level.side() == grid.gridSize);
+    REQUIRE(level.entry() == grid.entryPos);
+    REQUIRE(level.exit() == grid.exitPos);
+    for (int row = 0; row < grid.gridSize; row++) {
+        for (int col = 0; col < grid.gridSize; col++) {
+            const GridCell& cell = grid.cellAt(row, col);
+            const GridCellType type = cell.type == GridCellType::Border ? GridCellType::Empty : cell.type;
+            REQUIRE(level.type(row, col) == type);
+            REQUIRE(level.orientation(row, col) == cell.orientation);
+            REQUIRE(level.teleporterIndex(row, col) == cell.teleporterIndex);
+        }
+    }
+}
+
+TEST_CASE("Level packs are read in place by config and difficulty", "[pack]") {
+    const std::string path = (std::filesystem::temp_directory_path() / "GridTests.pack").string();
+    std::vector<GridCellType> levelTypes = {GridCellType::Bumper, GridCellType::Tunnel, GridCellType::Teleporter};
+
+    // Two configs; the 10x10 one has an empty bucket between two full ones
+    LevelPackWriter writer;
+    std::vector<Grid> small;
+    std::vector<Grid> large[3];
+    for (int i = 0; i < 20; i++) {
+        Grid grid(6, 3, 4, {GridCellType::Bumper});
+        REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+        REQUIRE(writer.add(grid, 0) == GRID_STATUS_OK);
+        small.push_back(grid);
+    }
+    for (int i = 0; i < 30; i++) {
+        GridN<10> grid(10, 6, 7, levelTypes);
+        REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+        const std::uint32_t bucket = i % 2 == 0 ? 0 : 2;
+        REQUIRE(writer.add(grid, bucket) == GRID_STATUS_OK);
+        Grid copy(10, 6, 7, levelTypes);
+        std::vector<std::uint8_t> bytes(grid.serializedSize());
+        std::size_t written = 0;
+        REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+        REQUIRE(copy.deserialize(bytes.data(), written) == GRID_STATUS_OK);
+        large[bucket].push_back(copy);
+    }
+    REQUIRE(writer.levelCount() == 50);
+    REQUIRE(writer.write(path.c_str()) == GRID_STATUS_OK);
+
+    SECTION("Levels come back by config, bucket and index") {
+        LevelPack pack;
+        REQUIRE(pack.open(path.c_str()) == GRID_STATUS_OK);
+        REQUIRE(pack.configCount() == 2);
+        const int smallConfig = pack.findConfig(6, 3, 4, {GridCellType::Bumper});
+        // Object types match in any order
+        const int largeConfig = pack.findConfig(10, 6, 7, {GridCellType::Teleporter, GridCellType::Bumper,
+                                                           GridCellType::Tunnel});
+        REQUIRE(smallConfig >= 0);
+        REQUIRE(largeConfig >= 0);
+        REQUIRE(pack.findConfig(10, 6, 8, levelTypes) == -1);
+        REQUIRE(pack.findConfig(10, 6, 7, {GridCellType::Bumper}) == -1);
+
+        REQUIRE(pack.bucketCount(smallConfig) == 1);
+        REQUIRE(pack.bucketCount(largeConfig) == 3);
+        REQUIRE(pack.levelCount(largeConfig, 0) == 15);
+        REQUIRE(pack.levelCount(largeConfig, 1) == 0);
+        REQUIRE(pack.levelCount(largeConfig, 2) == 15);
+        REQUIRE(pack.level(largeConfig, 1, 0) == nullptr);
+        REQUIRE(pack.level(largeConfig, 3, 0) == nullptr);
+        REQUIRE(pack.level(2, 0, 0) == nullptr);
+
+        // random picks level random % count, in the order added
+        for (std::uint64_t random = 0; random < 40; random++) {
+            requirePackLevelMatches(PackLevel(pack.level(smallConfig, 0, random)), small[random % 20]);
+            requirePackLevelMatches(PackLevel(pack.level(largeConfig, 0, random)), large[0][random % 15]);
+            requirePackLevelMatches(PackLevel(pack.level(largeConfig, 2, random)), large[2][random % 15]);
+        }
+        REQUIRE(PackLevel(pack.level(largeConfig, 2, 3)).objectCount() >= 6);
+    }
+
+    SECTION("Records copy into another pack unchanged") {
+        LevelPack pack;
+        REQUIRE(pack.open(path.c_str()) == GRID_STATUS_OK);
+        LevelPackWriter copy;
+        for (int config = 0; config < pack.configCount(); config++) {
+            for (int bucket = 0; bucket < pack.bucketCount(config); bucket++) {
+                for (std::uint64_t level = 0; level < pack.levelCount(config, bucket); level++) {
+                    const auto* record = reinterpret_cast<const std::uint8_t*>(pack.level(config, bucket, level));
+                    REQUIRE(copy.addRecord(pack.config(config), static_cast<std::uint32_t>(bucket), record)
+                            == GRID_STATUS_OK);
+                }
+            }
+        }
+        const std::string copyPath = path + ".copy";
+        REQUIRE(copy.write(copyPath.c_str()) == GRID_STATUS_OK);
+        const auto readAll = [](const std::string& file) {
+            std::vector<char> bytes;
+            std::FILE* in = std::fopen(file.c_str(), "rb");
+            for (int c; in && (c = std::fgetc(in)) != EOF;) {
+                bytes.push_back(static_cast<char>(c));
+            }
+            if (in) {
+                std::fclose(in);
+            }
+            return bytes;
+        };
+        REQUIRE(readAll(copyPath) == readAll(path));
+        std::remove(copyPath.c_str());
+    }
+
+    SECTION("Grids that cannot be stored are rejected") {
+        Grid unwalked(6, 3, 4, {GridCellType::Bumper});
+        REQUIRE(writer.add(unwalked, 0) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(writer.add(small[0], LevelPackFormat::MAX_BUCKETS) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(writer.levelCount() == 50);
+    }
+
+    SECTION("Sides whose records outgrow 32 bits are rejected") {
+        using LevelPackFormat::MAX_RECORD_SIDE;
+        REQUIRE(LevelPackFormat::recordSize(std::size_t{MAX_RECORD_SIDE}) <= UINT32_MAX);
+        REQUIRE(LevelPackFormat::recordSize(std::size_t{MAX_RECORD_SIDE} + 1) > UINT32_MAX);
+
+        LevelPackFormat::Config large = {};
+        large.side = MAX_RECORD_SIDE + 1;
+        large.minObjects = 1;
+        large.maxObjects = 1;
+        large.objectTypeMask = cellTypeBit(GridCellType::Bumper);
+        const std::uint8_t record[8] = {};
+        LevelPackWriter limits;
+        REQUIRE(limits.addRecord(large, 0, record) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(limits.levelCount() == 0);
+        // Seeds are the same size at any side
+        REQUIRE(limits.addSeed(large, 0, 7) == GRID_STATUS_OK);
+        REQUIRE(limits.write(path.c_str()) == GRID_STATUS_OK);
+
+        std::vector<char> file;
+        std::FILE* in = std::fopen(path.c_str(), "rb");
+        REQUIRE(in != nullptr);
+        for (int c; (c = std::fgetc(in)) != EOF;) {
+            file.push_back(static_cast<char>(c));
+        }
+        std::fclose(in);
+        LevelPack pack;
+        REQUIRE(pack.open(path.c_str()) == GRID_STATUS_OK);
+        pack.close();
+
+        // The same config as records, with the size it would truncate to
+        LevelPackFormat::Config damaged;
+        std::memcpy(&damaged, file.data() + sizeof(LevelPackFormat::Header), sizeof(damaged));
+        damaged.flags = 0;
+        damaged.recordSize = static_cast<std::uint32_t>(LevelPackFormat::recordSize(std::size_t{large.side}));
+        std::memcpy(file.data() + sizeof(LevelPackFormat::Header), &damaged, sizeof(damaged));
+        std::FILE* out = std::fopen(path.c_str(), "wb");
+        std::fwrite(file.data(), 1, file.size(), out);
+        std::fclose(out);
+        REQUIRE(pack.open(path.c_str()) == GRID_STATUS_BAD_FORMAT);
+    }
+
+    SECTION("Damaged or missing files are not opened") {
+        std::vector<char> file;
+        std::FILE* in = std::fopen(path.c_str(), "rb");
+        REQUIRE(in != nullptr);
+        for (int c; (c = std::fgetc(in)) != EOF;) {
+            file.push_back(static_cast<char>(c));
+        }
+        std::fclose(in);
+
+        const auto openWith = [&](const std::vector<char>& bytes) {
+            std::FILE* out = std::fopen(path.c_str(), "wb");
+            std::fwrite(bytes.data(), 1, bytes.size(), out);
+            std::fclose(out);
+            LevelPack pack;
+            return pack.open(path.c_str());
+        };
+        REQUIRE(openWith(file) == GRID_STATUS_OK);
+        // Cut off the last record
+        REQUIRE(openWith(std::vector<char>(file.begin(), file.end() - 8)) == GRID_STATUS_BAD_FORMAT);
+        REQUIRE(openWith(std::vector<char>(file.begin(), file.begin() + 10)) == GRID_STATUS_BAD_FORMAT);
+        std::vector<char> damaged = file;
+        damaged[0] = 'X';
+        REQUIRE(openWith(damaged) == GRID_STATUS_BAD_FORMAT);
+        // A bucket running past its config's levels
+        damaged = file;
+        damaged[sizeof(LevelPackFormat::Header) + 2 * sizeof(LevelPackFormat::Config) + 8] = 100;
+        REQUIRE(openWith(damaged) == GRID_STATUS_BAD_FORMAT);
+
+        std::remove(path.c_str());
+        LevelPack pack;
+        REQUIRE(pack.open(path.c_str()) == GRID_STATUS_IO_ERROR);
+        REQUIRE(pack.level(0, 0, 0) == nullptr);
+    }
+
+    SECTION("Through the bridge") {
+        int types[] = {static_cast<int>(GridCellType::Tunnel), static_cast<int>(GridCellType::Bumper),
+                       static_cast<int>(GridCellType::Teleporter)};
+        void* pack = LevelPack_Open(path.c_str());
+        REQUIRE(pack != nullptr);
+        const int config = LevelPack_FindConfig(pack, 10, 6, 7, types, 3);
+        REQUIRE(config >= 0);
+        const int unknown[] = {static_cast<int>(GridCellType::Tunnel), 36};
+        REQUIRE(LevelPack_FindConfig(pack, 10, 6, 7, unknown, 2) == -1);
+        REQUIRE(LevelPack_GetBucketCount(pack, config) == 3);
+        REQUIRE(LevelPack_GetLevelCount(pack, config, 2) == 15);
+        REQUIRE(LevelPack_GetLevel(pack, config, 1, 7) == nullptr);
+
+        const void* level = LevelPack_GetLevel(pack, config, 2, 22);
+        const Grid& source = large[2][22 % 15];
+        REQUIRE(PackLevel_GetSize(level) == 10);
+        for (int row = 0; row < 10; row++) {
+            for (int col = 0; col < 10; col++) {
+                const GridCell& cell = source.cellAt(row, col);
+                const GridCellType type = cell.type == GridCellType::Border ? GridCellType::Empty : cell.type;
+                REQUIRE(PackLevel_GetCellType(level, row, col) == static_cast<int>(type));
+                REQUIRE(PackLevel_GetCellOrientation(level, row, col) == static_cast<int>(cell.orientation));
+                REQUIRE(PackLevel_GetTeleporterIndex(level, row, col) == cell.teleporterIndex);
+            }
+        }
+        REQUIRE(PackLevel_GetCellType(level, 10, 0) == 0);
+        int row = 0;
+        int col = 0;
+        REQUIRE(PackLevel_GetExit(level, &row, &col) == GRID_STATUS_OK);
+        REQUIRE(row == source.rowOf(source.exitPos));
+        REQUIRE(col == source.colOf(source.exitPos));
+        LevelPack_Close(pack);
+        REQUIRE(LevelPack_Open("/nonexistent/GridTests.pack") == nullptr);
+    }
+    std::remove(path.c_str());
+}
+
+// FNV-1a of a grid's binary form
+template <typename Engine>
+static std::uint64_t serializedHash(const Engine& grid) {
+    std::vector<std::uint8_t> bytes(grid.serializedSize());
+    std::size_t written = 0;
+    REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+    for (std::size_t i = 0; i < written; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+TEST_CASE("Seeded generation matches the golden corpus", "[grid][seed]") {
+    struct LevelConfig {
+        int size;
+        int minObjects;
+        int maxObjects;
+        std::vector<GridCellType> objectTypes;
+    };
+    const std::vector<GridCellType> bumpers = {GridCellType::Bumper};
+    const std::vector<GridCellType> tunnels = {GridCellType::Bumper, GridCellType::Tunnel};
+    const std::vector<GridCellType> teleporters = {GridCellType::Bumper, GridCellType::Tunnel,
+                                                   GridCellType::Teleporter};
+    const std::vector<GridCellType> activated = {GridCellType::Bumper, GridCellType::Tunnel,
+                                                 GridCellType::Teleporter, GridCellType::ActivatedBumper};
+    const std::vector<GridCellType> directional = {GridCellType::Bumper, GridCellType::Tunnel,
+                                                   GridCellType::Teleporter, GridCellType::ActivatedBumper,
+                                                   GridCellType::DirectionalBumper};
+    // Level.swift, in order
+    const std::vector<LevelConfig> levels = {
+        {5, 1, 1, bumpers}, {5, 2, 2, bumpers}, {6, 3, 4, bumpers}, {6, 3, 4, tunnels}, {7, 4, 6, tunnels},
+        {10, 6, 7, teleporters}, {10, 7, 8, teleporters}, {10, 7, 9, activated}, {10, 8, 10, activated},
+        {10, 10, 12, directional}, {10, 11, 13, directional},
+    };
+
+    // The board each level's config generates from each seed. Seed-only
+    // level packs depend on these never changing: a change to the generator
+    // that moves them needs a new pack.
+    const std::uint32_t seeds[] = {1, 2, 3, 0xDEADBEEF};
+    const std::uint64_t golden[][4] = {
+        {0xE078C7AF1EBFD339ull, 0xB890264A3F62B0F2ull, 0xA9FF0F19539C6189ull, 0xAF3E6EB5C90FCB21ull},
+        {0xA659E31BDC74A4FEull, 0x4762E775D2521C29ull, 0xC4BBE6557A7CCEF3ull, 0x76BA7DED8E37D1D9ull},
+        {0x90091EE5474F0826ull, 0xEF13B432B078563Full, 0x6AF9D952ED1B238Bull, 0x6B78B453E91E87F0ull},
+        {0x8D2B1B87F40A93EFull, 0xFF43FE69EE387911ull, 0x0507AEF00B78C6FAull, 0x860E9ABDB2E7A64Dull},
+        {0x851F4340EB513DF5ull, 0xD9D07619CCCC36F8ull, 0x719FFB631DFA72AEull, 0x04C93873971C2A8Eull},
+        {0xE404D8634C6F6737ull, 0x1AA9506F1622A593ull, 0x4440C654CBDEFB97ull, 0xEFDED18A4C671DC1ull},
+        {0x8BB2B034C78BFC5Dull, 0x7F2F4F2942AF9DCAull, 0x58B66EFF950DF71Full, 0x5D6970076D9CF98Cull},
+        {0xB456DE7B5C10FBE7ull, 0x476AB7A201A78F76ull, 0xE103881D1EE87690ull, 0xFAB59DA1D7AD1CE7ull},
+        {0xF92BB3C2E7A94E52ull, 0xF2354252798F8EE4ull, 0x20D3C495D5A5FDC0ull, 0x68A49C76052B59B2ull},
+        {0x5869B59E0EC6BDDFull, 0xF951A5A81C6DDC61ull, 0xB56D615720DCEE53ull, 0xB7166F72EA056EC0ull},
+        {0x4BE295DDCC133C24ull, 0xC4A0D699179D91FFull, 0x9AE6204CE4C6AC89ull, 0x3A1D2A53F2CC88F1ull},
+    };
+
+    for (std::size_t level = 0; level < levels.size(); level++) {
+        const LevelConfig& config = levels[level];
+        for (int i = 0; i < 4; i++) {
+            Grid grid(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+            grid.seed(seeds[i]);
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+            INFO("level " << level << " seed " << seeds[i]);
+            REQUIRE(serializedHash(grid) == golden[level][i]);
+        }
+    }
+
+    SECTION("Engines, earlier boards and the bridge do not change the result") {
+        const LevelConfig& config = levels[9];
+        Grid reference(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+        SparseGrid sparse(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+        AnyGrid fixed = makeGrid(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+        REQUIRE(std::holds_alternative<GridN<10>>(fixed));
+        GridN<10>& fixedGrid = std::get<GridN<10>>(fixed);
+        for (std::uint32_t seed = 100; seed < 150; seed++) {
+            reference.seed(seed);
+            REQUIRE(reference.generateGrid() == GRID_STATUS_OK);
+            // Boards left over from unseeded generation are reset first
+            REQUIRE(sparse.generateGrid() == GRID_STATUS_OK);
+            sparse.seed(seed);
+            REQUIRE(sparse.generateGrid() == GRID_STATUS_OK);
+            fixedGrid.seed(seed);
+            REQUIRE(fixedGrid.generateGrid() == GRID_STATUS_OK);
+            requireSameGrid(reference, sparse);
+            requireSameGrid(reference, fixedGrid);
+        }
+
+        int types[5];
+        for (int i = 0; i < 5; i++) {
+            types[i] = static_cast<int>(config.objectTypes[i]);
+        }
+        void* bridged = Grid_Create(config.size, config.minObjects, config.maxObjects, types, 5);
+        REQUIRE(Grid_GenerateSeeded(bridged, seeds[2]) == GRID_STATUS_OK);
+        REQUIRE(std::visit([](auto& engine) { return serializedHash(engine); }, *static_cast<AnyGrid*>(bridged))
+                == golden[9][2]);
+        Grid_Destroy(bridged);
+    }
+
+    SECTION("No two pairs on a board share a symbol") {
+        // Attempts that fail and boards generated earlier draw symbols too;
+        // neither may use up the next board's
+        const LevelConfig& config = levels[10];
+        Grid grid(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+        for (std::uint32_t seed = 0; seed < 500; seed++) {
+            if (seed % 2 == 0) {
+                grid.seed(seed);
+            }
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+            std::set<int> symbols;
+            for (const TeleporterPair& pair : grid.teleporterPairs) {
+                INFO("seed " << seed);
+                REQUIRE(symbols.insert(pair.index).second);
+            }
+        }
+    }
+
+    SECTION("Levels stored as seeds regenerate the same boards") {
+        const std::string path = (std::filesystem::temp_directory_path() / "GridTests.seeds.pack").string();
+        const LevelConfig& config = levels[7];
+        Grid grid(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+        Grid turned(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+        LevelPackWriter writer;
+        std::vector<std::uint64_t> hashes;
+        for (std::uint32_t seed = 0; seed < 20; seed++) {
+            const Symmetry symmetry = static_cast<Symmetry>(seed % SYMMETRY_COUNT);
+            grid.seed(seed);
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+            REQUIRE(turned.transformFrom(grid, symmetry) == GRID_STATUS_OK);
+            hashes.push_back(serializedHash(turned));
+            REQUIRE(writer.addSeed(LevelPackFormat::configOf(grid), 1, seed, symmetry) == GRID_STATUS_OK);
+        }
+        // A config holds seeds or boards, not both
+        REQUIRE(writer.add(grid, 1) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(writer.write(path.c_str()) == GRID_STATUS_OK);
+
+        LevelPack pack;
+        REQUIRE(pack.open(path.c_str()) == GRID_STATUS_OK);
+        const int found = pack.findConfig(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+        REQUIRE(found == 0);
+        REQUIRE(pack.level(found, 1, 0) == nullptr);
+        Grid rebuilt(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+        for (std::uint64_t random = 0; random < 20; random++) {
+            std::uint32_t seed = 0;
+            Symmetry symmetry = Symmetry::Identity;
+            REQUIRE(pack.levelSeed(found, 1, random, seed, symmetry));
+            REQUIRE(seed == random);
+            REQUIRE(symmetry == static_cast<Symmetry>(random % SYMMETRY_COUNT));
+            rebuilt.seed(seed);
+            REQUIRE(rebuilt.generateGrid() == GRID_STATUS_OK);
+            REQUIRE(turned.transformFrom(rebuilt, symmetry) == GRID_STATUS_OK);
+            REQUIRE(serializedHash(turned) == hashes[random]);
+        }
+        std::uint32_t seed = 0;
+        Symmetry symmetry = Symmetry::Identity;
+        REQUIRE_FALSE(pack.levelSeed(found, 0, 0, seed, symmetry));
+
+        void* bridged = LevelPack_Open(path.c_str());
+        unsigned int bridgedSeed = 0;
+        int bridgedSymmetry = 0;
+        REQUIRE(LevelPack_GetLevelSeed(bridged, found, 1, 27, &bridgedSeed, &bridgedSymmetry) == GRID_STATUS_OK);
+        REQUIRE(bridgedSeed == 7);
+        REQUIRE(bridgedSymmetry == 7);
+        REQUIRE(LevelPack_GetLevelSeed(bridged, found, 1, 27, &bridgedSeed, nullptr) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(LevelPack_GetLevel(bridged, found, 1, 27) == nullptr);
+        LevelPack_Close(bridged);
+        pack.close();
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE("Turned and flipped boards share a canonical form", "[grid][symmetry]") {
+    using Symmetries::mapOrientation;
+    REQUIRE(mapOrientation(Symmetry::MirrorColumns, GridCellType::Bumper, Orientation::UpRight) == Orientation::DownRight);
+    REQUIRE(mapOrientation(Symmetry::Transpose, GridCellType::Bumper, Orientation::UpRight) == Orientation::UpRight);
+    REQUIRE(mapOrientation(Symmetry::Rotate90, GridCellType::ActivatedBumper, Orientation::DownRight) == Orientation::UpRight);
+    REQUIRE(mapOrientation(Symmetry::Rotate90, GridCellType::Tunnel, Orientation::Vertical) == Orientation::Horizontal);
+    REQUIRE(mapOrientation(Symmetry::MirrorRows, GridCellType::Tunnel, Orientation::Vertical) == Orientation::Vertical);
+    REQUIRE(mapOrientation(Symmetry::Rotate90, GridCellType::DirectionalBumper, Orientation::TopLeft) == Orientation::TopRight);
+    REQUIRE(mapOrientation(Symmetry::MirrorRows, GridCellType::DirectionalBumper, Orientation::TopLeft) == Orientation::BottomLeft);
+    REQUIRE(mapOrientation(Symmetry::Rotate180, GridCellType::Teleporter, Orientation::None) == Orientation::None);
+
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    Grid grid(10, 10, 13, objectTypes);
+    Grid transformed(5, 1, 1, {GridCellType::Bumper});
+    Grid canonical(5, 1, 1, {GridCellType::Bumper});
+    grid.seed(45);
+    for (int i = 0; i < 50; i++) {
+        REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+        CanonicalForm form;
+        REQUIRE(canonicalForm(grid, form));
+        canonical = grid;
+        REQUIRE(canonicalize(canonical) == GRID_STATUS_OK);
+
+        for (int s = 0; s < SYMMETRY_COUNT; s++) {
+            const Symmetry symmetry = static_cast<Symmetry>(s);
+            REQUIRE(transformed.transformFrom(grid, symmetry) == GRID_STATUS_OK);
+            REQUIRE(transformed.entryPos == Symmetries::mapIndex(symmetry, 10, grid.entryPos));
+            REQUIRE(transformed.ballPath.size() == grid.ballPath.size());
+
+            CanonicalForm transformedForm;
+            REQUIRE(canonicalForm(transformed, transformedForm));
+            REQUIRE(transformedForm.hash == form.hash);
+            REQUIRE(canonicalize(transformed) == GRID_STATUS_OK);
+            requireSameGrid(transformed, canonical);
+        }
+    }
+
+    SECTION("Only boards that are turns or flips of one another are merged") {
+        // Every one-bumper 5x5 board comes up; at most eight share a form
+        GridN<5> small(5, 1, 1, {GridCellType::Bumper});
+        std::set<std::uint64_t> boards;
+        std::set<std::uint64_t> forms;
+        for (int i = 0; i < 2000; i++) {
+            REQUIRE(small.generateGrid() == GRID_STATUS_OK);
+            CanonicalForm form;
+            REQUIRE(canonicalForm(small, form));
+            boards.insert(serializedHash(small));
+            forms.insert(form.hash);
+        }
+        REQUIRE(forms.size() < boards.size());
+        REQUIRE(forms.size() * SYMMETRY_COUNT >= boards.size());
+    }
+
+    SECTION("Pack levels have the form of their grid") {
+        std::vector<std::uint64_t> record(LevelPackFormat::recordSize(10) / sizeof(std::uint64_t));
+        auto* bytes = reinterpret_cast<std::uint8_t*>(record.data());
+        for (int s = 0; s < SYMMETRY_COUNT; s++) {
+            REQUIRE(transformed.transformFrom(grid, static_cast<Symmetry>(s)) == GRID_STATUS_OK);
+            REQUIRE(LevelPackFormat::encodeLevel(transformed, bytes) == GRID_STATUS_OK);
+            CanonicalForm gridForm;
+            CanonicalForm levelForm;
+            REQUIRE(canonicalForm(transformed, gridForm));
+            REQUIRE(canonicalForm(PackLevel(reinterpret_cast<const LevelPackFormat::LevelHeader*>(bytes)), levelForm));
+            REQUIRE(levelForm.hash == gridForm.hash);
+            REQUIRE(levelForm.symmetry == gridForm.symmetry);
+        }
+    }
+
+    SECTION("Boards whose pairs share a symbol are not stored") {
+        // A record pairs teleporters by symbol, so two pairs of one symbol
+        // would read back paired differently
+        Grid teleporters(10, 6, 8, {GridCellType::Teleporter, GridCellType::Bumper});
+        std::uint32_t seed = 1;
+        do {
+            teleporters.seed(seed++);
+            REQUIRE(teleporters.generateGrid() == GRID_STATUS_OK);
+        } while (teleporters.teleporterPairs.size() < 2);
+
+        std::vector<std::uint64_t> record(LevelPackFormat::recordSize(10) / sizeof(std::uint64_t));
+        auto* bytes = reinterpret_cast<std::uint8_t*>(record.data());
+        REQUIRE(LevelPackFormat::encodeLevel(teleporters, bytes) == GRID_STATUS_OK);
+        CanonicalForm gridForm;
+        CanonicalForm levelForm;
+        REQUIRE(canonicalForm(teleporters, gridForm));
+        REQUIRE(canonicalForm(PackLevel(reinterpret_cast<const LevelPackFormat::LevelHeader*>(bytes)), levelForm));
+        REQUIRE(levelForm.hash == gridForm.hash);
+
+        for (TeleporterPair& pair : teleporters.teleporterPairs) {
+            pair.index = 0;
+            teleporters.cellAt(teleporters.rowOf(pair.first), teleporters.colOf(pair.first)).teleporterIndex = 0;
+            teleporters.cellAt(teleporters.rowOf(pair.second), teleporters.colOf(pair.second)).teleporterIndex = 0;
+        }
+        REQUIRE(LevelPackFormat::encodeLevel(teleporters, bytes) == GRID_STATUS_INVALID_ARGUMENT);
+        LevelPackWriter writer;
+        REQUIRE(writer.add(teleporters, 0) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(writer.levelCount() == 0);
+    }
+
+    SECTION("Other engines and boards without an entry") {
+        SparseGrid sparse(10, 10, 13, objectTypes);
+        REQUIRE(sparse.generateGrid() == GRID_STATUS_OK);
+        SparseGrid turned(10, 10, 13, objectTypes);
+        REQUIRE(turned.transformFrom(sparse, Symmetry::AntiTranspose) == GRID_STATUS_OK);
+        CanonicalForm sparseForm;
+        CanonicalForm turnedForm;
+        REQUIRE(canonicalForm(sparse, sparseForm));
+        REQUIRE(canonicalForm(turned, turnedForm));
+        REQUIRE(turnedForm.hash == sparseForm.hash);
+        REQUIRE(turned.transformFrom(turned, Symmetry::Rotate90) == GRID_STATUS_INVALID_ARGUMENT);
+
+        Grid empty(10, 10, 13, objectTypes);
+        REQUIRE(transformed.transformFrom(empty, Symmetry::Rotate90) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(canonicalize(empty) == GRID_STATUS_INVALID_ARGUMENT);
+    }
+}
+
+template <typename Engine>
+static void requireVariantsOf(const Engine& grid) {
+    Symmetry variants[SYMMETRY_COUNT];
+    const int count = symmetryVariants(grid, variants);
+    REQUIRE(count >= 1);
+    REQUIRE(variants[0] == Symmetry::Identity);
+
+    // Every transform's board is one of the variants, and no two variants
+    // are the same board
+    Engine variant = grid;
+    std::set<std::uint64_t> boards;
+    for (int s = 0; s < SYMMETRY_COUNT; s++) {
+        REQUIRE(variant.transformFrom(grid, static_cast<Symmetry>(s)) == GRID_STATUS_OK);
+        boards.insert(serializedHash(variant));
+    }
+    REQUIRE(boards.size() == static_cast<std::size_t>(count));
+
+    const int n = grid.side();
+    for (int i = 0; i < count; i++) {
+        const Symmetry symmetry = variants[i];
+        REQUIRE(variant.transformFrom(grid, symmetry) == GRID_STATUS_OK);
+        REQUIRE(variant.entryPos == Symmetries::mapIndex(symmetry, n, grid.entryPos));
+        REQUIRE(variant.teleporterPairs.size() == grid.teleporterPairs.size());
+        for (std::size_t pair = 0; pair < grid.teleporterPairs.size(); pair++) {
+            REQUIRE(variant.teleporterPairs[pair].first == Symmetries::mapIndex(symmetry, n, grid.teleporterPairs[pair].first));
+            REQUIRE(variant.teleporterPairs[pair].second == Symmetries::mapIndex(symmetry, n, grid.teleporterPairs[pair].second));
+        }
+
+        // Simulating the variant walks the same path, transformed
+        const CellIndex exit = variant.simulate();
+        REQUIRE(exit == (grid.exitPos == INVALID_CELL ? INVALID_CELL : Symmetries::mapIndex(symmetry, n, grid.exitPos)));
+        REQUIRE(variant.ballPath.size() == grid.ballPath.size());
+        for (std::size_t step = 0; step < grid.ballPath.size(); step++) {
+            REQUIRE(variant.ballPath[step].pos == Symmetries::mapIndex(symmetry, n, grid.ballPath[step].pos));
+            REQUIRE(variant.ballPath[step].landed == Symmetries::mapIndex(symmetry, n, grid.ballPath[step].landed));
+            REQUIRE(variant.ballPath[step].direction == Symmetries::mapDirection(symmetry, grid.ballPath[step].direction));
+        }
+    }
+}
+
+TEST_CASE("Generated grids give up to eight variants with the transformed exit", "[grid][symmetry]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    Grid grid(10, 10, 13, objectTypes);
+    SparseGrid sparse(12, 6, 10, objectTypes);
+    GridN<7> fixed(7, 4, 6, {GridCellType::Bumper, GridCellType::Tunnel});
+    grid.seed(46);
+    sparse.seed(46);
+    fixed.seed(46);
+    for (int i = 0; i < 50; i++) {
+        REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+        requireVariantsOf(grid);
+        REQUIRE(sparse.generateGrid() == GRID_STATUS_OK);
+        requireVariantsOf(sparse);
+        REQUIRE(fixed.generateGrid() == GRID_STATUS_OK);
+        requireVariantsOf(fixed);
+    }
+
+    SECTION("Boards with a symmetry of their own give fewer") {
+        GridN<5> small(5, 1, 1, {GridCellType::Tunnel});
+        small.seed(46);
+        int symmetric = 0;
+        for (int i = 0; i < 200; i++) {
+            REQUIRE(small.generateGrid() == GRID_STATUS_OK);
+            Symmetry variants[SYMMETRY_COUNT];
+            symmetric += symmetryVariants(small, variants) < SYMMETRY_COUNT ? 1 : 0;
+            requireVariantsOf(small);
+        }
+        REQUIRE(symmetric > 0);
+    }
+
+    SECTION("Bridge") {
+        const int types[] = {static_cast<int>(GridCellType::Bumper), static_cast<int>(GridCellType::Tunnel)};
+        void* handle = Grid_Create(7, 4, 6, types, 2);
+        REQUIRE(Grid_GenerateSeeded(handle, 46) == GRID_STATUS_OK);
+        int row = -1;
+        int col = -1;
+        REQUIRE(Grid_GetExit(handle, &row, &col) == GRID_STATUS_OK);
+        REQUIRE(Grid_Transform(handle, static_cast<int>(Symmetry::Rotate90)) == GRID_STATUS_OK);
+        int turnedRow = -1;
+        int turnedCol = -1;
+        REQUIRE(Grid_GetExit(handle, &turnedRow, &turnedCol) == GRID_STATUS_OK);
+        if (row >= 0) {
+            REQUIRE(turnedRow == col);
+            REQUIRE(turnedCol == 6 - row);
+        }
+        REQUIRE(Grid_Transform(handle, SYMMETRY_COUNT) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(Grid_Transform(nullptr, 0) == GRID_STATUS_NULL_GRID);
+        Grid_Destroy(handle);
+    }
+}
+
+TEST_CASE("Fingerprints follow the board as it changes", "[grid][fingerprint]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    std::vector<std::uint8_t> bytes(4096);
+    std::size_t written = 0;
+
+    // A board built by generation, edits or loading has the fingerprint of
+    // the same board built any other way
+    Grid grid(10, 6, 12, objectTypes);
+    Grid loaded(5, 1, 1, {GridCellType::Bumper});
+    grid.seed(47);
+    for (int i = 0; i < 100; i++) {
+        REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+        REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+        REQUIRE(loaded.deserialize(bytes.data(), written) == GRID_STATUS_OK);
+        REQUIRE(loaded.fingerprint() == grid.fingerprint());
+        REQUIRE(loaded.sameBoard(grid));
+
+        const std::uint64_t generated = grid.fingerprint();
+        const int row = 1 + i % 8;
+        const int col = 1 + (i / 8) % 8;
+        const GridCell before = grid.cellAt(row, col);
+        REQUIRE(grid.setCell(row, col, GridCellType::Tunnel, Orientation::Vertical) == GRID_STATUS_OK);
+        REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+        REQUIRE(loaded.deserialize(bytes.data(), written) == GRID_STATUS_OK);
+        REQUIRE(loaded.fingerprint() == grid.fingerprint());
+        if (before.type != GridCellType::Teleporter) {
+            // Putting the cell back restores the board
+            const bool wasObject = isObjectCell(before.type);
+            REQUIRE(grid.setCell(row, col, wasObject ? before.type : GridCellType::Empty,
+                                 wasObject ? before.orientation : Orientation::None) == GRID_STATUS_OK);
+            REQUIRE(grid.fingerprint() == generated);
+        }
+
+        Grid turned = grid;
+        REQUIRE(turned.transformFrom(grid, Symmetry::Identity) == GRID_STATUS_OK);
+        REQUIRE(turned.fingerprint() == grid.fingerprint());
+    }
+
+    SECTION("Different boards have different fingerprints") {
+        GridN<6> small(6, 3, 4, {GridCellType::Bumper, GridCellType::Tunnel});
+        small.seed(47);
+        REQUIRE(small.generateGrid() == GRID_STATUS_OK);
+        GridN<6> previous = small;
+        std::set<std::uint64_t> boards;
+        std::set<std::uint64_t> fingerprints;
+        for (int i = 0; i < 2000; i++) {
+            REQUIRE(small.generateGrid() == GRID_STATUS_OK);
+            boards.insert(serializedHash(small));
+            fingerprints.insert(small.fingerprint());
+            REQUIRE(small.sameBoard(previous) == (serializedHash(small) == serializedHash(previous)));
+            previous = small;
+        }
+        REQUIRE(fingerprints.size() == boards.size());
+    }
+
+    SECTION("Teleporter symbols and the ball's path do not count") {
+        Grid teleporters(10, 6, 8, {GridCellType::Teleporter, GridCellType::Bumper});
+        Grid other(10, 6, 8, {GridCellType::Teleporter, GridCellType::Bumper});
+        REQUIRE(teleporters.generateGrid() == GRID_STATUS_OK);
+        REQUIRE(other.transformFrom(teleporters, Symmetry::Identity) == GRID_STATUS_OK);
+        for (TeleporterPair& pair : other.teleporterPairs) {
+            other.cellAt(other.rowOf(pair.first), other.colOf(pair.first)).teleporterIndex = pair.index + 1;
+        }
+        other.simulate();
+        REQUIRE(other.fingerprint() == teleporters.fingerprint());
+        REQUIRE(other.sameBoard(teleporters));
+
+        Grid turned = teleporters;
+        REQUIRE(turned.transformFrom(teleporters, Symmetry::Rotate180) == GRID_STATUS_OK);
+        REQUIRE(turned.fingerprint() != teleporters.fingerprint());
+        REQUIRE_FALSE(turned.sameBoard(teleporters));
+    }
+
+    SECTION("Bridge") {
+        const int types[] = {static_cast<int>(GridCellType::Bumper), static_cast<int>(GridCellType::Tunnel)};
+        void* handle = Grid_Create(7, 4, 6, types, 2);
+        GridN<7> fixed(7, 4, 6, {GridCellType::Bumper, GridCellType::Tunnel});
+        REQUIRE(Grid_GenerateSeeded(handle, 47) == GRID_STATUS_OK);
+        fixed.seed(47);
+        REQUIRE(fixed.generateGrid() == GRID_STATUS_OK);
+        unsigned long long fingerprint = 0;
+        REQUIRE(Grid_GetFingerprint(handle, &fingerprint) == GRID_STATUS_OK);
+        REQUIRE(fingerprint == fixed.fingerprint());
+        REQUIRE(Grid_GetFingerprint(handle, nullptr) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(Grid_GetFingerprint(nullptr, &fingerprint) == GRID_STATUS_NULL_GRID);
+        Grid_Destroy(handle);
+    }
+}
+
+// Every board an enumeration covers, found and expanded to its variants as
+// PackCompiler --enumerate does, as serialized hashes
+static std::set<std::uint64_t> enumeratedBoards(const LevelEnumerator& enumerator, Grid& grid) {
+    std::set<std::uint64_t> boards;
+    Grid variant = grid;
+    for (const LevelEnumerator::Job& job : enumerator.jobs()) {
+        enumerator.run(job, [&](CellIndex entry, const std::vector<BoardObject>& objects) {
+            REQUIRE(grid.loadBoard(entry, objects.data(), objects.size()) == GRID_STATUS_OK);
+            CanonicalForm form;
+            REQUIRE(canonicalForm(grid, form));
+            if (form.symmetry != Symmetry::Identity) {
+                return;
+            }
+            Symmetry variants[SYMMETRY_COUNT];
+            const int count = symmetryVariants(grid, variants);
+            for (int i = 0; i < count; i++) {
+                REQUIRE(variant.transformFrom(grid, variants[i]) == GRID_STATUS_OK);
+                REQUIRE(boards.insert(serializedHash(variant)).second);
+            }
+        });
+    }
+    return boards;
+}
+
+TEST_CASE("Enumeration lists every valid board of a small configuration", "[grid][enumerate]") {
+    // Against trying every entry with every layout of up to two objects
+    const std::vector<GridCellType> objectTypes = {GridCellType::Bumper, GridCellType::Tunnel};
+    Grid grid(5, 1, 2, objectTypes);
+    const LevelEnumerator enumerator(5, 1, 2, objectTypes);
+    REQUIRE(enumerator.status() == GRID_STATUS_OK);
+    REQUIRE(enumerator.objects().size() == 4);
+    const std::set<std::uint64_t> boards = enumeratedBoards(enumerator, grid);
+
+    std::set<std::uint64_t> expected;
+    std::vector<CellIndex> interior;
+    for (int row = 1; row < 4; row++) {
+        for (int col = 1; col < 4; col++) {
+            interior.push_back(grid.toIndex(row, col));
+        }
+    }
+    std::vector<BoardObject> layout;
+    auto check = [&](CellIndex entry) {
+        REQUIRE(grid.loadBoard(entry, layout.data(), layout.size()) == GRID_STATUS_OK);
+        std::set<CellIndex> entered;
+        for (const PathStep& step : grid.ballPath) {
+            if (isObjectCell(grid.gridCells[step.pos].type)) {
+                entered.insert(step.pos);
+            }
+        }
+        if (grid.exitPos != INVALID_CELL && entered.size() >= 1) {
+            expected.insert(serializedHash(grid));
+        }
+    };
+    for (CellIndex entry = 0; entry < 25; entry++) {
+        const int row = grid.rowOf(entry);
+        const int col = grid.colOf(entry);
+        if (!isRingCell(entry, 5) || ((row == 0 || row == 4) && (col == 0 || col == 4))) {
+            continue;
+        }
+        for (std::size_t a = 0; a < interior.size(); a++) {
+            for (const BoardObject& first : enumerator.objects()) {
+                layout = {{interior[a], first.type, first.orientation}};
+                check(entry);
+                for (std::size_t b = a + 1; b < interior.size(); b++) {
+                    for (const BoardObject& second : enumerator.objects()) {
+                        layout.resize(1);
+                        layout.push_back({interior[b], second.type, second.orientation});
+                        check(entry);
+                    }
+                }
+            }
+        }
+    }
+    REQUIRE(boards == expected);
+
+    SECTION("Boards generated for the early levels are all listed") {
+        const struct {
+            int size, minObjects, maxObjects;
+            std::vector<GridCellType> objectTypes;
+        } configs[] = {
+            {5, 1, 1, {GridCellType::Bumper}},
+            {5, 2, 2, {GridCellType::Bumper}},
+            {6, 3, 4, {GridCellType::Bumper}},
+            {6, 3, 4, {GridCellType::Bumper, GridCellType::Tunnel}},
+        };
+        for (const auto& config : configs) {
+            Grid loaded(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+            const std::set<std::uint64_t> listed = enumeratedBoards(
+                LevelEnumerator(config.size, config.minObjects, config.maxObjects, config.objectTypes), loaded);
+            Grid generated(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+            generated.seed(48);
+            for (int i = 0; i < 300; i++) {
+                REQUIRE(generated.generateGrid() == GRID_STATUS_OK);
+                REQUIRE(listed.count(serializedHash(generated)) == 1);
+            }
+        }
+    }
+
+    SECTION("Configurations and boards it cannot take are rejected") {
+        const LevelEnumerator teleporters(6, 2, 2, {GridCellType::Bumper, GridCellType::Teleporter});
+        REQUIRE(teleporters.status() == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(teleporters.jobs().empty());
+        REQUIRE(LevelEnumerator(5, 3, 2, objectTypes).status() == GRID_STATUS_INVALID_ARGUMENT);
+
+        const BoardObject twice[] = {
+            {grid.toIndex(2, 2), GridCellType::Bumper, Orientation::UpRight},
+            {grid.toIndex(2, 2), GridCellType::Tunnel, Orientation::Vertical},
+        };
+        REQUIRE(grid.loadBoard(grid.toIndex(0, 2), twice, 2) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(grid.fingerprint() == Grid(5, 1, 2, objectTypes).fingerprint());
+        REQUIRE(grid.loadBoard(grid.toIndex(0, 0), twice, 1) == GRID_STATUS_INVALID_ARGUMENT);
+        const BoardObject sideways[] = {{grid.toIndex(2, 2), GridCellType::Tunnel, Orientation::UpRight}};
+        REQUIRE(grid.loadBoard(grid.toIndex(0, 2), sideways, 1) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(grid.loadBoard(grid.toIndex(0, 2), twice, 1) == GRID_STATUS_OK);
+        REQUIRE(grid.exitPos == grid.toIndex(2, 0));
+    }
+}
+
+TEST_CASE("Backward generation lays exactly minObjects on the path", "[grid][backward]") {
+    const std::vector<GridCellType> allTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    const struct {
+        int size, minObjects, maxObjects;
+        std::vector<GridCellType> objectTypes;
+    } configs[] = {
+        {5, 1, 1, {GridCellType::Bumper}},
+        {5, 2, 2, {GridCellType::Bumper}},
+        {6, 3, 4, {GridCellType::Bumper, GridCellType::Tunnel}},
+        {7, 4, 6, {GridCellType::Bumper, GridCellType::Tunnel}},
+        {10, 7, 9, {GridCellType::Bumper, GridCellType::Tunnel, GridCellType::Teleporter,
+                    GridCellType::ActivatedBumper}},
+        {10, 11, 13, allTypes},
+        {32, 60, 80, allTypes},
+    };
+    std::vector<std::uint8_t> bytes(1 << 16);
+    std::size_t written = 0;
+    for (const auto& config : configs) {
+        Grid grid(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+        Grid loaded(config.size, config.minObjects, config.maxObjects, config.objectTypes);
+        grid.seed(49);
+        for (int i = 0; i < 200; i++) {
+            REQUIRE(grid.generateGridBackward() == GRID_STATUS_OK);
+            REQUIRE(grid.exitPos != INVALID_CELL);
+
+            // Each object on the path is entered once, and the walk is the
+            // one a plain simulation finds
+            std::set<CellIndex> entered;
+            for (const PathStep& step : grid.ballPath) {
+                for (CellIndex pos : {step.pos, step.landed}) {
+                    if (isObjectCell(grid.gridCells[pos].type)) {
+                        entered.insert(pos);
+                    }
+                }
+            }
+            REQUIRE(entered.size() == static_cast<std::size_t>(config.minObjects));
+            int objects = 0;
+            for (CellIndex pos = 0; pos < grid.gridCells.size(); pos++) {
+                objects += isObjectCell(grid.gridCells[pos].type) ? 1 : 0;
+            }
+            REQUIRE(objects >= config.minObjects);
+            REQUIRE(objects <= config.maxObjects);
+
+            REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+            REQUIRE(loaded.deserialize(bytes.data(), written) == GRID_STATUS_OK);
+            REQUIRE(loaded.exitPos == grid.exitPos);
+            REQUIRE(loaded.ballPath.size() == grid.ballPath.size());
+            REQUIRE(loaded.fingerprint() == grid.fingerprint());
+        }
+    }
+
+    SECTION("Seeded and checked like generateGrid") {
+        GridN<10> first(10, 10, 12, allTypes);
+        GridN<10> second(10, 10, 12, allTypes);
+        first.seed(49);
+        second.seed(49);
+        for (int i = 0; i < 20; i++) {
+            REQUIRE(first.generateGridBackward() == GRID_STATUS_OK);
+            REQUIRE(second.generateGridBackward() == GRID_STATUS_OK);
+            REQUIRE(first.sameBoard(second));
+        }
+        Grid tooSmall(2, 1, 1, {GridCellType::Bumper});
+        REQUIRE(tooSmall.generateGridBackward() == GRID_STATUS_INVALID_ARGUMENT);
+        // A teleporter pair cannot make an odd count
+        Grid pairs(6, 3, 3, {GridCellType::Teleporter});
+        REQUIRE(pairs.generateGridBackward() == GRID_STATUS_GENERATION_FAILED);
+
+        const int types[] = {static_cast<int>(GridCellType::Bumper), static_cast<int>(GridCellType::Tunnel)};
+        void* handle = Grid_Create(7, 4, 6, types, 2);
+        REQUIRE(Grid_GenerateBackward(handle) == GRID_STATUS_OK);
+        REQUIRE(Grid_GenerateBackward(nullptr) == GRID_STATUS_NULL_GRID);
+        Grid_Destroy(handle);
+    }
+}
+
+// Counts the metrics of grid's walk from ballPath and the cells, step by step
+static void requireMetricsOf(const Grid& grid) {
+    PathMetrics expected{};
+    std::set<CellIndex> entered;
+    for (std::size_t i = 1; i < grid.ballPath.size(); i++) {
+        const PathStep& step = grid.ballPath[i];
+        const GridCellType type = grid.gridCells[step.pos].type;
+        const bool first = entered.count(step.pos) == 0;
+        expected.steps++;
+        expected.directionChanges += step.direction != Direction::None
+            && step.direction != grid.ballPath[i - 1].direction ? 1 : 0;
+        if (type == GridCellType::Teleporter) {
+            expected.teleporterHops++;
+        } else if (type == GridCellType::ActivatedBumper && first) {
+            expected.activatedPassThroughs++;
+        } else if (isObjectCell(type)) {
+            expected.bounces++;
+        }
+        expected.selfCrossings += !first && !isBorderCell(type) ? 1 : 0;
+        entered.insert(step.pos);
+        entered.insert(step.landed);
+    }
+    REQUIRE(grid.pathMetrics.steps == expected.steps);
+    REQUIRE(grid.pathMetrics.bounces == expected.bounces);
+    REQUIRE(grid.pathMetrics.directionChanges == expected.directionChanges);
+    REQUIRE(grid.pathMetrics.teleporterHops == expected.teleporterHops);
+    REQUIRE(grid.pathMetrics.selfCrossings == expected.selfCrossings);
+    REQUIRE(grid.pathMetrics.activatedPassThroughs == expected.activatedPassThroughs);
+}
+
+TEST_CASE("Path metrics are counted in the walk that makes the path", "[grid][metrics]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+    Grid grid(10, 8, 14, objectTypes);
+    Grid loaded(10, 8, 14, objectTypes);
+    std::vector<std::uint8_t> bytes(4096);
+    std::size_t written = 0;
+    grid.seed(50);
+    std::uint32_t hops = 0;
+    std::uint32_t passThroughs = 0;
+    std::uint32_t crossings = 0;
+    for (int i = 0; i < 300; i++) {
+        REQUIRE((i % 2 == 0 ? grid.generateGrid() : grid.generateGridBackward()) == GRID_STATUS_OK);
+        requireMetricsOf(grid);
+        hops += grid.pathMetrics.teleporterHops;
+        passThroughs += grid.pathMetrics.activatedPassThroughs;
+        crossings += grid.pathMetrics.selfCrossings;
+
+        // Edits re-walk part of the path and keep the counts of a full walk
+        for (int edit = 0; edit < 4; edit++) {
+            const int row = 1 + (i + 3 * edit) % 8;
+            const int col = 1 + (i / 8 + edit) % 8;
+            const bool place = edit % 2 == 0;
+            REQUIRE(grid.setCell(row, col, place ? GridCellType::Bumper : GridCellType::Empty,
+                                 place ? Orientation::UpRight : Orientation::None) == GRID_STATUS_OK);
+            requireMetricsOf(grid);
+        }
+        if (grid.exitPos != INVALID_CELL) {
+            REQUIRE(grid.serialize(bytes.data(), bytes.size(), written) == GRID_STATUS_OK);
+            REQUIRE(loaded.deserialize(bytes.data(), written) == GRID_STATUS_OK);
+            REQUIRE(loaded.pathMetrics.steps == grid.pathMetrics.steps);
+            REQUIRE(loaded.pathMetrics.selfCrossings == grid.pathMetrics.selfCrossings);
+        }
+    }
+    // Every measure came up
+    REQUIRE(hops > 0);
+    REQUIRE(passThroughs > 0);
+    REQUIRE(crossings > 0);
+
+    SECTION("A straight walk has no bounces") {
+        Grid straight(5, 0, 0, {GridCellType::Bumper});
+        REQUIRE(straight.loadBoard(straight.toIndex(0, 2), nullptr, 0) == GRID_STATUS_OK);
+        REQUIRE(straight.pathMetrics.steps == 4);
+        REQUIRE(straight.pathMetrics.bounces == 0);
+        REQUIRE(straight.pathMetrics.directionChanges == 0);
+    }
+
+    SECTION("Bridge") {
+        const int types[] = {static_cast<int>(GridCellType::Bumper), static_cast<int>(GridCellType::Tunnel)};
+        void* handle = Grid_Create(7, 4, 6, types, 2);
+        GridN<7> fixed(7, 4, 6, {GridCellType::Bumper, GridCellType::Tunnel});
+        REQUIRE(Grid_GenerateSeeded(handle, 50) == GRID_STATUS_OK);
+        fixed.seed(50);
+        REQUIRE(fixed.generateGrid() == GRID_STATUS_OK);
+        GridPathMetrics metrics = {};
+        REQUIRE(Grid_GetPathMetrics(handle, &metrics) == GRID_STATUS_OK);
+        REQUIRE(metrics.steps == fixed.pathMetrics.steps);
+        REQUIRE(metrics.bounces == fixed.pathMetrics.bounces);
+        REQUIRE(metrics.directionChanges == fixed.pathMetrics.directionChanges);
+        REQUIRE(metrics.selfCrossings == fixed.pathMetrics.selfCrossings);
+        REQUIRE(Grid_GetPathMetrics(handle, nullptr) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(Grid_GetPathMetrics(nullptr, &metrics) == GRID_STATUS_NULL_GRID);
+        Grid_Destroy(handle);
+    }
+}
+
+TEST_CASE("Sparse grids generate and simulate like dense ones", "[grid][storage]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+
+    for (int size : {10, 200}) {
+        SparseGrid grid(size, 6, 20, objectTypes);
+        for (int i = 0; i < 50; i++) {
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+
+            int objects = 0;
+            for (CellIndex pos = 0; pos < grid.gridCells.size(); pos++) {
+                objects += isObjectCell(grid.gridCells[pos].type) ? 1 : 0;
+            }
+            REQUIRE(objects >= grid.minObjects);
+            REQUIRE(objects <= grid.maxObjects);
+            REQUIRE(grid.gridCells.storedCells() <= grid.ballPath.size() + 2 * static_cast<std::size_t>(objects));
+
+            REQUIRE(grid.setCell(size / 2, size / 2, GridCellType::Bumper, Orientation::UpRight) == GRID_STATUS_OK);
+            CellIndex editedExit = grid.exitPos;
+            REQUIRE(grid.simulate() == editedExit);
+        }
+    }
+}
+
+TEST_CASE("Fixed-size engines are dispatched by side", "[grid][dispatch]") {
+    std::vector<GridCellType> objectTypes = {
+        GridCellType::Bumper,
+        GridCellType::DirectionalBumper,
+        GridCellType::Tunnel,
+        GridCellType::Teleporter,
+        GridCellType::ActivatedBumper
+    };
+
+    REQUIRE(std::holds_alternative<GridN<5>>(makeGrid(5, 2, 5, objectTypes)));
+    REQUIRE(std::holds_alternative<GridN<6>>(makeGrid(6, 3, 6, objectTypes)));
+    REQUIRE(std::holds_alternative<GridN<7>>(makeGrid(7, 4, 7, objectTypes)));
+    REQUIRE(std::holds_alternative<GridN<10>>(makeGrid(10, 7, 10, objectTypes)));
+    REQUIRE(std::holds_alternative<Grid>(makeGrid(8, 5, 8, objectTypes)));
+    REQUIRE(std::holds_alternative<Grid>(makeGrid(MIN_SPARSE_GRID_SIZE - 1, 5, 8, objectTypes)));
+    REQUIRE(std::holds_alternative<SparseGrid>(makeGrid(MIN_SPARSE_GRID_SIZE, 5, 8, objectTypes)));
+
+    for (int size : {5, 6, 7, 8, 10}) {
+        AnyGrid any = makeGrid(size, size - 3, size, objectTypes);
+        std::visit([&](auto& grid) {
+            REQUIRE(grid.side() == size);
+            for (int i = 0; i < 100; i++) {
+                REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+                REQUIRE(grid.gridCells[grid.exitPos].type == GridCellType::Exit);
+                CellIndex exitPos = grid.exitPos;
+                REQUIRE(grid.simulate() == exitPos);
+            }
+        }, any);
+    }
+
+    GridN<7> mismatched(9, 2, 4, objectTypes);
+    REQUIRE(mismatched.generateGrid() == GRID_STATUS_INVALID_ARGUMENT);
+
+    SECTION("Large boards through the bridge get sparse storage") {
+        const int types[] = {static_cast<int>(GridCellType::Bumper), static_cast<int>(GridCellType::Tunnel),
+                             static_cast<int>(GridCellType::Teleporter)};
+        for (int size : {MIN_SPARSE_GRID_SIZE, MAX_GRID_SIZE}) {
+            void* handle = Grid_Create(size, 10, 40, types, 3);
+            REQUIRE(handle != nullptr);
+            REQUIRE(std::holds_alternative<SparseGrid>(*static_cast<AnyGrid*>(handle)));
+            REQUIRE(Grid_GenerateSeeded(handle, 7) == GRID_STATUS_OK);
+
+            SparseGrid& engine = std::get<SparseGrid>(*static_cast<AnyGrid*>(handle));
+            REQUIRE(engine.gridCells.storedCells() < 1000000);
+            int row = 0;
+            int col = 0;
+            REQUIRE(Grid_GetExit(handle, &row, &col) == GRID_STATUS_OK);
+            REQUIRE(engine.toIndex(row, col) == engine.exitPos);
+            REQUIRE(Grid_GetCellType(handle, row, col) == static_cast<int>(GridCellType::Exit));
+            REQUIRE(engine.simulate() == engine.toIndex(row, col));
+
+            // Loading a board of a dense side switches the engine back
+            int written = 0;
+            void* small = Grid_Create(8, 2, 4, types, 3);
+            REQUIRE(Grid_GenerateGrid(small) == GRID_STATUS_OK);
+            std::vector<unsigned char> bytes(256);
+            REQUIRE(Grid_Serialize(small, bytes.data(), static_cast<int>(bytes.size()), &written) == GRID_STATUS_OK);
+            REQUIRE(Grid_Deserialize(handle, bytes.data(), written) == GRID_STATUS_OK);
+            REQUIRE(std::holds_alternative<Grid>(*static_cast<AnyGrid*>(handle)));
+            Grid_Destroy(small);
+            Grid_Destroy(handle);
+        }
+    }
+}
+
+TEST_CASE("Playfield is surrounded by sentinel border", "[grid]") {
+    std::vector<GridCellType> objectTypes = {GridCellType::Bumper};
+    Grid grid(6, 1, 1, objectTypes);
+
+    for (int i = 0; i < 6; i++) {
+        REQUIRE(isBorderCell(grid.cellAt(0, i).type));
+        REQUIRE(isBorderCell(grid.cellAt(5, i).type));
+        REQUIRE(isBorderCell(grid.cellAt(i, 0).type));
+        REQUIRE(isBorderCell(grid.cellAt(i, 5).type));
+    }
+    REQUIRE(grid.cellAt(2, 3).type == GridCellType::Empty);
+}
+
+TEST_CASE("Cell index conversions round trip", "[grid]") {
+    std::vector<GridCellType> objectTypes = {GridCellType::Bumper};
+    Grid grid(7, 1, 1, objectTypes);
+
+    for (int row = 0; row < 7; row++) {
+        for (int col = 0; col < 7; col++) {
+            CellIndex pos = grid.toIndex(row, col);
+            REQUIRE(grid.rowOf(pos) == row);
+            REQUIRE(grid.colOf(pos) == col);
+            REQUIRE(&grid.gridCells[pos] == &grid.cellAt(row, col));
+        }
+    }
+}
+
+TEST_CASE("Transition table is constant data", "[grid]") {
+    using DirectionMaps::transition;
+
+    // Evaluated at compile time: the table needs no runtime initialization
+    static_assert(transition(GridCellType::Bumper, Orientation::UpRight, Direction::Up) == Direction::Right, "");
+    static_assert(transition(GridCellType::Bumper, Orientation::DownRight, Direction::Left) == Direction::Up, "");
+    static_assert(transition(GridCellType::Tunnel, Orientation::Vertical, Direction::Left) == Direction::Right, "");
+    static_assert(transition(GridCellType::DirectionalBumper, Orientation::BottomLeft, Direction::Down) == Direction::Right, "");
+    static_assert(transition(GridCellType::Teleporter, Orientation::None, Direction::Down) == Direction::Down, "");
+
+    SECTION("ActivatedBumper deflects like a Bumper once on") {
+        for (Orientation orientation : {Orientation::UpRight, Orientation::DownRight}) {
+            for (Direction direction : {Direction::Up, Direction::Down, Direction::Left, Direction::Right}) {
+                REQUIRE(transition(GridCellType::ActivatedBumper, orientation, direction)
+                        == transition(GridCellType::Bumper, orientation, direction));
+            }
+        }
+    }
+
+    SECTION("Empty cells keep the direction") {
+        for (Direction direction : {Direction::Up, Direction::Down, Direction::Left, Direction::Right}) {
+            REQUIRE(transition(GridCellType::Empty, Orientation::None, direction) == direction);
+        }
+    }
+}
+
+TEST_CASE("Errors are reported as status codes", "[grid][bridge]") {
+    SECTION("Every cell type has a name") {
+        REQUIRE(GridCellTypeToString(GridCellType::Entry) == "Entry");
+        REQUIRE(GridCellTypeToString(GridCellType::Exit) == "Exit");
+        REQUIRE(GridCellTypeToString(static_cast<GridCellType>(42)) == "Unknown");
+    }
+
+    SECTION("Unusable configurations") {
+        std::vector<GridCellType> noTypes;
+        Grid grid(5, 1, 1, noTypes);
+        REQUIRE(grid.generateGrid() == GRID_STATUS_INVALID_ARGUMENT);
+
+        std::vector<GridCellType> objectTypes = {GridCellType::Bumper};
+        Grid tooSmall(2, 1, 1, objectTypes);
+        REQUIRE(tooSmall.generateGrid() == GRID_STATUS_INVALID_ARGUMENT);
+    }
+
+    SECTION("Impossible object counts give up instead of recursing forever") {
+        std::vector<GridCellType> objectTypes = {GridCellType::Bumper};
+        Grid grid(5, 50, 50, objectTypes);
+        REQUIRE(grid.generateGrid() == GRID_STATUS_GENERATION_FAILED);
+    }
+
+    SECTION("Bridge") {
+        const int types[] = {static_cast<int>(GridCellType::Bumper)};
+        const int notAnObject[] = {static_cast<int>(GridCellType::Exit)};
+        REQUIRE(Grid_Create(2, 1, 1, types, 1) == nullptr);
+        REQUIRE(Grid_Create(5, 2, 1, types, 1) == nullptr);
+        REQUIRE(Grid_Create(5, 1, 1, notAnObject, 1) == nullptr);
+        REQUIRE(Grid_GenerateGrid(nullptr) == GRID_STATUS_NULL_GRID);
+
+        // Values past the enum, some of them past the width of a type mask
+        for (int outOfRange : {-1, 10, 31, 32, 36, 255, 256}) {
+            const int unknown[] = {static_cast<int>(GridCellType::Bumper), outOfRange};
+            REQUIRE(Grid_Create(7, 2, 4, unknown + 1, 1) == nullptr);
+            REQUIRE(Grid_Create(7, 2, 4, unknown, 2) == nullptr);
+            REQUIRE_FALSE(isObjectCell(static_cast<GridCellType>(outOfRange)));
+        }
+
+        void* grid = Grid_Create(7, 2, 3, types, 1);
+        REQUIRE(grid != nullptr);
+        REQUIRE(Grid_GenerateGrid(grid) == GRID_STATUS_OK);
+        REQUIRE(Grid_GetCellType(grid, -1, 0) == 0);
+        REQUIRE(Grid_GetCellType(grid, 0, 0) == static_cast<int>(GridCellType::Empty));
+        REQUIRE(Grid_SetCell(grid, 3, 3, 36, static_cast<int>(Orientation::UpRight)) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(Grid_SetCell(grid, 3, 3, static_cast<int>(GridCellType::InBallPath), static_cast<int>(Orientation::None))
+                == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(Grid_SetCell(grid, 3, 3, static_cast<int>(GridCellType::Bumper), 9) == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(Grid_SetCell(grid, 3, 3, static_cast<int>(GridCellType::Bumper), 36) == GRID_STATUS_INVALID_ARGUMENT);
+        Grid_Destroy(grid);
+    }
+}
+
+TEST_CASE("Generation places only the configured object types", "[grid]") {
+    auto countObjects = [](const Grid& grid, GridCellType type) {
+        int count = 0;
+        for (const GridCell& cell : grid.gridCells) {
+            count += cell.type == type;
+        }
+        return count;
+    };
+
+    SECTION("Bumper only, as in the first levels") {
+        std::vector<GridCellType> objectTypes = {GridCellType::Bumper};
+        Grid grid(5, 2, 2, objectTypes);
+        for (int i = 0; i < 100; i++) {
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+            REQUIRE(countObjects(grid, GridCellType::Bumper) >= 2);
+            REQUIRE(countObjects(grid, GridCellType::Tunnel) == 0);
+            REQUIRE(countObjects(grid, GridCellType::Teleporter) == 0);
+        }
+    }
+
+    SECTION("Zero weight types are never placed") {
+        std::vector<GridCellType> objectTypes = {GridCellType::Bumper, GridCellType::Tunnel};
+        Grid grid(7, 4, 6, objectTypes, {1.0, 0.0});
+        for (int i = 0; i < 100; i++) {
+            REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+            REQUIRE(countObjects(grid, GridCellType::Tunnel) == 0);
+        }
+    }
+
+    SECTION("Unusable configurations are rejected") {
+        std::vector<GridCellType> objectTypes = {GridCellType::Bumper, GridCellType::Tunnel};
+        Grid grid(7, 4, 6, objectTypes);
+        REQUIRE_FALSE(grid.setObjectTypes(objectTypes, {1.0}));
+        REQUIRE_FALSE(grid.setObjectTypes(objectTypes, {-1.0, 2.0}));
+        REQUIRE_FALSE(grid.setObjectTypes({GridCellType::Exit}));
+        REQUIRE(grid.generateGrid() == GRID_STATUS_INVALID_ARGUMENT);
+        REQUIRE(grid.setObjectTypes(objectTypes));
+        REQUIRE(grid.generateGrid() == GRID_STATUS_OK);
+    }
+}
+
+TEST_CASE("Alias table samples by weight", "[alias]") {
+    AliasTable table;
+    REQUIRE(table.build({1.0, 3.0, 0.0, 4.0}));
+
+    std::mt19937 rng(1234);
+    std::vector<int> counts(4, 0);
+    const int draws = 80000;
+    for (int i = 0; i < draws; i++) {
+        counts[table.sample(rng)]++;
+    }
+    REQUIRE(counts[2] == 0);
+    REQUIRE(counts[0] == Approx(draws / 8.0).epsilon(0.05));
+    REQUIRE(counts[1] == Approx(draws * 3 / 8.0).epsilon(0.05));
+    REQUIRE(counts[3] == Approx(draws / 2.0).epsilon(0.05));
+
+    REQUIRE_FALSE(table.build({}));
+    REQUIRE_FALSE(table.build({0.0, 0.0}));
+}
@@ -0,0 +1,692 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "GridDispatch.h"
+#include "LevelEnumerator.h"
+#include "LevelPack.h"
+#include "Symmetry.h"
+
+// Offline level-pack compiler: generates levels for the Level.swift configs
+// on every core, drops duplicates, buckets them by difficulty and writes a
+// level pack (see LevelPack.h). Boards that are turns or flips of one another
+// are duplicates: each is keyed by its canonical form (see Symmetry.h).
+//
+// Work is cut into chunks of generation attempts, each seeded from (seed,
+// config, chunk), and finished chunks are committed to the pack in chunk
+// order. The pack is therefore the same for a seed whatever the thread
+// count. Every checkpoint writes the pack and FILE.state; --resume reloads
+// both and carries on from the first chunk not committed. Chunks the pack
+// already holds are regenerated and dropped as duplicates, so a run stopped
+// between the two writes resumes cleanly too. A checkpoint that cannot be
+// written stops the run, and the compiler exits with status 1.
+//
+// With --seeds each level is generated from a seed of its own and the pack
+// stores only that seed (see LevelPackFormat::CONFIG_SEEDS), which the game
+// regenerates the board from; duplicates are still found by the board.
+//
+// With --augment every new board is stored with its turned and flipped
+// variants (see symmetryVariants), up to eight levels per generated board,
+// all in the board's difficulty bucket. A variant costs a transform and an
+// encode, or a symmetry beside the seed, rather than a generation.
+//
+// With --enumerate the configs' boards are listed rather than generated (see
+// LevelEnumerator): every one, each stored with all its variants, so the pack
+// holds a config's whole level space. Chunks are enumeration jobs instead of
+// attempts and --grids and --chunk do not apply. Only configs of Bumpers,
+// Tunnels and DirectionalBumpers can be enumerated; by default the run takes
+// those of side MAX_ENUMERATED_SIDE or less, the 5x5 and 6x6 levels, whose
+// spaces are small enough to finish.
+
+namespace {
+    struct LevelConfig {
+        int size;
+        int minObjects;
+        int maxObjects;
+        std::vector<GridCellType> objectTypes;
+    };
+
+    // Mirrors Sources/PinballPanic/Models/Level.swift
+    const std::vector<LevelConfig> LEVELS = {
+        {5, 1, 1, {GridCellType::Bumper}},
+        {5, 2, 2, {GridCellType::Bumper}},
+        {6, 3, 4, {GridCellType::Bumper}},
+        {6, 3, 4, {GridCellType::Bumper, GridCellType::Tunnel}},
+        {7, 4, 6, {GridCellType::Bumper, GridCellType::Tunnel}},
+        {10, 6, 7, {GridCellType::Bumper, GridCellType::Tunnel, GridCellType::Teleporter}},
+        {10, 7, 8, {GridCellType::Bumper, GridCellType::Tunnel, GridCellType::Teleporter}},
+        {10, 7, 9, {GridCellType::Bumper, GridCellType::Tunnel, GridCellType::Teleporter,
+                    GridCellType::ActivatedBumper}},
+        {10, 8, 10, {GridCellType::Bumper, GridCellType::Tunnel, GridCellType::Teleporter,
+                     GridCellType::ActivatedBumper}},
+        {10, 10, 12, {GridCellType::Bumper, GridCellType::Tunnel, GridCellType::Teleporter,
+                      GridCellType::ActivatedBumper, GridCellType::DirectionalBumper}},
+        {10, 11, 13, {GridCellType::Bumper, GridCellType::Tunnel, GridCellType::Teleporter,
+                      GridCellType::ActivatedBumper, GridCellType::DirectionalBumper}},
+    };
+
+    // Levels are bucketed by the turns the ball takes, capped here
+    constexpr std::uint32_t DIFFICULTY_BUCKETS = 16;
+
+    // Largest side --enumerate takes without --configs
+    constexpr int MAX_ENUMERATED_SIDE = 6;
+
+    struct Options {
+        std::string out;
+        std::uint64_t grids = 100000;        // Generation attempts per config
+        std::uint64_t seed = 1;
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        std::uint64_t chunk = 4096;          // Attempts per chunk
+        std::vector<int> configs;            // Indexes into LEVELS
+        double checkpointSeconds = 60;
+        bool resume = false;
+        bool seeds = false;                  // Store levels as their seeds
+        bool augment = false;                // Store every variant of a board
+        bool enumerate = false;              // List every board rather than generate
+    };
+
+    void printUsage() {
+        std::fprintf(stderr,
+            "usage: PackCompiler --out FILE [--grids N] [--seed S] [--threads T] [--chunk C]\n"
+            "                    [--configs I,J,...] [--checkpoint SECONDS] [--seeds] [--augment]\n"
+            "                    [--enumerate] [--resume]\n"
+            "  --grids       generation attempts per config (default 100000)\n"
+            "  --configs     Level.swift indexes to generate (default all %zu)\n"
+            "  --checkpoint  seconds between pack and state writes (default 60)\n"
+            "  --seeds       store each level as the seed that regenerates it\n"
+            "  --augment     store the turned and flipped variants of each board too\n"
+            "  --enumerate   store every board of the configs (default those up to %dx%d)\n"
+            "  --resume      continue the run recorded in FILE.state\n", LEVELS.size(), MAX_ENUMERATED_SIDE,
+            MAX_ENUMERATED_SIDE);
+    }
+
+    bool parseUnsigned(const char* text, std::uint64_t& value) {
+        char* end = nullptr;
+        value = std::strtoull(text, &end, 10);
+        return text[0] != '\0' && text[0] != '-' && *end == '\0';
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            const std::string flag = argv[i];
+            if (flag == "--resume") {
+                options.resume = true;
+                continue;
+            }
+            if (flag == "--seeds") {
+                options.seeds = true;
+                continue;
+            }
+            if (flag == "--augment") {
+                options.augment = true;
+                continue;
+            }
+            if (flag == "--enumerate") {
+                options.enumerate = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                return false;
+            }
+            const char* value = argv[++i];
+            std::uint64_t number = 0;
+            if (flag == "--out") {
+                options.out = value;
+            } else if (flag == "--grids" && parseUnsigned(value, number)) {
+                options.grids = number;
+            } else if (flag == "--seed" && parseUnsigned(value, number)) {
+                options.seed = number;
+            } else if (flag == "--threads" && parseUnsigned(value, number) && number > 0 && number <= 1024) {
+                options.threads = static_cast<unsigned>(number);
+            } else if (flag == "--chunk" && parseUnsigned(value, number) && number > 0) {
+                options.chunk = number;
+            } else if (flag == "--checkpoint" && parseUnsigned(value, number) && number > 0) {
+                options.checkpointSeconds = static_cast<double>(number);
+            } else if (flag == "--configs") {
+                for (const char* next = value; *next != '\0';) {
+                    char* end = nullptr;
+                    const long index = std::strtol(next, &end, 10);
+                    if (end == next || index < 0 || index >= static_cast<long>(LEVELS.size())
+                        || (*end != ',' && *end != '\0')) {
+                        return false;
+                    }
+                    options.configs.push_back(static_cast<int>(index));
+                    next = *end == ',' ? end + 1 : end;
+                }
+            } else {
+                return false;
+            }
+        }
+        if (options.configs.empty()) {
+            for (int i = 0; i < static_cast<int>(LEVELS.size()); i++) {
+                if (!options.enumerate || LEVELS[i].size <= MAX_ENUMERATED_SIDE) {
+                    options.configs.push_back(i);
+                }
+            }
+        }
+        // Enumerated boards have no seeds, and come with their variants anyway
+        if (options.enumerate && options.seeds) {
+            return false;
+        }
+        options.augment = options.augment || options.enumerate;
+        std::sort(options.configs.begin(), options.configs.end());
+        options.configs.erase(std::unique(options.configs.begin(), options.configs.end()), options.configs.end());
+        return !options.out.empty();
+    }
+
+    std::uint64_t splitmix64(std::uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    std::uint32_t chunkSeed(std::uint64_t seed, int config, std::uint64_t chunk) {
+        return static_cast<std::uint32_t>(splitmix64(splitmix64(seed ^ static_cast<std::uint64_t>(config)) ^ chunk));
+    }
+
+    // Seed of one level in --seeds runs
+    std::uint32_t levelSeed(std::uint64_t seed, int config, std::uint64_t chunk, std::uint64_t attempt) {
+        return static_cast<std::uint32_t>(splitmix64(chunkSeed(seed, config, chunk) ^ (attempt << 32)));
+    }
+
+    // Turns the ball takes on the way out
+    template <typename Engine>
+    std::uint32_t difficultyOf(const Engine& grid) {
+        return std::min(grid.pathMetrics.directionChanges, DIFFICULTY_BUCKETS - 1);
+    }
+
+    LevelPackFormat::Config configKey(const LevelConfig& level) {
+        LevelPackFormat::Config config = {};
+        config.side = static_cast<std::uint32_t>(level.size);
+        config.minObjects = static_cast<std::uint32_t>(level.minObjects);
+        config.maxObjects = static_cast<std::uint32_t>(level.maxObjects);
+        config.objectTypeMask = LevelPackFormat::objectTypeMask(level.objectTypes);
+        return config;
+    }
+
+    // Boards one chunk generated and the levels they gave, in generation
+    // order; records or seeds depending on the run
+    struct ChunkResult {
+        // Per board
+        std::vector<std::uint64_t> hashes;
+        std::vector<std::uint32_t> difficulties;
+        std::vector<std::uint8_t> variants;     // Levels the board gave, 1 without --augment
+        // Per level
+        std::vector<std::uint8_t> records;
+        std::vector<std::uint32_t> seeds;
+        std::vector<Symmetry> symmetries;
+    };
+
+    // Generates a board on engine, adding it to result as one level. The
+    // record is kept only when the run stores boards; the board's canonical
+    // form is always taken, so --seeds runs drop duplicates by board too.
+    template <typename Engine>
+    bool generateLevel(Engine& engine, bool keepRecord, std::vector<std::uint8_t>& scratch, ChunkResult& result) {
+        if (engine.generateGrid() != GRID_STATUS_OK) {
+            return false;
+        }
+        const std::size_t recordSize = LevelPackFormat::recordSize(static_cast<std::size_t>(engine.side()));
+        std::vector<std::uint8_t>& records = keepRecord ? result.records : scratch;
+        const std::size_t start = keepRecord ? records.size() : 0;
+        records.resize(start + recordSize);
+        CanonicalForm form;
+        if (LevelPackFormat::encodeLevel(engine, records.data() + start) != GRID_STATUS_OK
+            || !canonicalForm(engine, form)) {
+            records.resize(start);
+            return false;
+        }
+        result.hashes.push_back(form.hash);
+        result.difficulties.push_back(difficultyOf(engine));
+        result.variants.push_back(1);
+        result.symmetries.push_back(Symmetry::Identity);
+        return true;
+    }
+
+    // Adds the other variants of the board generateLevel just added as more
+    // levels of it, transformed on variant when the run stores boards
+    template <typename Engine>
+    void addVariants(const Engine& engine, Engine& variant, bool keepRecord, ChunkResult& result) {
+        Symmetry variants[SYMMETRY_COUNT];
+        const int count = symmetryVariants(engine, variants);
+        const std::size_t recordSize = LevelPackFormat::recordSize(static_cast<std::size_t>(engine.side()));
+        for (int i = 1; i < count; i++) {
+            if (keepRecord) {
+                const std::size_t start = result.records.size();
+                result.records.resize(start + recordSize);
+                if (variant.transformFrom(engine, variants[i]) != GRID_STATUS_OK
+                    || LevelPackFormat::encodeLevel(variant, result.records.data() + start) != GRID_STATUS_OK) {
+                    result.records.resize(start);
+                    continue;
+                }
+            }
+            result.symmetries.push_back(variants[i]);
+            result.variants.back()++;
+        }
+    }
+
+    // Runs one enumeration job on engine. Each board found is added as a
+    // level, with its variants as more, if it is its canonical form: the
+    // other boards of its class are among those variants or, entering at the
+    // same cell, are found by the job too and dropped here.
+    template <typename Engine>
+    void enumerateLevels(const LevelEnumerator& enumerator, const LevelEnumerator::Job& job, Engine& engine,
+                         Engine& variant, ChunkResult& result) {
+        const std::size_t recordSize = LevelPackFormat::recordSize(static_cast<std::size_t>(engine.side()));
+        enumerator.run(job, [&](CellIndex entry, const std::vector<BoardObject>& objects) {
+            CanonicalForm form;
+            if (engine.loadBoard(entry, objects.data(), objects.size()) != GRID_STATUS_OK
+                || !canonicalForm(engine, form) || form.symmetry != Symmetry::Identity) {
+                return;
+            }
+            const std::size_t start = result.records.size();
+            result.records.resize(start + recordSize);
+            if (LevelPackFormat::encodeLevel(engine, result.records.data() + start) != GRID_STATUS_OK) {
+                result.records.resize(start);
+                return;
+            }
+            result.hashes.push_back(form.hash);
+            result.difficulties.push_back(difficultyOf(engine));
+            result.variants.push_back(1);
+            result.symmetries.push_back(Symmetry::Identity);
+            addVariants(engine, variant, true, result);
+        });
+    }
+
+    // Set by SIGINT or SIGTERM: workers stop after their chunk and the run
+    // ends with a checkpoint
+    std::atomic<bool> interrupted{false};
+    static_assert(std::atomic<bool>::is_always_lock_free, "set from a signal handler");
+
+    void onInterrupt(int) {
+        interrupted = true;
+    }
+
+    class Compiler {
+    public:
+        explicit Compiler(const Options& options);
+
+        // Configs --enumerate cannot list, as a message; empty if none
+        std::string unenumerable() const;
+        bool resume();
+        // Runs to the last chunk or an interruption; false if a checkpoint
+        // failed, which also stops the run
+        bool run();
+
+    private:
+        const Options& options;
+        // Chunks of each config start at firstChunk[slot]; the last entry is
+        // the total
+        std::vector<std::uint64_t> firstChunk;
+        std::uint64_t totalChunks = 0;
+        std::vector<LevelEnumerator> enumerators;     // Per slot, with --enumerate
+
+        std::atomic<std::uint64_t> nextChunk{0};
+        std::atomic<std::uint64_t> generated{0};
+        std::atomic<unsigned> workersLeft{0};
+
+        // Guarded by mutex
+        std::mutex mutex;
+        std::condition_variable workersDone;
+        std::map<std::uint64_t, ChunkResult> pending;
+        std::uint64_t committed = 0;
+        std::uint64_t committedGrids = 0;
+        std::uint64_t acceptedGrids = 0;     // New boards this run; each gives one or more levels
+        std::uint64_t accepted = 0;
+        std::uint64_t acceptedBytes = 0;
+        std::vector<std::unordered_set<std::uint64_t>> seen;
+        LevelPackWriter writer;
+
+        std::string statePath() const { return options.out + ".state"; }
+        bool sameRun(std::uint64_t seed, std::uint64_t grids, std::uint64_t chunk, const std::string& configs,
+                     bool seeds, bool augment, bool enumerate) const;
+        // Index into options.configs of the config a chunk belongs to
+        std::size_t slotOf(std::uint64_t chunk) const {
+            return static_cast<std::size_t>(std::upper_bound(firstChunk.begin(), firstChunk.end(), chunk)
+                                            - firstChunk.begin() - 1);
+        }
+        std::string configList() const;
+        void work();
+        void commit(std::uint64_t chunk, ChunkResult&& result);
+        bool checkpoint();
+    };
+
+    Compiler::Compiler(const Options& options) : options(options), seen(options.configs.size()) {
+        firstChunk.push_back(0);
+        for (int config : options.configs) {
+            std::uint64_t chunks = (options.grids + options.chunk - 1) / options.chunk;
+            if (options.enumerate) {
+                const LevelConfig& level = LEVELS[config];
+                enumerators.emplace_back(level.size, level.minObjects, level.maxObjects, level.objectTypes);
+                chunks = enumerators.back().jobs().size();
+            }
+            firstChunk.push_back(firstChunk.back() + chunks);
+        }
+        totalChunks = firstChunk.back();
+    }
+
+    std::string Compiler::unenumerable() const {
+        std::string list;
+        for (std::size_t slot = 0; slot < enumerators.size(); slot++) {
+            if (enumerators[slot].status() != GRID_STATUS_OK) {
+                list += (list.empty() ? "" : ",") + std::to_string(options.configs[slot]);
+            }
+        }
+        return list;
+    }
+
+    std::string Compiler::configList() const {
+        std::string list;
+        for (int config : options.configs) {
+            list += (list.empty() ? "" : ",") + std::to_string(config);
+        }
+        return list;
+    }
+
+    bool Compiler::sameRun(std::uint64_t seed, std::uint64_t grids, std::uint64_t chunk,
+                           const std::string& configs, bool seeds, bool augment, bool enumerate) const {
+        return seed == options.seed && grids == options.grids && chunk == options.chunk && configs == configList()
+            && seeds == options.seeds && augment == options.augment && enumerate == options.enumerate;
+    }
+
+    // Reloads the levels and progress of an earlier run with the same options
+    bool Compiler::resume() {
+        std::FILE* state = std::fopen(statePath().c_str(), "r");
+        if (!state) {
+            std::fprintf(stderr, "PackCompiler: no %s to resume from\n", statePath().c_str());
+            return false;
+        }
+        unsigned long long seed = 0, grids = 0, chunk = 0, done = 0;
+        char configs[1024] = {};
+        int seeds = 0;
+        int augment = 0;
+        int enumerate = 0;
+        const int fields = std::fscanf(state,
+                                       "seed %llu grids %llu chunk %llu configs %1023s seeds %d augment %d "
+                                       "enumerate %d committed %llu",
+                                       &seed, &grids, &chunk, configs, &seeds, &augment, &enumerate, &done);
+        std::fclose(state);
+        if (fields != 8 || !sameRun(seed, grids, chunk, configs, seeds != 0, augment != 0, enumerate != 0)
+            || done > totalChunks) {
+            std::fprintf(stderr, "PackCompiler: %s records a different run\n", statePath().c_str());
+            return false;
+        }
+
+        LevelPack pack;
+        if (pack.open(options.out.c_str()) != GRID_STATUS_OK) {
+            std::fprintf(stderr, "PackCompiler: cannot read %s\n", options.out.c_str());
+            return false;
+        }
+        for (int config = 0; config < pack.configCount(); config++) {
+            const LevelPackFormat::Config& filed = pack.config(config);
+            int slot = -1;
+            for (std::size_t i = 0; i < options.configs.size(); i++) {
+                const LevelPackFormat::Config key = configKey(LEVELS[options.configs[i]]);
+                if (key.side == filed.side && key.minObjects == filed.minObjects
+                    && key.maxObjects == filed.maxObjects && key.objectTypeMask == filed.objectTypeMask) {
+                    slot = static_cast<int>(i);
+                }
+            }
+            if (slot < 0) {
+                std::fprintf(stderr, "PackCompiler: %s holds a config this run does not generate\n",
+                             options.out.c_str());
+                return false;
+            }
+            // Seeds are regenerated to find their boards' hashes, which
+            // are the same for every variant of a board
+            const LevelConfig& source = LEVELS[options.configs[slot]];
+            AnyGrid grid = makeGrid(source.size, source.minObjects, source.maxObjects, source.objectTypes);
+            std::vector<std::uint8_t> scratch;
+            for (int bucket = 0; bucket < pack.bucketCount(config); bucket++) {
+                for (std::uint64_t level = 0; level < pack.levelCount(config, bucket); level++) {
+                    std::uint32_t seed = 0;
+                    Symmetry symmetry = Symmetry::Identity;
+                    GridStatus status;
+                    if (pack.levelSeed(config, bucket, level, seed, symmetry)) {
+                        ChunkResult regenerated;
+                        std::visit([&](auto& engine) {
+                            engine.seed(seed);
+                            generateLevel(engine, false, scratch, regenerated);
+                        }, grid);
+                        if (regenerated.hashes.empty()) {
+                            return false;
+                        }
+                        seen[slot].insert(regenerated.hashes[0]);
+                        status = writer.addSeed(filed, static_cast<std::uint32_t>(bucket), seed, symmetry);
+                    } else {
+                        const LevelPackFormat::LevelHeader* record = pack.level(config, bucket, level);
+                        CanonicalForm form;
+                        if (!record || !canonicalForm(PackLevel(record), form)) {
+                            return false;
+                        }
+                        seen[slot].insert(form.hash);
+                        status = writer.addRecord(filed, static_cast<std::uint32_t>(bucket),
+                                                  reinterpret_cast<const std::uint8_t*>(record));
+                    }
+                    if (status != GRID_STATUS_OK) {
+                        std::fprintf(stderr, "PackCompiler: %s holds a level that cannot be kept\n",
+                                     options.out.c_str());
+                        return false;
+                    }
+                    accepted++;
+                    acceptedBytes += filed.recordSize;
+                }
+            }
+        }
+        committed = done;
+        nextChunk = done;
+        std::printf("resuming at chunk %llu of %llu with %llu levels\n", done,
+                    static_cast<unsigned long long>(totalChunks), static_cast<unsigned long long>(accepted));
+        return true;
+    }
+
+    void Compiler::work() {
+        while (!interrupted) {
+            const std::uint64_t chunk = nextChunk.fetch_add(1);
+            if (chunk >= totalChunks) {
+                break;
+            }
+            const std::size_t slot = slotOf(chunk);
+            const int config = options.configs[slot];
+            const std::uint64_t index = chunk - firstChunk[slot];
+            const LevelConfig& level = LEVELS[config];
+
+            ChunkResult result;
+            AnyGrid grid = makeGrid(level.size, level.minObjects, level.maxObjects, level.objectTypes);
+            std::vector<std::uint8_t> scratch;
+            std::visit([&](auto& engine) {
+                auto variant = engine;
+                if (options.enumerate) {
+                    enumerateLevels(enumerators[slot], enumerators[slot].jobs()[index], engine, variant, result);
+                    return;
+                }
+                const std::uint64_t attempts = std::min(options.chunk, options.grids - index * options.chunk);
+                engine.seed(chunkSeed(options.seed, config, index));
+                for (std::uint64_t attempt = 0; attempt < attempts; attempt++) {
+                    std::uint32_t seed = 0;
+                    if (options.seeds) {
+                        seed = levelSeed(options.seed, config, index, attempt);
+                        engine.seed(seed);
+                    }
+                    if (!generateLevel(engine, !options.seeds, scratch, result)) {
+                        continue;
+                    }
+                    if (options.augment) {
+                        addVariants(engine, variant, !options.seeds, result);
+                    }
+                    if (options.seeds) {
+                        result.seeds.insert(result.seeds.end(), result.variants.back(), seed);
+                    }
+                }
+            }, grid);
+            generated.fetch_add(result.hashes.size(), std::memory_order_relaxed);
+            commit(chunk, std::move(result));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--workersLeft == 0) {
+            workersDone.notify_all();
+        }
+    }
+
+    // Chunks finish in any order but are added in chunk order
+    void Compiler::commit(std::uint64_t chunk, ChunkResult&& result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.emplace(chunk, std::move(result));
+        for (auto next = pending.find(committed); next != pending.end(); next = pending.find(committed)) {
+            const std::size_t slot = slotOf(committed);
+            const LevelPackFormat::Config key = configKey(LEVELS[options.configs[slot]]);
+            const std::size_t recordSize = options.seeds ? sizeof(LevelPackFormat::SeedRecord)
+                                                         : LevelPackFormat::recordSize(key.side);
+            const ChunkResult& levels = next->second;
+            std::size_t level = 0;
+            for (std::size_t i = 0; i < levels.hashes.size(); level += levels.variants[i], i++) {
+                if (!seen[slot].insert(levels.hashes[i]).second) {
+                    continue;
+                }
+                bool added = false;
+                for (std::size_t v = level; v < level + levels.variants[i]; v++) {
+                    const GridStatus status = options.seeds
+                        ? writer.addSeed(key, levels.difficulties[i], levels.seeds[v], levels.symmetries[v])
+                        : writer.addRecord(key, levels.difficulties[i], levels.records.data() + v * recordSize);
+                    // Only a level the writer kept counts towards the pack
+                    if (status != GRID_STATUS_OK) {
+                        continue;
+                    }
+                    added = true;
+                    accepted++;
+                    acceptedBytes += recordSize;
+                }
+                if (added) {
+                    acceptedGrids++;
+                }
+            }
+            committedGrids += levels.hashes.size();
+            pending.erase(next);
+            committed++;
+        }
+    }
+
+    // Writes the pack, then the state naming the chunks it holds. Called
+    // with mutex held.
+    bool Compiler::checkpoint() {
+        if (writer.write(options.out.c_str()) != GRID_STATUS_OK) {
+            std::fprintf(stderr, "PackCompiler: cannot write %s\n", options.out.c_str());
+            return false;
+        }
+        const std::string partial = statePath() + ".part";
+        std::FILE* state = std::fopen(partial.c_str(), "w");
+        if (!state) {
+            std::fprintf(stderr, "PackCompiler: cannot write %s\n", partial.c_str());
+            return false;
+        }
+        std::fprintf(state,
+                     "seed %llu grids %llu chunk %llu configs %s seeds %d augment %d enumerate %d committed %llu\n",
+                     static_cast<unsigned long long>(options.seed), static_cast<unsigned long long>(options.grids),
+                     static_cast<unsigned long long>(options.chunk), configList().c_str(), options.seeds ? 1 : 0,
+                     options.augment ? 1 : 0, options.enumerate ? 1 : 0, static_cast<unsigned long long>(committed));
+        if (std::fclose(state) != 0 || std::rename(partial.c_str(), statePath().c_str()) != 0) {
+            std::fprintf(stderr, "PackCompiler: cannot write %s\n", statePath().c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool Compiler::run() {
+        const auto start = std::chrono::steady_clock::now();
+        auto lastCheckpoint = start;
+        const std::uint64_t startAccepted = accepted;
+        const std::uint64_t startBytes = acceptedBytes;
+
+        std::vector<std::thread> workers;
+        workersLeft = options.threads;
+        for (unsigned i = 0; i < options.threads; i++) {
+            workers.emplace_back([this] { work(); });
+        }
+
+        // Report once a second and checkpoint on schedule until the workers
+        // run out of chunks
+        std::unique_lock<std::mutex> lock(mutex);
+        bool finished = false;
+        bool checkpointFailed = false;
+        while (!finished) {
+            finished = workersDone.wait_for(lock, std::chrono::seconds(1), [this] { return workersLeft == 0; });
+            const auto now = std::chrono::steady_clock::now();
+            const double seconds = std::chrono::duration<double>(now - start).count();
+            std::printf("[%8.1fs] chunk %llu/%llu  %12llu grids %10.0f grids/s  %12llu levels %8.2f MB/s\n",
+                        seconds, static_cast<unsigned long long>(committed),
+                        static_cast<unsigned long long>(totalChunks),
+                        static_cast<unsigned long long>(generated.load()),
+                        static_cast<double>(generated.load()) / seconds,
+                        static_cast<unsigned long long>(accepted),
+                        static_cast<double>(acceptedBytes - startBytes) / seconds / 1e6);
+            std::fflush(stdout);
+            if (!finished && std::chrono::duration<double>(now - lastCheckpoint).count() >= options.checkpointSeconds) {
+                // A disk that cannot take this checkpoint is unlikely to take
+                // the next; stop and try once more at the end
+                if (!checkpoint()) {
+                    checkpointFailed = true;
+                    interrupted = true;
+                }
+                lastCheckpoint = std::chrono::steady_clock::now();
+            }
+        }
+        lock.unlock();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        lock.lock();
+        if (!checkpoint()) {
+            std::fprintf(stderr, "PackCompiler: %s was not written\n", options.out.c_str());
+            return false;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%s %s: %llu levels (%llu new, %llu duplicates dropped) in %.1fs, %.0f grids/s, "
+                    "%.0f new levels/s\n",
+                    interrupted ? "stopped, resume with --resume;" : "wrote", options.out.c_str(),
+                    static_cast<unsigned long long>(accepted),
+                    static_cast<unsigned long long>(accepted - startAccepted),
+                    static_cast<unsigned long long>(committedGrids - acceptedGrids),
+                    seconds, static_cast<double>(generated.load()) / seconds,
+                    static_cast<double>(accepted - startAccepted) / seconds);
+        if (checkpointFailed) {
+            std::fprintf(stderr, "PackCompiler: stopped early after a failed checkpoint\n");
+        }
+        return !checkpointFailed;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    Compiler compiler(options);
+    const std::string unenumerable = compiler.unenumerable();
+    if (!unenumerable.empty()) {
+        std::fprintf(stderr, "PackCompiler: configs %s cannot be enumerated\n", unenumerable.c_str());
+        return 2;
+    }
+    if (options.resume && !compiler.resume()) {
+        return 1;
+    }
+    std::signal(SIGINT, onInterrupt);
+    std::signal(SIGTERM, onInterrupt);
+    if (!compiler.run()) {
+        return 1;
+    }
+    return interrupted ? 130 : 0;
+}